@@ -0,0 +1,81 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#ifndef TWOBULLS_ABOUTDESCRIPTION_H
+#define TWOBULLS_ABOUTDESCRIPTION_H
+
+#include <string>
+#include <vector>
+
+// Forward Declarations
+namespace ajn {
+	class AboutData;
+}
+
+namespace twobulls {
+
+// A single field of the About XML; 'mLanguage' is empty unless the field had a lang attribute.
+struct AboutField {
+	AboutField(const std::string& name = std::string(), const std::string& language = std::string(), const std::string& value = std::string()) :
+		mName(name)
+		,mLanguage(language)
+		,mValue(value)
+	{};
+	std::string mName;
+	std::string mLanguage;
+	std::string mValue;
+};
+
+// The About XML, parsed once into its fields so that the source text doesn't need to be kept around, or parsed again
+//	by ajn::AboutData::CreateFromXml.
+class TBAboutDescription {
+	public:
+		TBAboutDescription();
+
+		// Parses the About XML. Returns false if it isn't an About element with an AppName and DefaultLanguage.
+		bool Parse(const char* aboutXML);
+
+		// Sets each field on 'aboutData', which should have been constructed with the default language. This does what
+		//	CreateFromXml would have with the same XML.
+		bool Apply(ajn::AboutData& aboutData) const;
+
+		// As above, for just 'fields', eg. the result of Diff, on an AboutData that the rest were already applied to.
+		bool Apply(ajn::AboutData& aboutData, const std::vector< AboutField >& fields) const;
+
+		// Sets the value of a field, replacing the field of the same name and language if there is one. A field with no
+		//	language matches one in the default language.
+		void SetField(const AboutField& field);
+
+		// Returns the fields that are missing from, or have a different value in, 'previous'.
+		std::vector< AboutField > Diff(const TBAboutDescription& previous) const;
+
+		const std::string& GetApplicationName() const { return mApplicationName; };
+		const std::string& GetLanguage() const { return mLanguage; };
+		const std::vector< AboutField >& GetFields() const { return mFields; };
+
+	protected:
+		bool IsSameField(const AboutField& field, const std::string& name, const std::string& language) const;
+
+		std::string mApplicationName;
+		std::string mLanguage;
+		std::vector< AboutField > mFields;
+};
+
+} // namespace twobulls
+
+#endif // TWOBULLS_ABOUTDESCRIPTION_H
@@ -0,0 +1,125 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#ifndef TWOBULLS_ACTIONCALLABLE_H
+#define TWOBULLS_ACTIONCALLABLE_H
+
+#include <new>
+#include <stddef.h>
+#include <type_traits>
+
+namespace twobulls {
+
+// A copy of a callable of any type, eg. a lambda or a std::function, for the handler of an Action. Callables that fit
+//	in INLINE_SIZE bytes are kept in the ActionCallable itself, so a lambda capturing a few pointers costs no allocation
+//	at all; larger ones are copied to the heap once, when they are stored. Calling one never allocates.
+//
+// The type isn't kept, so whoever calls Get has to know it; TypedActionDescriptor pairs each callable with an invoker
+//	instantiated for its type.
+class ActionCallable {
+	public:
+		static const size_t INLINE_SIZE = 4 * sizeof(void*);
+
+		ActionCallable() :
+			mOperations(NULL)
+		{};
+
+		template< typename Function >
+		explicit ActionCallable(const Function& function) :
+			mOperations(Operations< Function >::GetTable())
+		{
+			Operations< Function >::Construct(&mStorage, function);
+		};
+
+		ActionCallable(const ActionCallable& other) :
+			mOperations(other.mOperations)
+		{
+			if(mOperations != NULL) {
+				mOperations->mCopy(&mStorage, &other.mStorage);
+			}
+		};
+
+		ActionCallable& operator=(const ActionCallable& other) {
+			if(this != &other) {
+				Reset();
+				if(other.mOperations != NULL) {
+					other.mOperations->mCopy(&mStorage, &other.mStorage);
+					mOperations = other.mOperations;
+				}
+			}
+			return *this;
+		};
+
+		~ActionCallable() {
+			Reset();
+		};
+
+		bool IsEmpty() const { return mOperations == NULL; };
+
+		// Returns the callable, which must have been stored as a 'Function'.
+		template< typename Function >
+		const Function& Get() const {
+			return *Operations< Function >::Pointer(&mStorage);
+		};
+
+	private:
+		typedef typename std::aligned_storage< INLINE_SIZE >::type Storage;
+
+		struct Table {
+			void (*mCopy)(void* to, const void* from);
+			void (*mDestroy)(void* storage);
+		};
+
+		template< typename Function, bool Inline = sizeof(Function) <= INLINE_SIZE && std::alignment_of< Function >::value <= std::alignment_of< Storage >::value >
+		struct Operations {
+			static const Function* Pointer(const void* storage) { return static_cast< const Function* >(storage); };
+			static void Construct(void* storage, const Function& function) { new(storage) Function(function); };
+			static void Copy(void* to, const void* from) { Construct(to, *Pointer(from)); };
+			static void Destroy(void* storage) { static_cast< Function* >(storage)->~Function(); };
+			static const Table* GetTable() {
+				static const Table table = { &Copy, &Destroy };
+				return &table;
+			};
+		};
+
+		template< typename Function >
+		struct Operations< Function, false > {
+			static const Function* Pointer(const void* storage) { return *static_cast< Function* const* >(storage); };
+			static void Construct(void* storage, const Function& function) { *static_cast< Function** >(storage) = new Function(function); };
+			static void Copy(void* to, const void* from) { Construct(to, *Pointer(from)); };
+			static void Destroy(void* storage) { delete *static_cast< Function** >(storage); };
+			static const Table* GetTable() {
+				static const Table table = { &Copy, &Destroy };
+				return &table;
+			};
+		};
+
+		void Reset() {
+			if(mOperations != NULL) {
+				mOperations->mDestroy(&mStorage);
+				mOperations = NULL;
+			}
+		};
+
+		Storage mStorage;
+		const Table* mOperations;
+};
+
+} // namespace twobulls
+
+#endif // TWOBULLS_ACTIONCALLABLE_H
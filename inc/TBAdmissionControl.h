@@ -0,0 +1,111 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#ifndef TWOBULLS_ADMISSIONCONTROL_H
+#define TWOBULLS_ADMISSIONCONTROL_H
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+
+#include <alljoyn/Session.h>
+
+namespace twobulls {
+
+// Decides whether a joiner is let in, on top of the session port matching. Return false to reject it.
+typedef std::function< bool(const char* joiner, const ajn::SessionOpts& opts) > AdmissionPredicate;
+
+// Configuration of the admission control in AcceptSessionJoiner. The defaults admit everyone, as before.
+struct AdmissionOptions {
+	//	'maxMembers' is the most joiners in session at once. Each member of a multipoint session counts, so it limits
+	//	 members rather than sessions. Zero is unlimited.
+	//	'joinRate' is the rate, per second, at which join attempts from any single joiner are refilled, and
+	//	 'joinBurst' how many it can make back to back. A 'joinRate' of zero is unlimited.
+	//	'predicate' is an allow/deny check consulted after the limits.
+	AdmissionOptions(size_t maxMembers = 0, double joinRate = 0, double joinBurst = 5, const AdmissionPredicate& predicate = AdmissionPredicate()) :
+		mMaxMembers(maxMembers)
+		,mJoinRate(joinRate)
+		,mJoinBurst(joinBurst)
+		,mPredicate(predicate)
+	{};
+	size_t mMaxMembers;
+	double mJoinRate;
+	double mJoinBurst;
+	AdmissionPredicate mPredicate;
+};
+
+// How many joiners were admitted, and why the others were not.
+struct AdmissionStats {
+	AdmissionStats() :
+		mAccepted(0)
+		,mRejectedPort(0)
+		,mRejectedCapacity(0)
+		,mRejectedRate(0)
+		,mRejectedPredicate(0)
+	{};
+	uint64_t mAccepted;
+	uint64_t mRejectedPort;
+	uint64_t mRejectedCapacity;
+	uint64_t mRejectedRate;
+	uint64_t mRejectedPredicate;
+};
+
+// Admission decisions for a session port. Join attempts are rate limited by a token bucket per joiner; the buckets
+//	live in a fixed table indexed by a hash of the joiner's name, so a decision costs the same however many joiners
+//	there have been, at the price of joiners that collide sharing a bucket.
+class TBAdmissionControl {
+	public:
+		TBAdmissionControl();
+
+		void SetOptions(const AdmissionOptions& options);
+
+		// Returns whether to accept 'joiner', given that 'memberCount' joiners are in session already. A joiner to
+		//	the wrong port is only counted.
+		bool Admit(bool portMatches, const char* joiner, const ajn::SessionOpts& opts, size_t memberCount);
+
+		AdmissionStats GetStats() const;
+
+	protected:
+		enum { BUCKET_COUNT = 256 };
+
+		struct Bucket {
+			Bucket() :
+				mTokens(0)
+				,mRefilledNs(0)
+			{};
+			double mTokens;
+			uint64_t mRefilledNs;
+		};
+
+		bool TakeToken(const char* joiner);
+
+		std::mutex mMutex;
+		AdmissionOptions mOptions;
+		Bucket mBuckets[BUCKET_COUNT];
+
+		std::atomic< uint64_t > mAccepted;
+		std::atomic< uint64_t > mRejectedPort;
+		std::atomic< uint64_t > mRejectedCapacity;
+		std::atomic< uint64_t > mRejectedRate;
+		std::atomic< uint64_t > mRejectedPredicate;
+};
+
+} // namespace twobulls
+
+#endif // TWOBULLS_ADMISSIONCONTROL_H
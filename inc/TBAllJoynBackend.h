@@ -0,0 +1,157 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#ifndef TWOBULLS_ALLJOYNBACKEND_H
+#define TWOBULLS_ALLJOYNBACKEND_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <alljoyn/BusObject.h>
+#include <alljoyn/SessionListener.h>
+#include <alljoyn/SessionPortListener.h>
+
+#include "TBBusBackend.h"
+
+// Forward Declarations
+namespace ajn {
+	class AboutData;
+	class AboutObj;
+	class BusAttachment;
+}
+
+namespace twobulls {
+
+// The TBBusBackend on an AllJoyn router. It owns a BusAttachment, connected while any object is connected to it, and
+//	registers a BusObject for each object that hands the object's traffic on to its TBBusEndpoint.
+class TBAllJoynBackend :
+	public TBBusBackend
+{
+	public:
+		TBAllJoynBackend();
+		virtual ~TBAllJoynBackend();
+
+		// From TBBusBackend
+		bool Connect(const std::string& applicationName);
+		void Disconnect();
+		bool DefineInterface(const BusInterface& definition);
+		bool RegisterObject(const std::string& path, const std::string& interfaceName, TBBusEndpoint& endpoint);
+		void UnregisterObject(const std::string& path);
+		bool BindSessionPort(ajn::SessionPort port, bool multipoint, ajn::SessionPortListener& portListener, ajn::SessionListener& sessionListener);
+		void UnbindSessionPort(ajn::SessionPort port);
+		BusSignalHandle ResolveSignal(const std::string& path, const std::string& signalName);
+		bool EmitSignal(BusSignalHandle signal, const ajn::MsgArg* args, size_t argCount, ajn::SessionId session, uint16_t timeToLive, uint32_t* serial);
+		bool CancelSignal(BusSignalHandle signal, uint32_t serial);
+		bool EmitPropertiesChanged(const std::string& path, const char** propertyNames, size_t propertyCount, ajn::SessionId session);
+		bool Announce(ajn::SessionPort port, const TBAboutDescription& about);
+		QStatus ReplyToCall(const std::string& path, const ajn::Message& message, const ajn::MsgArg* args, size_t argCount);
+		QStatus ReplyToCall(const std::string& path, const ajn::Message& message, const char* error, const char* errorMessage);
+		QStatus ReplyToCall(const std::string& path, const ajn::Message& message, QStatus status);
+
+		// Returns NULL unless connected.
+		ajn::BusAttachment* GetBusAttachment() const;
+
+	protected:
+		// The BusObject of a registered object.
+		class Object :
+			public ajn::BusObject
+		{
+			public:
+				Object(const std::string& path, const ajn::InterfaceDescription& definition, TBBusEndpoint& endpoint);
+
+				bool Attach();
+				QStatus EmitSignal(const ajn::InterfaceDescription::Member& member, const ajn::MsgArg* args, size_t argCount, ajn::SessionId session, uint16_t timeToLive, uint32_t* serial);
+				QStatus CancelSignal(uint32_t serial);
+				void EmitPropertiesChanged(const char** propertyNames, size_t propertyCount, ajn::SessionId session);
+				using ajn::BusObject::MethodReply;
+
+				const ajn::InterfaceDescription& mDefinition;
+
+			protected:
+				void HandleCall(const ajn::InterfaceDescription::Member* member, ajn::Message& message);
+				QStatus Get(const char* ifcName, const char* propName, ajn::MsgArg& val);
+				QStatus Set(const char* ifcName, const char* propName, ajn::MsgArg& val);
+
+				// Sends the result of a call as the Method reply.
+				class MessageReply :
+					public ActionReply
+				{
+					public:
+						MessageReply(Object& object, ajn::Message& message);
+						QStatus Reply(const ajn::MsgArg* args, size_t argCount);
+						bool mReplied;
+
+					private:
+						Object& mObject;
+						ajn::Message& mMessage;
+				};
+
+				TBBusEndpoint& mEndpoint;
+		};
+
+		// Passes session joins on to the listeners given to BindSessionPort, after setting the session listener, which
+		//	needs the BusAttachment the listeners don't know about.
+		class PortListener :
+			public ajn::SessionPortListener
+		{
+			public:
+				PortListener(ajn::BusAttachment& busAttachment, ajn::SessionPortListener& portListener, ajn::SessionListener& sessionListener);
+				bool AcceptSessionJoiner(ajn::SessionPort sessionPort, const char* joiner, const ajn::SessionOpts& opts);
+				void SessionJoined(ajn::SessionPort sessionPort, ajn::SessionId id, const char* joiner);
+
+			private:
+				ajn::BusAttachment& mBusAttachment;
+				ajn::SessionPortListener& mPortListener;
+				ajn::SessionListener& mSessionListener;
+		};
+
+		struct SignalEntry {
+			SignalEntry(Object* object = NULL, const ajn::InterfaceDescription::Member* member = NULL) :
+				mObject(object)
+				,mMember(member)
+			{};
+			Object* mObject;
+			const ajn::InterfaceDescription::Member* mMember;
+		};
+
+		void TearDown();
+		Object* FindObject(const std::string& path) const;
+
+		// mConnectMutex is held while the BusAttachment is brought up or torn down, mMutex only while the objects and
+		//	Signals are looked up or changed, so that handlers emitting Signals aren't blocked on a teardown waiting on them.
+		std::mutex mConnectMutex;
+		mutable std::mutex mMutex;
+		size_t mConnections;
+		bool mRuntimeAcquired;
+		ajn::BusAttachment* mBusAttachment;
+		ajn::AboutData* mAboutData;
+		ajn::AboutObj* mAboutObject;
+		std::map< std::string, Object* > mObjects;
+		std::map< ajn::SessionPort, PortListener* > mPortListeners;
+		std::vector< SignalEntry > mSignals;
+
+	private:
+		TBAllJoynBackend(const TBAllJoynBackend&);
+		TBAllJoynBackend& operator=(const TBAllJoynBackend&);
+};
+
+} // namespace twobulls
+
+#endif // TWOBULLS_ALLJOYNBACKEND_H
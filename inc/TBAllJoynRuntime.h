@@ -0,0 +1,52 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#ifndef TWOBULLS_ALLJOYNRUNTIME_H
+#define TWOBULLS_ALLJOYNRUNTIME_H
+
+#include <mutex>
+#include <stddef.h>
+
+namespace twobulls {
+
+// The process wide AllJoyn runtime; AllJoynInit and, when built with ALLJOYN_BUNDLED_ROUTER, the bundled router. Every
+//	TBStartAllJoyn and TBStartAllJoynHost in the process holds a reference while started. The first reference
+//	initializes the runtime and the last one to be released shuts it down, so stopping one object doesn't pull the
+//	runtime out from under the others.
+//
+// An application that restarts its objects often can Acquire a reference of its own for as long as it runs, so that
+//	the router isn't shut down and started again in between.
+class TBAllJoynRuntime {
+	public:
+		// Takes a reference, initializing the runtime if it is the first. Returns false if initialization failed, in
+		//	which case no reference is held.
+		static bool Acquire();
+
+		// Gives back a reference taken with Acquire, shutting the runtime down if it is the last.
+		static void Release();
+
+		static size_t GetReferenceCount();
+
+	private:
+		static std::mutex sMutex;
+		static size_t sReferenceCount;
+};
+
+} // namespace twobulls
+
+#endif // TWOBULLS_ALLJOYNRUNTIME_H
@@ -0,0 +1,199 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#ifndef TWOBULLS_BUSBACKEND_H
+#define TWOBULLS_BUSBACKEND_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <alljoyn/InterfaceDescription.h>
+#include <alljoyn/Message.h>
+#include <alljoyn/MsgArg.h>
+#include <alljoyn/SessionListener.h>
+#include <alljoyn/SessionPortListener.h>
+
+namespace twobulls {
+
+class TBAboutDescription;
+
+// Where the result of a typed Action goes; for an AllJoyn Method call that is the Method reply.
+class ActionReply {
+	public:
+		virtual ~ActionReply() {};
+		virtual QStatus Reply(const ajn::MsgArg* args, size_t argCount) = 0;
+};
+
+// The kinds of member of a BusInterface.
+enum BusMemberType {
+	BUS_MEMBER_SIGNAL,
+	BUS_MEMBER_METHOD,
+	BUS_MEMBER_PROPERTY
+};
+
+// A bus independent description of a Signal, Method or Property, as TBStartAllJoyn derives it from its descriptors.
+struct BusMember {
+	//	'inputSignature' is the signature of a Signal or of the arguments of a Method, or the type of a Property.
+	//	'outputSignature' is the signature of the reply of a Method.
+	//	'annotation' takes the ajn::MEMBER_ANNOTATE_ flags of a Method.
+	//	'writable' lets consumers set a Property.
+	BusMember(BusMemberType type, const std::string& name, const std::string& description, const std::string& inputSignature,
+				const std::string& outputSignature = std::string(), const std::string& argNames = std::string(), uint8_t annotation = 0, bool writable = false) :
+		mType(type)
+		,mName(name)
+		,mDescription(description)
+		,mInputSignature(inputSignature)
+		,mOutputSignature(outputSignature)
+		,mArgNames(argNames)
+		,mAnnotation(annotation)
+		,mWritable(writable)
+		,mEmitsChanged(true)
+	{};
+	BusMemberType mType;
+	std::string mName;
+	std::string mDescription;
+	std::string mInputSignature;
+	std::string mOutputSignature;
+	std::string mArgNames;
+	uint8_t mAnnotation;
+	bool mWritable;
+	bool mEmitsChanged;	// whether a Property notifies consumers of its changes
+};
+
+// A bus independent description of an interface.
+struct BusInterface {
+	BusInterface(const std::string& name = std::string(), const std::string& description = std::string(), const std::string& language = std::string()) :
+		mName(name)
+		,mDescription(description)
+		,mLanguage(language)
+		,mMembers()
+	{};
+
+	// Returns the member called 'name', or NULL if there is none.
+	const BusMember* FindMember(const std::string& name, BusMemberType type) const {
+		for(std::vector< BusMember >::const_iterator member = mMembers.begin(); member != mMembers.end(); ++member) {
+			if(member->mType == type && member->mName == name) {
+				return &*member;
+			}
+		}
+		return NULL;
+	};
+
+	std::string mName;
+	std::string mDescription;
+	std::string mLanguage;
+	std::vector< BusMember > mMembers;
+};
+
+// A call of a Method of an object registered with a TBBusBackend. The arguments are only valid for the duration of the
+//	call. A backend on AllJoyn also passes on the Member and Message the call arrived with, which lets the endpoint take
+//	the call over and reply to it later with TBBusBackend::ReplyToCall; they are NULL otherwise.
+struct BusCall {
+	BusCall(const char* methodName, const ajn::MsgArg* args, size_t argCount, ajn::SessionId session = 0, const char* sender = NULL, size_t bytes = 0,
+			const ajn::InterfaceDescription::Member* member = NULL, ajn::Message* message = NULL) :
+		mMethodName(methodName)
+		,mArgs(args)
+		,mArgCount(argCount)
+		,mSession(session)
+		,mSender(sender)
+		,mBytes(bytes)
+		,mMember(member)
+		,mMessage(message)
+	{};
+	const char* mMethodName;
+	const ajn::MsgArg* mArgs;
+	size_t mArgCount;
+	ajn::SessionId mSession;
+	const char* mSender;
+	size_t mBytes;
+	const ajn::InterfaceDescription::Member* mMember;
+	ajn::Message* mMessage;
+};
+
+// What an object registered with a TBBusBackend does with the traffic the backend delivers to it.
+class TBBusEndpoint {
+	public:
+		virtual ~TBBusEndpoint() {};
+
+		// Handles a call of one of the object's Methods, replying through 'reply'. A status other than ER_OK is sent back
+		//	to the caller as an error, unless a reply has already been made. A call that came with a Message can instead
+		//	be replied to with TBBusBackend::ReplyToCall, in which case HandleCall returns ER_OK without replying.
+		virtual QStatus HandleCall(const BusCall& call, ActionReply& reply) = 0;
+
+		virtual QStatus GetPropertyValue(const char* propertyName, ajn::MsgArg& value) = 0;
+		virtual QStatus SetPropertyValue(const char* propertyName, ajn::MsgArg& value) = 0;
+};
+
+// Identifies a Signal of an object registered with a TBBusBackend, as returned by TBBusBackend::ResolveSignal.
+typedef size_t BusSignalHandle;
+const BusSignalHandle INVALID_BUS_SIGNAL = static_cast< BusSignalHandle >(-1);
+
+// The bus that a TBStartAllJoyn runs on; see TBStartAllJoyn::SetBusBackend. Between Connect and Disconnect, interfaces
+//	are defined and objects registered with it, and the objects then emit Signals, receive Method calls and announce
+//	themselves through it. A backend can be shared by several objects, each of which Connects and Disconnects once.
+//
+// TBAllJoynBackend is the backend on an AllJoyn router, and TBLoopbackBus is one that never leaves the process.
+class TBBusBackend {
+	public:
+		virtual ~TBBusBackend() {};
+
+		virtual bool Connect(const std::string& applicationName) = 0;
+		virtual void Disconnect() = 0;
+
+		// An interface that is already defined is left as it is, as interfaces can't be changed once they are in use.
+		virtual bool DefineInterface(const BusInterface& definition) = 0;
+
+		// Registers an object at 'path' implementing the interface, with the endpoint that handles its incoming traffic.
+		virtual bool RegisterObject(const std::string& path, const std::string& interfaceName, TBBusEndpoint& endpoint) = 0;
+		virtual void UnregisterObject(const std::string& path) = 0;
+
+		// Lets consumers join sessions on 'port'. 'portListener' decides who may, and is told who did, and
+		//	'sessionListener' is told when they leave.
+		virtual bool BindSessionPort(ajn::SessionPort port, bool multipoint, ajn::SessionPortListener& portListener, ajn::SessionListener& sessionListener) = 0;
+		virtual void UnbindSessionPort(ajn::SessionPort port) = 0;
+
+		// Looks up a Signal of a registered object once, so that emitting it doesn't involve a lookup by name. Returns
+		//	INVALID_BUS_SIGNAL if there is no such Signal.
+		virtual BusSignalHandle ResolveSignal(const std::string& path, const std::string& signalName) = 0;
+
+		// Emits a Signal to the members of 'session', or sessionless when 'session' is zero, in which case it is kept
+		//	around for new consumers for 'timeToLive' seconds; zero is for as long as the bus can. 'serial', if not NULL,
+		//	is set to what CancelSignal takes to withdraw a sessionless Signal.
+		virtual bool EmitSignal(BusSignalHandle signal, const ajn::MsgArg* args, size_t argCount, ajn::SessionId session, uint16_t timeToLive, uint32_t* serial) = 0;
+		virtual bool CancelSignal(BusSignalHandle signal, uint32_t serial) = 0;
+
+		// Notifies consumers of changes to Properties of a registered object, as for EmitSignal. The values are read back
+		//	from the object's endpoint.
+		virtual bool EmitPropertiesChanged(const std::string& path, const char** propertyNames, size_t propertyCount, ajn::SessionId session) = 0;
+
+		// Announces the application, with the objects registered so far, to consumers listening for it on 'port'.
+		virtual bool Announce(ajn::SessionPort port, const TBAboutDescription& about) = 0;
+
+		// Replies to a call of the object registered at 'path' that was handed to its endpoint with a Message, as
+		//	ajn::BusObject::MethodReply does. This can be done from any thread, until the object is unregistered.
+		// Returns ER_NOT_IMPLEMENTED on a backend that passes on no Messages.
+		virtual QStatus ReplyToCall(const std::string& path, const ajn::Message& message, const ajn::MsgArg* args, size_t argCount) = 0;
+		virtual QStatus ReplyToCall(const std::string& path, const ajn::Message& message, const char* error, const char* errorMessage) = 0;
+		virtual QStatus ReplyToCall(const std::string& path, const ajn::Message& message, QStatus status) = 0;
+};
+
+} // namespace twobulls
+
+#endif // TWOBULLS_BUSBACKEND_H
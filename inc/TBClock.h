@@ -0,0 +1,34 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#ifndef TWOBULLS_CLOCK_H
+#define TWOBULLS_CLOCK_H
+
+#include <chrono>
+#include <stdint.h>
+
+namespace twobulls {
+
+// Nanoseconds on a clock that never jumps; only meaningful relative to other values from the same clock.
+inline uint64_t MonotonicNanoseconds() {
+	return static_cast< uint64_t >(std::chrono::duration_cast< std::chrono::nanoseconds >(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+} // namespace twobulls
+
+#endif // TWOBULLS_CLOCK_H
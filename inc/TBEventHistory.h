@@ -0,0 +1,96 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#ifndef TWOBULLS_EVENTHISTORY_H
+#define TWOBULLS_EVENTHISTORY_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace twobulls {
+
+// See TBStartAllJoyn.h
+typedef size_t EventHandle;
+
+// Configuration of the record of recently emitted Events, which late joiners can catch up on through the built in
+//	GetEventsSince Action.
+struct EventHistoryOptions {
+	//	'capacity' is how many of the most recent Events are kept. Zero disables the history, and the Action.
+	//	'maxReplay' is the most Events returned by a single call of GetEventsSince.
+	EventHistoryOptions(size_t capacity = 64, size_t maxReplay = 64) :
+		mCapacity(capacity)
+		,mMaxReplay(maxReplay)
+	{};
+	size_t mCapacity;
+	size_t mMaxReplay;
+};
+
+// A single emitted Event. Sequence numbers start at 1 and have no gaps, so a jump tells a consumer it missed some.
+struct EventRecord {
+	EventRecord() :
+		mSequence(0)
+		,mTimestampMs(0)
+		,mEvent(0)
+	{};
+	uint64_t mSequence;
+	uint64_t mTimestampMs;	// wall clock, milliseconds since the Unix epoch
+	EventHandle mEvent;
+};
+
+// A fixed ring of the most recent EventRecords, allocated once up front. Each slot is guarded by a version number that
+//	is odd while the slot is being written, so readers never block writers; a reader that sees the version change
+//	under it treats the slot as overwritten.
+class TBEventHistory {
+	public:
+		TBEventHistory(size_t capacity);
+		~TBEventHistory();
+
+		// Records an Event, returning its sequence number.
+		uint64_t Record(EventHandle event);
+
+		// Copies up to 'maxRecords' records with a sequence number greater than 'since', oldest first, into 'records'.
+		//	Returns how many were copied. Records that have already been overwritten are skipped.
+		size_t GetSince(uint64_t since, EventRecord* records, size_t maxRecords) const;
+
+		uint64_t GetLatestSequence() const;
+		size_t GetCapacity() const;
+
+	private:
+		struct Slot {
+			Slot() :
+				mVersion(0)
+				,mTimestampMs(0)
+				,mEvent(0)
+			{};
+			std::atomic< uint64_t > mVersion;
+			std::atomic< uint64_t > mTimestampMs;
+			std::atomic< EventHandle > mEvent;
+		};
+
+		const size_t mCapacity;
+		Slot* mSlots;
+		std::atomic< uint64_t > mLatestSequence;
+
+		TBEventHistory(const TBEventHistory&);
+		TBEventHistory& operator=(const TBEventHistory&);
+};
+
+} // namespace twobulls
+
+#endif // TWOBULLS_EVENTHISTORY_H
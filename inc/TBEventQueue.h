@@ -0,0 +1,130 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#ifndef TWOBULLS_EVENTQUEUE_H
+#define TWOBULLS_EVENTQUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace twobulls {
+
+// See TBStartAllJoyn.h
+typedef size_t EventHandle;
+
+// What TBEventQueue::Push does when the queue is full.
+enum EventQueueOverflowPolicy {
+	EVENT_QUEUE_DROP_OLDEST,	// discard the oldest queued Event to make room for the new one
+	EVENT_QUEUE_DROP_NEWEST,	// discard the new Event
+	EVENT_QUEUE_BLOCK			// wait for the emitter to make room
+};
+
+// Configuration of the queue behind TBStartAllJoyn::TriggerEventAsync.
+struct EventQueueOptions {
+	//	'capacity' is the maximum number of queued Events, rounded up to a power of two. Zero disables the queue.
+	//	'overflowPolicy' decides which Event is lost when the queue is full.
+	EventQueueOptions(size_t capacity = 256, EventQueueOverflowPolicy overflowPolicy = EVENT_QUEUE_DROP_NEWEST) :
+		mCapacity(capacity)
+		,mOverflowPolicy(overflowPolicy)
+	{};
+	size_t mCapacity;
+	EventQueueOverflowPolicy mOverflowPolicy;
+};
+
+// A snapshot of the queue counters.
+struct EventQueueStats {
+	EventQueueStats() :
+		mEnqueued(0)
+		,mEmitted(0)
+		,mFailed(0)
+		,mDropped(0)
+	{};
+	uint64_t mEnqueued;
+	uint64_t mEmitted;
+	uint64_t mFailed;
+	uint64_t mDropped;
+};
+
+// A bounded lock-free multi-producer queue of EventHandles, drained by a single emitter thread. Each cell carries a
+//	sequence number that tells producers and the consumer whose turn it is to use it, so Push and Pop only ever contend
+//	on a single compare-and-swap. Locks are only taken to park the emitter when the queue is empty, or a producer when
+//	the queue is full under EVENT_QUEUE_BLOCK.
+class TBEventQueue {
+	public:
+		TBEventQueue(const EventQueueOptions& options);
+		~TBEventQueue();
+
+		// Queues the Event as per the overflow policy. Returns false if the Event itself was not queued.
+		bool Push(EventHandle event);
+
+		// Dequeues the oldest Event. Returns false if the queue is empty. Only the emitter thread may call this.
+		bool Pop(EventHandle& event);
+
+		// Parks the emitter until an Event is queued, the queue is closed, Wake is called or 'timeout' elapses.
+		void Wait(std::chrono::nanoseconds timeout);
+		void Wake();
+
+		// Closing the queue releases the emitter and any producers blocked under EVENT_QUEUE_BLOCK. Open reverses it.
+		void Close();
+		void Open();
+		bool IsClosed() const;
+
+		// Called by the emitter with the outcome of each Signal.
+		void CountEmitted(bool result);
+
+		EventQueueStats GetStats() const;
+
+	private:
+		struct Cell {
+			std::atomic< size_t > mSequence;
+			EventHandle mEvent;
+		};
+
+		bool TryPush(EventHandle event);
+		bool TryPop(EventHandle& event);
+
+		const EventQueueOverflowPolicy mOverflowPolicy;
+		size_t mMask;
+		Cell* mCells;
+		std::atomic< size_t > mEnqueuePosition;
+		std::atomic< size_t > mDequeuePosition;
+		std::atomic< bool > mClosed;
+
+		std::mutex mMutex;
+		std::condition_variable mDataCondition;
+		std::condition_variable mSpaceCondition;
+		std::atomic< bool > mEmitterWaiting;
+		std::atomic< bool > mWakeRequested;
+		std::atomic< size_t > mProducersWaiting;
+
+		std::atomic< uint64_t > mEnqueued;
+		std::atomic< uint64_t > mEmitted;
+		std::atomic< uint64_t > mFailed;
+		std::atomic< uint64_t > mDropped;
+
+		TBEventQueue(const TBEventQueue&);
+		TBEventQueue& operator=(const TBEventQueue&);
+};
+
+} // namespace twobulls
+
+#endif // TWOBULLS_EVENTQUEUE_H
@@ -0,0 +1,57 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#ifndef TWOBULLS_INTROSPECTION_H
+#define TWOBULLS_INTROSPECTION_H
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#include "TBBusBackend.h"
+
+namespace twobulls {
+
+// How TBStartAllJoyn defines its interface on a BusAttachment.
+struct InterfaceOptions {
+	//	'fromXml' builds the interface from introspection XML, generated from the descriptors the first time the object
+	//	 is started and kept for later starts, with one call to CreateInterfacesFromXml instead of a call per member.
+	//	'maxMembersPerInterface' spreads the Signals and Methods over as many interfaces as it takes to hold no more than
+	//	 this many each, when 'fromXml' is set. The first keeps the name derived from the path, and all the Properties,
+	//	 the rest are named after it with a suffix of .Part2, .Part3 and so on. Zero keeps them all on the one interface.
+	InterfaceOptions(bool fromXml = false, size_t maxMembersPerInterface = 0) :
+		mFromXml(fromXml)
+		,mMaxMembersPerInterface(maxMembersPerInterface)
+	{};
+	bool mFromXml;
+	size_t mMaxMembersPerInterface;
+};
+
+// Spreads the Signals and Methods of 'definition' over interfaces of at most 'maxMembers' of them each, as described by
+//	InterfaceOptions. The order of the members is kept.
+std::vector< BusInterface > SplitInterface(const BusInterface& definition, size_t maxMembers);
+
+// Returns the introspection XML of 'interfaces', in the form taken by ajn::BusAttachment::CreateInterfacesFromXml.
+std::string IntrospectionXml(const std::vector< BusInterface >& interfaces);
+
+// Splits a signature into its complete types, eg. "ia{sv}(ii)" into "i", "a{sv}" and "(ii)".
+std::vector< std::string > SplitSignature(const std::string& signature);
+
+} // namespace twobulls
+
+#endif // TWOBULLS_INTROSPECTION_H
@@ -0,0 +1,92 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#ifndef TWOBULLS_LIFECYCLESTATS_H
+#define TWOBULLS_LIFECYCLESTATS_H
+
+#include <stdint.h>
+#include <string>
+
+namespace twobulls {
+
+// The timed steps of TBStartAllJoyn::Start, StartAsync, Stop, Suspend and Resume. The steps of SetupBusAttachment and
+//	SetupAboutObject are timed individually, and those functions as a whole.
+enum LifecycleStep {
+	LIFECYCLE_START,
+	LIFECYCLE_RUNTIME_ACQUIRE,
+	LIFECYCLE_ACTION_POOL_START,
+	LIFECYCLE_SETUP_BUS_ATTACHMENT,
+	LIFECYCLE_BUS_CREATE,
+	LIFECYCLE_BUS_START,
+	LIFECYCLE_DEFINE_INTERFACE,
+	LIFECYCLE_ATTACH_INTERFACE,
+	LIFECYCLE_CONNECT,
+	LIFECYCLE_BIND_SESSION_PORT,
+	LIFECYCLE_SETUP_ABOUT_OBJECT,
+	LIFECYCLE_ABOUT_DATA_CREATE,
+	LIFECYCLE_ABOUT_DATA_VALIDATE,
+	LIFECYCLE_ANNOUNCE,
+	LIFECYCLE_EMITTER_START,
+	LIFECYCLE_STOP,
+	LIFECYCLE_EMITTER_STOP,
+	LIFECYCLE_BUS_STOP,
+	LIFECYCLE_ACTION_POOL_STOP,
+	LIFECYCLE_UNREGISTER_OBJECT,
+	LIFECYCLE_DELETE_BUS,
+	LIFECYCLE_RUNTIME_RELEASE,
+	LIFECYCLE_SUSPEND,
+	LIFECYCLE_UNANNOUNCE,
+	LIFECYCLE_DISCONNECT,
+	LIFECYCLE_RESUME,
+	LIFECYCLE_STEP_COUNT
+};
+
+// The timing of a single step. Timestamps are from MonotonicNanoseconds.
+struct LifecycleTiming {
+	LifecycleTiming() :
+		mRecorded(false)
+		,mResult(false)
+		,mStartNs(0)
+		,mDurationNs(0)
+	{};
+	bool mRecorded;
+	bool mResult;
+	uint64_t mStartNs;
+	uint64_t mDurationNs;
+};
+
+// The timings of the most recent start and stop; each Start or StartAsync clears those of the previous run.
+struct LifecycleStats {
+	LifecycleTiming mSteps[LIFECYCLE_STEP_COUNT];
+
+	const LifecycleTiming& GetTiming(LifecycleStep step) const { return mSteps[step]; };
+
+	// Records a step that began at 'startNs' and has just finished.
+	void Record(LifecycleStep step, uint64_t startNs, bool result);
+	void Clear();
+
+	// The recorded steps as a JSON object, eg. {"steps":[{"step":"BusStart","start_ns":...,"duration_ns":...,
+	//	"result":true},...]}, with start_ns relative to the start of the first recorded step.
+	std::string ToJSON() const;
+
+	static const char* GetStepName(LifecycleStep step);
+};
+
+} // namespace twobulls
+
+#endif // TWOBULLS_LIFECYCLESTATS_H
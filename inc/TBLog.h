@@ -0,0 +1,170 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#ifndef TWOBULLS_LOG_H
+#define TWOBULLS_LOG_H
+
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <type_traits>
+
+#include "TBClock.h"
+
+// Log levels, as numbers so that the preprocessor can compare them.
+#define TBLOG_LEVEL_TRACE 0
+#define TBLOG_LEVEL_DEBUG 1
+#define TBLOG_LEVEL_INFO 2
+#define TBLOG_LEVEL_WARNING 3
+#define TBLOG_LEVEL_ERROR 4
+#define TBLOG_LEVEL_NONE 5
+
+// Logging below TBLOG_COMPILE_LEVEL is compiled out altogether. It defaults to INFO, so the trace of every call is only
+//	built in when ENABLE_TBSTARTALLJOYN_LOGGING is defined, as before, or TBLOG_COMPILE_LEVEL is set to TRACE.
+#if !defined(TBLOG_COMPILE_LEVEL)
+	#if defined(ENABLE_TBSTARTALLJOYN_LOGGING)
+		#define TBLOG_COMPILE_LEVEL TBLOG_LEVEL_TRACE
+	#else
+		#define TBLOG_COMPILE_LEVEL TBLOG_LEVEL_INFO
+	#endif
+#endif
+
+// Logs a printf style message. 'category', 'format' and any arguments are only evaluated when the level is enabled.
+//	'category' and 'format' must be string literals, as only their addresses are recorded.
+#define TBLOG(level, category, ...) do { \
+		if((level) >= TBLOG_COMPILE_LEVEL && ::twobulls::TBLog::IsEnabled(static_cast< ::twobulls::LogLevel >(level))) { \
+			::twobulls::TBLog::Write(static_cast< ::twobulls::LogLevel >(level), category, __VA_ARGS__); \
+		} \
+	} while(0)
+
+namespace twobulls {
+
+enum LogLevel {
+	LOG_LEVEL_TRACE = TBLOG_LEVEL_TRACE,
+	LOG_LEVEL_DEBUG = TBLOG_LEVEL_DEBUG,
+	LOG_LEVEL_INFO = TBLOG_LEVEL_INFO,
+	LOG_LEVEL_WARNING = TBLOG_LEVEL_WARNING,
+	LOG_LEVEL_ERROR = TBLOG_LEVEL_ERROR,
+	LOG_LEVEL_NONE = TBLOG_LEVEL_NONE
+};
+
+// Receives each formatted line, without a trailing newline, on the formatter thread.
+typedef void (*LogSink)(LogLevel level, const char* line);
+
+// A log message as it is recorded, before formatting. Strings are copied into mStrings as they may not outlive the
+//	call, anything else is kept as a number.
+struct LogRecord {
+	enum { MAX_ARGS = 8, STRING_CAPACITY = 120 };
+
+	struct Arg {
+		enum Type { INTEGER, UNSIGNED, REAL, STRING, POINTER };
+		Type mType;
+		union {
+			int64_t mInteger;
+			uint64_t mUnsigned;
+			double mReal;
+			size_t mStringOffset;
+			const void* mPointer;
+		};
+	};
+
+	uint64_t mTimestampNs;
+	const char* mCategory;
+	const char* mFormat;
+	LogLevel mLevel;
+	uint16_t mArgCount;
+	uint16_t mStringLength;
+	Arg mArgs[MAX_ARGS];
+	char mStrings[STRING_CAPACITY];
+};
+
+// An asynchronous logger. Each thread writes binary LogRecords into a lock-free ring of its own, and a background
+//	thread formats them and passes them to the sink, so a logging call costs a clock read and a few stores. A record
+//	is dropped, and counted, if its thread's ring is full.
+class TBLog {
+	public:
+		static void SetLevel(LogLevel level);
+		static LogLevel GetLevel();
+		static bool IsEnabled(LogLevel level) { return level >= sLevel.load(std::memory_order_relaxed); };
+
+		// The default sink writes to stdout. NULL restores it.
+		static void SetSink(LogSink sink);
+
+		// Formats everything logged so far, on the calling thread, before returning.
+		static void Flush();
+
+		// Returns how many records were lost to full rings.
+		static uint64_t GetDroppedCount();
+
+		template< typename... Args > static void Write(LogLevel level, const char* category, const char* format, const Args&... args) {
+			static_assert(sizeof...(Args) <= LogRecord::MAX_ARGS, "too many arguments to log");
+
+			LogRecord* record = BeginRecord();
+			if(record != NULL) {
+				record->mTimestampNs = MonotonicNanoseconds();
+				record->mCategory = category;
+				record->mFormat = format;
+				record->mLevel = level;
+				record->mArgCount = 0;
+				record->mStringLength = 0;
+				CaptureArgs(*record, args...);
+				CommitRecord();
+			}
+		};
+
+	private:
+		static LogRecord* BeginRecord();
+		static void CommitRecord();
+
+		static void CaptureArgs(LogRecord&) {};
+		template< typename T, typename... Rest > static void CaptureArgs(LogRecord& record, const T& value, const Rest&... rest) {
+			CaptureArg(record, value);
+			CaptureArgs(record, rest...);
+		};
+
+		template< typename T > static typename std::enable_if< std::is_integral< T >::value || std::is_enum< T >::value >::type CaptureArg(LogRecord& record, const T& value) {
+			LogRecord::Arg& arg = record.mArgs[record.mArgCount++];
+			if(std::is_signed< T >::value || std::is_enum< T >::value) {
+				arg.mType = LogRecord::Arg::INTEGER;
+				arg.mInteger = static_cast< int64_t >(value);
+			} else {
+				arg.mType = LogRecord::Arg::UNSIGNED;
+				arg.mUnsigned = static_cast< uint64_t >(value);
+			}
+		};
+		template< typename T > static typename std::enable_if< std::is_floating_point< T >::value >::type CaptureArg(LogRecord& record, const T& value) {
+			LogRecord::Arg& arg = record.mArgs[record.mArgCount++];
+			arg.mType = LogRecord::Arg::REAL;
+			arg.mReal = static_cast< double >(value);
+		};
+		template< typename T > static void CaptureArg(LogRecord& record, const T* value) {
+			LogRecord::Arg& arg = record.mArgs[record.mArgCount++];
+			arg.mType = LogRecord::Arg::POINTER;
+			arg.mPointer = value;
+		};
+		static void CaptureArg(LogRecord& record, const char* value);
+		static void CaptureArg(LogRecord& record, char* value) { CaptureArg(record, const_cast< const char* >(value)); };
+		static void CaptureArg(LogRecord& record, const std::string& value) { CaptureArg(record, value.c_str()); };
+
+		static std::atomic< int > sLevel;
+};
+
+} // namespace twobulls
+
+#endif // TWOBULLS_LOG_H
@@ -0,0 +1,156 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#ifndef TWOBULLS_LOOPBACKBUS_H
+#define TWOBULLS_LOOPBACKBUS_H
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "TBAboutDescription.h"
+#include "TBBusBackend.h"
+
+namespace twobulls {
+
+// Receives the Signals emitted on a TBLoopbackBus. The arguments are only valid for the duration of the call.
+typedef std::function< void (const std::string& path, const std::string& signalName, const ajn::MsgArg* args, size_t argCount) > LoopbackSignalHandler;
+
+// Receives the PropertiesChanged notifications of a TBLoopbackBus; the new values can be read with GetProperty.
+typedef std::function< void (const std::string& path, const char** propertyNames, size_t propertyCount) > LoopbackPropertiesHandler;
+
+// A TBBusBackend that never leaves the process, for running and measuring objects without an AllJoyn router. Signals
+//	are delivered to the handlers added to the bus, and Methods are called with CallMethod, all synchronously on the
+//	calling thread; there are no sessions, and no sessionless cache, so cancelling a Signal does nothing.
+//
+// Any number of objects can share a TBLoopbackBus, so that one object's Signals can drive another object's Actions in
+//	the same process. Calls to an object must not race with it being unregistered, ie. with its Stop.
+class TBLoopbackBus :
+	public TBBusBackend
+{
+	public:
+		TBLoopbackBus();
+		virtual ~TBLoopbackBus();
+
+		// From TBBusBackend
+		bool Connect(const std::string& applicationName);
+		void Disconnect();
+		bool DefineInterface(const BusInterface& definition);
+		bool RegisterObject(const std::string& path, const std::string& interfaceName, TBBusEndpoint& endpoint);
+		void UnregisterObject(const std::string& path);
+		bool BindSessionPort(ajn::SessionPort port, bool multipoint, ajn::SessionPortListener& portListener, ajn::SessionListener& sessionListener);
+		void UnbindSessionPort(ajn::SessionPort port);
+		BusSignalHandle ResolveSignal(const std::string& path, const std::string& signalName);
+		bool EmitSignal(BusSignalHandle signal, const ajn::MsgArg* args, size_t argCount, ajn::SessionId session, uint16_t timeToLive, uint32_t* serial);
+		bool CancelSignal(BusSignalHandle signal, uint32_t serial);
+		bool EmitPropertiesChanged(const std::string& path, const char** propertyNames, size_t propertyCount, ajn::SessionId session);
+		bool Announce(ajn::SessionPort port, const TBAboutDescription& about);
+		QStatus ReplyToCall(const std::string& path, const ajn::Message& message, const ajn::MsgArg* args, size_t argCount);
+		QStatus ReplyToCall(const std::string& path, const ajn::Message& message, const char* error, const char* errorMessage);
+		QStatus ReplyToCall(const std::string& path, const ajn::Message& message, QStatus status);
+
+		// Handlers are called in the order they were added, and can be added or removed at any time, including from
+		//	within a handler. Each returns an identifier for RemoveHandler.
+		size_t AddSignalHandler(const LoopbackSignalHandler& handler);
+		size_t AddPropertiesChangedHandler(const LoopbackPropertiesHandler& handler);
+		void RemoveHandler(size_t handler);
+
+		// Calls a Method of a registered object, checking the arguments against its signature as a router would. The
+		//	reply, if there is one, is copied into 'replyArgs'.
+		QStatus CallMethod(const std::string& path, const std::string& methodName, const ajn::MsgArg* args, size_t argCount, std::vector< ajn::MsgArg >& replyArgs);
+
+		QStatus GetProperty(const std::string& path, const std::string& propertyName, ajn::MsgArg& value);
+		QStatus SetProperty(const std::string& path, const std::string& propertyName, const ajn::MsgArg& value);
+
+		// Returns the About data of the last Announce. Returns false if there hasn't been one since connecting.
+		bool GetAnnouncement(ajn::SessionPort& port, TBAboutDescription& about) const;
+
+		bool IsConnected() const;
+		std::vector< std::string > GetObjectPaths() const;
+
+	protected:
+		struct Object {
+			Object(const BusInterface* definition = NULL, TBBusEndpoint* endpoint = NULL) :
+				mDefinition(definition)
+				,mEndpoint(endpoint)
+			{};
+			const BusInterface* mDefinition;
+			TBBusEndpoint* mEndpoint;
+		};
+
+		struct SignalEntry {
+			SignalEntry(const std::string& path, const std::string& name) :
+				mPath(path)
+				,mName(name)
+			{};
+			const std::string mPath;
+			const std::string mName;
+		};
+
+		struct Handler {
+			size_t mId;
+			LoopbackSignalHandler mSignal;
+			LoopbackPropertiesHandler mProperties;
+		};
+		typedef std::vector< Handler > Handlers;
+
+		// Looks up a member of the interface of the object at 'path'. Returns NULL if there is no such object or member.
+		const BusMember* FindMember(const std::string& path, const std::string& name, BusMemberType type, TBBusEndpoint*& endpoint) const;
+		size_t AddHandler(const Handler& handler);
+
+		// Sends the reply of a call back to CallMethod.
+		class LoopbackReply :
+			public ActionReply
+		{
+			public:
+				LoopbackReply(std::vector< ajn::MsgArg >& replyArgs);
+				QStatus Reply(const ajn::MsgArg* args, size_t argCount);
+				bool mReplied;
+
+			private:
+				std::vector< ajn::MsgArg >& mReplyArgs;
+		};
+
+		mutable std::mutex mMutex;
+		size_t mConnections;
+		std::map< std::string, BusInterface > mInterfaces;
+		std::map< std::string, Object > mObjects;
+		std::set< ajn::SessionPort > mSessionPorts;
+		std::vector< std::shared_ptr< const SignalEntry > > mSignals;
+		bool mAnnounced;
+		ajn::SessionPort mAnnouncedPort;
+		TBAboutDescription mAnnouncement;
+
+		// Only ever replaced as a whole, so that emitting doesn't hold mMutex while the handlers run
+		std::shared_ptr< const Handlers > mHandlers;
+		size_t mNextHandler;
+		std::atomic< uint32_t > mNextSerial;
+
+	private:
+		TBLoopbackBus(const TBLoopbackBus&);
+		TBLoopbackBus& operator=(const TBLoopbackBus&);
+};
+
+} // namespace twobulls
+
+#endif // TWOBULLS_LOOPBACKBUS_H
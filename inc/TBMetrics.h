@@ -0,0 +1,159 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#ifndef TWOBULLS_METRICS_H
+#define TWOBULLS_METRICS_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace twobulls {
+
+// A counter that any number of threads can add to without contending on a single cache line. Each thread adds to one
+//	of a few padded shards, chosen once per thread, and reading the counter sums them.
+class TBCounter {
+	public:
+		TBCounter();
+
+		void Add(uint64_t count = 1);
+		uint64_t Get() const;
+
+	private:
+		static const size_t SHARD_COUNT = 8;
+		static const size_t CACHE_LINE_SIZE = 64;
+
+		struct Shard {
+			std::atomic< uint64_t > mValue;
+			char mPadding[CACHE_LINE_SIZE - sizeof(std::atomic< uint64_t >)];
+		};
+
+		Shard mShards[SHARD_COUNT];
+
+		TBCounter(const TBCounter&);
+		TBCounter& operator=(const TBCounter&);
+};
+
+// A histogram of durations in nanoseconds, laid out like an HdrHistogram: the buckets are linear within each power of
+//	two and double in width from one power to the next, so each value is kept to within 1/16th of itself, from 1ns up
+//	to about 18 minutes, in a fixed 5KB. Recording a value is a few relaxed atomic adds, with no locks.
+class TBLatencyHistogram {
+	public:
+		TBLatencyHistogram();
+
+		void Record(uint64_t nanoseconds);
+
+		uint64_t GetCount() const;
+		uint64_t GetSum() const;
+		uint64_t GetMax() const;
+
+		// Returns the value that 'percentile' (0 to 1) of the recorded values are at or below, to within a bucket.
+		uint64_t GetPercentile(double percentile) const;
+
+		// Returns how many of the recorded values are at or below 'nanoseconds', to within a bucket.
+		uint64_t CountAtOrBelow(uint64_t nanoseconds) const;
+
+	private:
+		static const unsigned int SUB_BUCKET_BITS = 4;
+		static const unsigned int MAX_VALUE_BITS = 40;
+		static const size_t SUB_BUCKET_COUNT = static_cast< size_t >(1) << SUB_BUCKET_BITS;
+		static const size_t BUCKET_COUNT = SUB_BUCKET_COUNT * (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1);
+
+		static size_t BucketOf(uint64_t value);
+		static uint64_t BucketLimit(size_t bucket);
+
+		std::atomic< uint64_t > mBuckets[BUCKET_COUNT];
+		std::atomic< uint64_t > mCount;
+		std::atomic< uint64_t > mSum;
+		std::atomic< uint64_t > mMax;
+
+		TBLatencyHistogram(const TBLatencyHistogram&);
+		TBLatencyHistogram& operator=(const TBLatencyHistogram&);
+};
+
+// A set of named counters and histograms, for exporting. The metrics are added up front, and from then on are updated
+//	through the references returned, without going through the registry.
+class TBMetricsRegistry {
+	public:
+		TBMetricsRegistry();
+		~TBMetricsRegistry();
+
+		//	'name' is the Prometheus name of the metric, eg. "tbstartalljoyn_events_triggered_total".
+		//	'help' is a sentence describing it.
+		//	'labels' are any Prometheus labels that tell it apart from others of the same name, eg. "call=\"start\"".
+		//	 Metrics that share a name should be added one after the other.
+		TBCounter& AddCounter(const std::string& name, const std::string& help, const std::string& labels = std::string());
+		TBLatencyHistogram& AddHistogram(const std::string& name, const std::string& help, const std::string& labels = std::string());
+
+		// The metrics in the Prometheus text format. Histograms are given in seconds, with buckets from 1us to 10s.
+		std::string ToPrometheus() const;
+
+		// The metrics as name and value pairs, where the name has the labels appended in braces. Counters are given as
+		//	is, and each histogram as its _count, and its _sum, _p50, _p99 and _max in seconds.
+		std::vector< std::pair< std::string, double > > GetValues() const;
+
+		// Writes ToPrometheus to 'path' by way of a temporary file beside it, so that a reader such as the textfile
+		//	collector of node_exporter never sees half of it. Returns false if it couldn't be written.
+		bool WritePrometheusFile(const std::string& path) const;
+
+	private:
+		struct Metric {
+			std::string mName;
+			std::string mHelp;
+			std::string mLabels;
+			TBCounter* mCounter;
+			TBLatencyHistogram* mHistogram;
+		};
+
+		std::vector< Metric > mMetrics;
+
+		TBMetricsRegistry(const TBMetricsRegistry&);
+		TBMetricsRegistry& operator=(const TBMetricsRegistry&);
+};
+
+// Serves the Prometheus text of a TBMetricsRegistry on a UNIX domain socket; each connection is sent the metrics as they
+//	are at that moment, then closed, eg. 'socat - UNIX-CONNECT:/run/device.metrics'.
+class TBMetricsSocket {
+	public:
+		TBMetricsSocket(const TBMetricsRegistry& registry);
+		~TBMetricsSocket();
+
+		// Listens on 'path', replacing any socket left there. Returns false if it is already serving, or can't listen.
+		bool Start(const std::string& path);
+		void Stop();
+
+	private:
+		void ServeLoop();
+
+		const TBMetricsRegistry& mRegistry;
+		std::string mPath;
+		int mListener;
+		std::atomic< bool > mStopping;
+		std::thread mThread;
+
+		TBMetricsSocket(const TBMetricsSocket&);
+		TBMetricsSocket& operator=(const TBMetricsSocket&);
+};
+
+} // namespace twobulls
+
+#endif // TWOBULLS_METRICS_H
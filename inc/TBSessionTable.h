@@ -0,0 +1,113 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#ifndef TWOBULLS_SESSIONTABLE_H
+#define TWOBULLS_SESSIONTABLE_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <alljoyn/MsgArg.h>
+#include <alljoyn/Session.h>
+
+namespace twobulls {
+
+// A copy of the state of a single session member, as returned by TBSessionTable::GetSnapshot.
+struct SessionInfo {
+	SessionInfo() :
+		mId(0)
+		,mJoiner()
+		,mJoinedNs(0)
+		,mMessagesReceived(0)
+		,mBytesReceived(0)
+		,mMessagesSent(0)
+		,mBytesSent(0)
+	{};
+	ajn::SessionId mId;
+	std::string mJoiner;
+	uint64_t mJoinedNs;			// from MonotonicNanoseconds
+	uint64_t mMessagesReceived;	// method calls
+	uint64_t mBytesReceived;	// the marshalled size of those calls
+	uint64_t mMessagesSent;		// replies to those calls, other than those a plain MessageReceiver handler sends itself,
+								//	and Signals to the session
+	uint64_t mBytesSent;		// the marshalled size of the arguments of those replies and Signals
+};
+
+// The number of bytes 'args' take up in the body of a message.
+size_t MarshalledSize(const ajn::MsgArg* args, size_t argCount);
+
+// The members of the sessions bound to an object. Joins and departures are rare and copy the table, while the much
+//	more frequent message counting and snapshots only read it, so neither blocks the AllJoyn dispatcher thread on a
+//	lock shared with the writers.
+class TBSessionTable {
+	public:
+		TBSessionTable();
+
+		void Add(ajn::SessionId id, const char* joiner);
+
+		// Removes the member 'name' of session 'id', or every member when 'name' is NULL.
+		void Remove(ajn::SessionId id, const char* name = NULL);
+		void Clear();
+
+		// Counts a message from 'sender' in session 'id'. Messages outside of a known session are ignored.
+		void CountReceived(ajn::SessionId id, const char* sender, size_t bytes);
+		void CountSent(ajn::SessionId id, const char* destination, size_t bytes);
+
+		// Counts a Signal to session 'id' against each of its members.
+		void CountSignal(ajn::SessionId id, size_t bytes);
+
+		std::vector< SessionInfo > GetSnapshot() const;
+
+		// The number of members, rather than sessions; each member of a multipoint session is counted.
+		size_t GetMemberCount() const;
+
+	protected:
+		struct Entry {
+			Entry(ajn::SessionId id, const std::string& joiner, uint64_t joinedNs) :
+				mId(id)
+				,mJoiner(joiner)
+				,mJoinedNs(joinedNs)
+				,mMessagesReceived(0)
+				,mBytesReceived(0)
+				,mMessagesSent(0)
+				,mBytesSent(0)
+			{};
+			const ajn::SessionId mId;
+			const std::string mJoiner;
+			const uint64_t mJoinedNs;
+			std::atomic< uint64_t > mMessagesReceived;
+			std::atomic< uint64_t > mBytesReceived;
+			std::atomic< uint64_t > mMessagesSent;
+			std::atomic< uint64_t > mBytesSent;
+		};
+		typedef std::vector< std::shared_ptr< Entry > > Entries;
+
+		Entry* Find(const Entries& entries, ajn::SessionId id, const char* name) const;
+
+		// Only ever replaced as a whole, never modified once published
+		std::shared_ptr< const Entries > mEntries;
+		std::mutex mWriteMutex;
+};
+
+} // namespace twobulls
+
+#endif // TWOBULLS_SESSIONTABLE_H
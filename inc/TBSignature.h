@@ -0,0 +1,198 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#ifndef TWOBULLS_SIGNATURE_H
+#define TWOBULLS_SIGNATURE_H
+
+#include <stdint.h>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include <alljoyn/MsgArg.h>
+
+namespace twobulls {
+
+// A borrowed string, pointing into the buffer of the message it was read from; no copy is made. It is only valid for
+//	as long as the message is, typically the duration of the Action handler it is passed to.
+struct StringView {
+	StringView(const char* data = NULL, size_t length = 0) :
+		mData(data)
+		,mLength(length)
+	{};
+	std::string ToString() const { return mData != NULL ? std::string(mData, mLength) : std::string(); };
+	const char* mData;
+	size_t mLength;
+};
+
+// A borrowed byte array, with the same lifetime as StringView.
+struct ByteView {
+	ByteView(const uint8_t* data = NULL, size_t length = 0) :
+		mData(data)
+		,mLength(length)
+	{};
+	const uint8_t* mData;
+	size_t mLength;
+};
+
+// The mapping from C++ types to AllJoyn signatures, worked out at compile time so that the signature of a typed Event
+//	or Action is a string constant. Supported types are bool, the fixed width integers, double, strings and
+//	std::vectors of the numeric types, plus StringView and ByteView.
+
+template< char... C > struct SignatureChars {};
+
+template< typename A, typename B > struct ConcatSignature;
+template< char... A, char... B > struct ConcatSignature< SignatureChars< A... >, SignatureChars< B... > > {
+	typedef SignatureChars< A..., B... > Chars;
+};
+
+template< typename T > struct SignatureOf;
+template<> struct SignatureOf< bool > { typedef SignatureChars< 'b' > Chars; };
+template<> struct SignatureOf< uint8_t > { typedef SignatureChars< 'y' > Chars; };
+template<> struct SignatureOf< int16_t > { typedef SignatureChars< 'n' > Chars; };
+template<> struct SignatureOf< uint16_t > { typedef SignatureChars< 'q' > Chars; };
+template<> struct SignatureOf< int32_t > { typedef SignatureChars< 'i' > Chars; };
+template<> struct SignatureOf< uint32_t > { typedef SignatureChars< 'u' > Chars; };
+template<> struct SignatureOf< int64_t > { typedef SignatureChars< 'x' > Chars; };
+template<> struct SignatureOf< uint64_t > { typedef SignatureChars< 't' > Chars; };
+template<> struct SignatureOf< double > { typedef SignatureChars< 'd' > Chars; };
+template<> struct SignatureOf< const char* > { typedef SignatureChars< 's' > Chars; };
+template<> struct SignatureOf< std::string > { typedef SignatureChars< 's' > Chars; };
+template<> struct SignatureOf< StringView > { typedef SignatureChars< 's' > Chars; };
+template<> struct SignatureOf< ByteView > { typedef SignatureChars< 'a', 'y' > Chars; };
+template< typename T > struct SignatureOf< std::vector< T > > {
+	static_assert(std::is_arithmetic< T >::value && !std::is_same< T, bool >::value, "only arrays of numbers are supported");
+	typedef typename ConcatSignature< SignatureChars< 'a' >, typename SignatureOf< T >::Chars >::Chars Chars;
+};
+
+template< typename... Args > struct SignatureOfArgs;
+template<> struct SignatureOfArgs<> { typedef SignatureChars<> Chars; };
+template< typename T, typename... Rest > struct SignatureOfArgs< T, Rest... > {
+	typedef typename ConcatSignature< typename SignatureOf< typename std::decay< T >::type >::Chars, typename SignatureOfArgs< Rest... >::Chars >::Chars Chars;
+};
+
+template< typename Chars > struct SignatureString;
+template< char... C > struct SignatureString< SignatureChars< C... > > {
+	static const char value[sizeof...(C) + 1];
+};
+template< char... C > const char SignatureString< SignatureChars< C... > >::value[sizeof...(C) + 1] = { C..., '\0' };
+
+// Returns the AllJoyn signature of the argument list, eg. Signature< int32_t, std::string >() is "is".
+template< typename... Args > inline const char* Signature() {
+	return SignatureString< typename SignatureOfArgs< Args... >::Chars >::value;
+}
+
+// As above, for the result of an Action; a void result has the empty signature.
+template< typename Ret > inline const char* ReturnSignature() { return Signature< Ret >(); }
+template<> inline const char* ReturnSignature< void >() { return ""; }
+
+// Used to keep a parameter out of template argument deduction, so that the types come from elsewhere and the values
+//	are converted to them.
+template< typename T > struct NonDeduced { typedef T type; };
+
+// Marshalling of the supported types into MsgArgs. The MsgArgs refer to the values rather than copying them, so the
+//	values need to outlive the use of the MsgArgs.
+inline QStatus SetMsgArg(ajn::MsgArg& arg, bool value) { return arg.Set("b", value); }
+inline QStatus SetMsgArg(ajn::MsgArg& arg, uint8_t value) { return arg.Set("y", value); }
+inline QStatus SetMsgArg(ajn::MsgArg& arg, int16_t value) { return arg.Set("n", value); }
+inline QStatus SetMsgArg(ajn::MsgArg& arg, uint16_t value) { return arg.Set("q", value); }
+inline QStatus SetMsgArg(ajn::MsgArg& arg, int32_t value) { return arg.Set("i", value); }
+inline QStatus SetMsgArg(ajn::MsgArg& arg, uint32_t value) { return arg.Set("u", value); }
+inline QStatus SetMsgArg(ajn::MsgArg& arg, int64_t value) { return arg.Set("x", value); }
+inline QStatus SetMsgArg(ajn::MsgArg& arg, uint64_t value) { return arg.Set("t", value); }
+inline QStatus SetMsgArg(ajn::MsgArg& arg, double value) { return arg.Set("d", value); }
+inline QStatus SetMsgArg(ajn::MsgArg& arg, const char* value) { return arg.Set("s", value); }
+inline QStatus SetMsgArg(ajn::MsgArg& arg, const std::string& value) { return arg.Set("s", value.c_str()); }
+inline QStatus SetMsgArg(ajn::MsgArg& arg, const StringView& value) {
+	// A view isn't guaranteed to be terminated, so unlike the other strings this one is copied into the MsgArg
+	const std::string copy(value.ToString());
+	const QStatus status = arg.Set("s", copy.c_str());
+	arg.Stabilize();
+	return status;
+}
+inline QStatus SetMsgArg(ajn::MsgArg& arg, const ByteView& value) { return arg.Set("ay", value.mLength, value.mData); }
+template< typename T > inline QStatus SetMsgArg(ajn::MsgArg& arg, const std::vector< T >& value) {
+	return arg.Set(Signature< std::vector< T > >(), value.size(), value.empty() ? NULL : &value[0]);
+}
+
+inline bool MarshalArgs(ajn::MsgArg*) {
+	return true;
+}
+
+// Marshals each value into consecutive elements of 'args'.
+template< typename T, typename... Rest > inline bool MarshalArgs(ajn::MsgArg* args, const T& value, const Rest&... rest) {
+	return SetMsgArg(*args, value) == ER_OK && MarshalArgs(args + 1, rest...);
+}
+
+// Unmarshalling of the supported types out of MsgArgs. StringView and ByteView borrow from the MsgArg, the other types
+//	are copies.
+inline bool GetMsgArg(const ajn::MsgArg& arg, bool& value) { return arg.Get("b", &value) == ER_OK; }
+inline bool GetMsgArg(const ajn::MsgArg& arg, uint8_t& value) { return arg.Get("y", &value) == ER_OK; }
+inline bool GetMsgArg(const ajn::MsgArg& arg, int16_t& value) { return arg.Get("n", &value) == ER_OK; }
+inline bool GetMsgArg(const ajn::MsgArg& arg, uint16_t& value) { return arg.Get("q", &value) == ER_OK; }
+inline bool GetMsgArg(const ajn::MsgArg& arg, int32_t& value) { return arg.Get("i", &value) == ER_OK; }
+inline bool GetMsgArg(const ajn::MsgArg& arg, uint32_t& value) { return arg.Get("u", &value) == ER_OK; }
+inline bool GetMsgArg(const ajn::MsgArg& arg, int64_t& value) { return arg.Get("x", &value) == ER_OK; }
+inline bool GetMsgArg(const ajn::MsgArg& arg, uint64_t& value) { return arg.Get("t", &value) == ER_OK; }
+inline bool GetMsgArg(const ajn::MsgArg& arg, double& value) { return arg.Get("d", &value) == ER_OK; }
+inline bool GetMsgArg(const ajn::MsgArg& arg, StringView& value) {
+	const bool result = arg.typeId == ajn::ALLJOYN_STRING;
+	value = result ? StringView(arg.v_string.str, arg.v_string.len) : StringView();
+	return result;
+}
+inline bool GetMsgArg(const ajn::MsgArg& arg, std::string& value) {
+	StringView view;
+	const bool result = GetMsgArg(arg, view);
+	value = view.ToString();
+	return result;
+}
+inline bool GetMsgArg(const ajn::MsgArg& arg, ByteView& value) {
+	size_t length = 0;
+	uint8_t* data = NULL;
+	const bool result = arg.Get("ay", &length, &data) == ER_OK;
+	value = ByteView(data, length);
+	return result;
+}
+template< typename T > inline bool GetMsgArg(const ajn::MsgArg& arg, std::vector< T >& value) {
+	size_t length = 0;
+	T* data = NULL;
+	const bool result = arg.Get(Signature< std::vector< T > >(), &length, &data) == ER_OK;
+	value.assign(data, data + (result ? length : 0));
+	return result;
+}
+
+// A compile time list of indices, used to unpack a std::tuple into a parameter list.
+template< size_t... I > struct IndexSequence {};
+template< size_t N, size_t... I > struct MakeIndexSequence : MakeIndexSequence< N - 1, N - 1, I... > {};
+template< size_t... I > struct MakeIndexSequence< 0, I... > { typedef IndexSequence< I... > Type; };
+
+// Unmarshals consecutive elements of 'args' into each element of 'values'.
+template< typename... T, size_t... I > inline bool UnmarshalArgs(const ajn::MsgArg* args, std::tuple< T... >& values, IndexSequence< I... >) {
+	const bool results[] = { GetMsgArg(args[I], std::get< I >(values))..., true };
+	for(size_t index = 0; index < sizeof...(I); ++index) {
+		if(!results[index]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+} // namespace twobulls
+
+#endif // TWOBULLS_SIGNATURE_H
@@ -19,15 +19,37 @@
 #ifndef TWOBULLS_STARTALLJOYN_H
 #define TWOBULLS_STARTALLJOYN_H
 
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <string.h>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <alljoyn/BusObject.h>
+#include <alljoyn/InterfaceDescription.h>
 #include <alljoyn/MessageReceiver.h>
+#include <alljoyn/SessionListener.h>
 #include <alljoyn/SessionPortListener.h>
 
-// Enable Logging
-#define ENABLE_TBSTARTALLJOYN_LOGGING
+#include "TBAboutDescription.h"
+#include "TBActionCallable.h"
+#include "TBAdmissionControl.h"
+#include "TBBusBackend.h"
+#include "TBClock.h"
+#include "TBEventHistory.h"
+#include "TBEventQueue.h"
+#include "TBIntrospection.h"
+#include "TBLifecycleStats.h"
+#include "TBMetrics.h"
+#include "TBSessionTable.h"
+#include "TBSignature.h"
+#include "TBWorkerPool.h"
 
 // Forward Declarations
 namespace ajn {
@@ -36,22 +58,181 @@ namespace ajn {
 	class AboutIconObj;
 	class AboutObj;
 	class BusAttachment;
-	class InterfaceDescription;
 }
 
 namespace twobulls {
 
+// An EventHandle identifies an Event by its position in the EventDescriptors given to TBStartAllJoyn. It can be looked
+//	up once with TBStartAllJoyn::GetEventHandle and then used to Trigger the Event without a per call name lookup.
+typedef size_t EventHandle;
+const EventHandle INVALID_EVENT_HANDLE = static_cast< EventHandle >(-1);
+
+// How the Signals of Events reach consumers.
+enum EventDelivery {
+	EVENT_DELIVERY_SESSIONLESS,	// as sessionless Signals, which consumers fetch from the router's cache
+	EVENT_DELIVERY_SESSION,		// to the members of a multipoint session, or sessionless while there are none
+	EVENT_DELIVERY_BOTH			// to the members of a multipoint session, and sessionless for consumers not in it
+};
+
+// The name of the built in Action added by TBStartAllJoyn::SetEventHistoryOptions.
+const char* const EVENT_HISTORY_ACTION_NAME = "GetEventsSince";
+
+// The name of the built in Property added by TBStartAllJoyn::SetMetricsProperty.
+const char* const METRICS_PROPERTY_NAME = "Metrics";
+
+// An optional limit on how often an Event is actually emitted when it is Triggered, useful for physical inputs that
+//	bounce or burst.
+struct EmissionPolicy {
+	enum Mode {
+		EMIT_ALWAYS,			// every Trigger is emitted
+		EMIT_MIN_INTERVAL,		// Triggers within 'interval' of the last emission are suppressed
+		EMIT_TRAILING,			// Triggers within 'interval' of the last emission are coalesced into a single emission at
+								//	the end of the interval. A Trigger after a quiet interval is still emitted right away,
+								//	so this is leading and trailing edge rather than trailing edge alone
+		EMIT_MAX_PER_WINDOW		// at most 'maxCount' Triggers are emitted per 'interval' window, the rest are suppressed
+	};
+
+	EmissionPolicy(Mode mode = EMIT_ALWAYS, uint32_t intervalMs = 0, uint32_t maxCount = 0) :
+		mMode(mode)
+		,mIntervalMs(intervalMs)
+		,mMaxCount(maxCount)
+	{};
+
+	static EmissionPolicy MinInterval(uint32_t intervalMs) { return EmissionPolicy(EMIT_MIN_INTERVAL, intervalMs); };
+	static EmissionPolicy Trailing(uint32_t intervalMs) { return EmissionPolicy(EMIT_TRAILING, intervalMs); };
+	static EmissionPolicy MaxPerWindow(uint32_t maxCount, uint32_t intervalMs) { return EmissionPolicy(EMIT_MAX_PER_WINDOW, intervalMs, maxCount); };
+
+	Mode mMode;
+	uint32_t mIntervalMs;
+	uint32_t mMaxCount;
+};
+
 // A minimal description of a sessionless parameterless Signal that can be emitted by TBStartAllJoyn.
 // A Signal with a description is called an Event.
 struct EventDescriptor {
 	// 	'name' is used to identify the Event and can be used to Trigger the Event.
 	//	'description' is a single language localized sentence used to describe what the Signal is for.
-	EventDescriptor(const std::string& name, const std::string& description) :
+	//	'policy' optionally limits how often Triggering the Event results in a Signal.
+	//	'timeToLive' is how many seconds the router keeps each sessionless Signal around for new consumers; zero is for
+	//	 as long as it can.
+	//	'supersede' cancels the previous Signal of the Event as each new one is emitted, which suits Events that report
+	//	 a state, so that new consumers only receive the current one rather than a backlog of obsolete ones.
+	EventDescriptor(const std::string& name, const std::string& description, const EmissionPolicy& policy = EmissionPolicy(),
+					uint16_t timeToLive = 0, bool supersede = false) :
 		mName(name)
 		,mDescription(description)
+		,mPolicy(policy)
+		,mTimeToLive(timeToLive)
+		,mSupersede(supersede)
+		,mSignature()
+		,mArgNames()
+		,mArgCount(0)
 	{};
 	std::string mName;
 	std::string mDescription;
+	EmissionPolicy mPolicy;
+	uint16_t mTimeToLive;
+	bool mSupersede;
+	// These are only set by TypedEventDescriptor.
+	std::string mSignature;
+	std::string mArgNames;
+	size_t mArgCount;
+};
+
+// A description of an Event that carries data. The Signal signature is derived from 'Args' at compile time, eg.
+//	TypedEventDescriptor< int32_t, std::string >("Level", "Level Changed", "level,source") describes a Signal with
+//	the signature "is". Such an Event is Triggered with a TypedEventHandle and the values of the arguments.
+template< typename... Args >
+struct TypedEventDescriptor :
+	public EventDescriptor
+{
+	// 	'argNames' is an optional comma separated list of names for the arguments.
+	TypedEventDescriptor(const std::string& name, const std::string& description, const std::string& argNames = std::string(), const EmissionPolicy& policy = EmissionPolicy(),
+						uint16_t timeToLive = 0, bool supersede = false) :
+		EventDescriptor(name, description, policy, timeToLive, supersede)
+	{
+		mSignature = Signature< Args... >();
+		mArgNames = argNames;
+		mArgCount = sizeof...(Args);
+	};
+};
+
+// An EventHandle that also carries the argument types of the Event it identifies.
+template< typename... Args >
+struct TypedEventHandle {
+	TypedEventHandle(EventHandle handle = INVALID_EVENT_HANDLE) :
+		mHandle(handle)
+	{};
+	EventHandle mHandle;
+};
+
+// The per Event counts of Triggers that the EmissionPolicy kept from being emitted.
+struct EventStats {
+	EventStats() :
+		mSuppressed(0)
+		,mCoalesced(0)
+	{};
+	uint64_t mSuppressed;
+	uint64_t mCoalesced;
+};
+
+class TBStartAllJoyn;
+class TBStartAllJoynHost;
+struct ActionDescriptor;
+
+// Unpacks the arguments of a typed Action, calls its handler and passes its result on to the ActionReply.
+typedef QStatus (*ActionInvoker)(TBStartAllJoyn& object, const ActionDescriptor& action, const ajn::MsgArg* args, size_t argCount, ActionReply& reply);
+
+// A member function of TBStartAllJoyn of any signature, stored as raw bytes; the ActionInvoker of a typed Action knows
+//	the actual type to copy it back out as.
+struct TypedActionHandler {
+	template< typename Handler > void Store(Handler handler) {
+		static_assert(sizeof(Handler) == sizeof(mBytes), "member function pointers are expected to be the same size");
+		memcpy(mBytes, &handler, sizeof(mBytes));
+	};
+	template< typename Handler > Handler Load() const {
+		Handler handler;
+		memcpy(&handler, mBytes, sizeof(mBytes));
+		return handler;
+	};
+	unsigned char mBytes[sizeof(void (TBStartAllJoyn::*)())];
+};
+
+// Where the handler of an Action runs when the Action is invoked.
+enum ActionDispatch {
+	ACTION_DISPATCH_DEFAULT,	// as per ActionPoolOptions
+	ACTION_DISPATCH_INLINE,		// on the AllJoyn dispatcher thread, which holds up other incoming calls until it returns
+	ACTION_DISPATCH_POOL		// on the worker pool of the TBStartAllJoyn, if it has one
+};
+
+// Configuration of the worker pool that Action handlers can be dispatched onto.
+struct ActionPoolOptions {
+	//	'threadCount' is the number of worker threads. Zero means there is no pool and every handler runs inline.
+	//	'poolByDefault' decides where the handlers of ACTION_DISPATCH_DEFAULT Actions run.
+	ActionPoolOptions(size_t threadCount = 4, bool poolByDefault = true) :
+		mThreadCount(threadCount)
+		,mPoolByDefault(poolByDefault)
+	{};
+	size_t mThreadCount;
+	bool mPoolByDefault;
+};
+
+// A snapshot of the dispatch counters of an Action.
+struct ActionStats {
+	ActionStats() :
+		mQueueDepth(0)
+		,mRunning(0)
+		,mCompleted(0)
+		,mTotalWaitNs(0)
+		,mTotalLatencyNs(0)
+		,mMaxLatencyNs(0)
+	{};
+	uint64_t mQueueDepth;		// invocations waiting for a worker or for the concurrency limit
+	uint64_t mRunning;
+	uint64_t mCompleted;
+	uint64_t mTotalWaitNs;		// time between being received and the handler being called
+	uint64_t mTotalLatencyNs;	// time spent in the handler
+	uint64_t mMaxLatencyNs;
 };
 
 // A minimal description of a parameterless Method that can be called on TBStartAllJoyn.
@@ -60,26 +241,146 @@ struct ActionDescriptor {
 	// 	'name' is used to identify the Action.
 	//	'description' is a single language localized sentence used to describe what the Method is for.
 	//	'handler' is a member function of the particular TBStartAllJoyn that is called when the Action is invoked.
-	ActionDescriptor(const std::string& name, const std::string& description, ajn::MessageReceiver::MethodHandler handler) :
+	//	'dispatch' is where the handler runs.
+	//	'maxConcurrency' limits how many invocations of a pooled handler run at once; zero means no limit.
+	ActionDescriptor(const std::string& name, const std::string& description, ajn::MessageReceiver::MethodHandler handler,
+					ActionDispatch dispatch = ACTION_DISPATCH_DEFAULT, size_t maxConcurrency = 0) :
 		mName(name)
 		,mDescription(description)
 		,mHandler(handler)
+		,mDispatch(dispatch)
+		,mMaxConcurrency(maxConcurrency)
+		,mInputSignature()
+		,mOutputSignature()
+		,mArgNames()
+		,mAnnotation(ajn::MEMBER_ANNOTATE_NO_REPLY)
+		,mInvoker(NULL)
+		,mTypedHandler()
+		,mCallable()
 	{};
 	std::string mName;
 	std::string mDescription;
 	ajn::MessageReceiver::MethodHandler mHandler;
+	ActionDispatch mDispatch;
+	size_t mMaxConcurrency;
+	// These are only set by TypedActionDescriptor.
+	std::string mInputSignature;
+	std::string mOutputSignature;
+	std::string mArgNames;
+	uint8_t mAnnotation;
+	ActionInvoker mInvoker;
+	TypedActionHandler mTypedHandler;
+	ActionCallable mCallable;
+};
+
+template< typename Ret, typename... Args > struct TypedActionInvoker;
+template< typename Function, typename Ret, typename... Args > struct CallableActionInvoker;
+
+// A description of an Action that takes arguments and replies with a result. The Method signatures are derived from
+//	'Ret(Args...)' at compile time, and the arguments are unpacked straight into the handler's parameters, eg. a
+//	TypedActionDescriptor< int32_t(int32_t, twobulls::StringView) > calls a handler 'int32_t Handler(int32_t, StringView)'.
+//	StringView and ByteView parameters borrow from the incoming message, so high rate Actions don't allocate per call.
+template< typename Function > struct TypedActionDescriptor;
+template< typename Ret, typename... Args >
+struct TypedActionDescriptor< Ret(Args...) > :
+	public ActionDescriptor
+{
+	//	'handler' is a member function of the particular TBStartAllJoyn, or a class that inherits from it.
+	// 	'argNames' is an optional comma separated list of names for the arguments followed by the result.
+	template< typename Derived >
+	TypedActionDescriptor(const std::string& name, const std::string& description, Ret (Derived::*handler)(Args...), const std::string& argNames = std::string(),
+						ActionDispatch dispatch = ACTION_DISPATCH_DEFAULT, size_t maxConcurrency = 0) :
+		ActionDescriptor(name, description, NULL, dispatch, maxConcurrency)
+	{
+		mInputSignature = Signature< Args... >();
+		mOutputSignature = ReturnSignature< Ret >();
+		mArgNames = argNames;
+		mAnnotation = 0;
+		mInvoker = &TypedActionInvoker< Ret, Args... >::Invoke;
+		mTypedHandler.Store(static_cast< Ret (TBStartAllJoyn::*)(Args...) >(handler));
+	};
+
+	//	'function' is any callable taking 'Args...' and returning 'Ret', eg. a lambda or a std::function, so an object
+	//	 can be made up of Actions at runtime without a class of its own. It is called as const, and from as many
+	//	 threads at once as the dispatch allows, so it shouldn't be a mutable lambda.
+	template< typename Function >
+	TypedActionDescriptor(const std::string& name, const std::string& description, Function function, const std::string& argNames = std::string(),
+						ActionDispatch dispatch = ACTION_DISPATCH_DEFAULT, size_t maxConcurrency = 0) :
+		ActionDescriptor(name, description, NULL, dispatch, maxConcurrency)
+	{
+		mInputSignature = Signature< Args... >();
+		mOutputSignature = ReturnSignature< Ret >();
+		mArgNames = argNames;
+		mAnnotation = 0;
+		mInvoker = &CallableActionInvoker< Function, Ret, Args... >::Invoke;
+		mCallable = ActionCallable(function);
+	};
+};
+
+// An identifier for a Property, as returned by TBStartAllJoyn::GetPropertyHandle.
+typedef size_t PropertyHandle;
+const PropertyHandle INVALID_PROPERTY_HANDLE = static_cast< PropertyHandle >(-1);
+
+// A description of a Property; a piece of the state of the BusObject that consumers can read at any time, and are
+//	notified of changes to, rather than having to piece it together from Events.
+struct PropertyDescriptor {
+	// 	'name' is used to identify the Property.
+	//	'description' is a single language localized sentence used to describe what the Property is.
+	//	'signature' is the AllJoyn signature of its value.
+	//	'writable' lets consumers set the value as well as read it.
+	PropertyDescriptor(const std::string& name, const std::string& description, const std::string& signature, bool writable = false) :
+		mName(name)
+		,mDescription(description)
+		,mSignature(signature)
+		,mWritable(writable)
+		,mEmitsChanged(true)
+	{};
+	std::string mName;
+	std::string mDescription;
+	std::string mSignature;
+	bool mWritable;
+	bool mEmitsChanged;	// whether consumers are notified of changes, which only a built in Property opts out of
+};
+
+// A description of a Property of type 'T', whose signature is derived at compile time as for TypedEventDescriptor.
+template< typename T >
+struct TypedPropertyDescriptor :
+	public PropertyDescriptor
+{
+	TypedPropertyDescriptor(const std::string& name, const std::string& description, bool writable = false) :
+		PropertyDescriptor(name, description, Signature< T >(), writable)
+	{};
+};
+
+// The steps of TBStartAllJoyn::StartAsync, as reported to its StartCallback.
+enum StartPhase {
+	START_PHASE_RUNTIME,		// the process wide AllJoyn runtime is initialized
+	START_PHASE_BUS,			// the BusAttachment is created and started
+	START_PHASE_INTERFACE,		// the interface of Events and Actions is defined
+	START_PHASE_ABOUT_DATA,		// the About data is parsed and validated
+	START_PHASE_CONNECT,		// the BusAttachment is connected to the router
+	START_PHASE_OBJECT,			// the BusObject is registered
+	START_PHASE_SESSION_PORT,	// the session port is bound
+	START_PHASE_ANNOUNCE,		// the About announcement is made
+	START_PHASE_COMPLETE		// the start is over, successfully or not
 };
 
+// Called as each StartPhase completes. 'result' is false for the phase that failed, after which only
+//	START_PHASE_COMPLETE follows.
+typedef std::function< void(StartPhase phase, bool result) > StartCallback;
+
 // A simplified AllJoyn BusObject that takes care of initializing AllJoyn, registering appropriate interfaces, starting
 //  appropriate processes, and announcing to the wider network its presence. It also provides a facility for triggering
 //  Events and handling Actions.
 //
 // The simplifications involve a few limitations that a more direct usage of the AllJoyn API would unlock:
 //	* The BusObject pathname is intrinsincally linked to the interface name and port number
-//	* The Events and Actions are parameterless
+//	* The Events and Actions are parameterless, other than those described with TypedEventDescriptor and
+//	 TypedActionDescriptor
 //	* The DefaultLanguage is the only language that the BusObject will advertise
 //
-// There are two main usages:
+// There are two main usages, and either can be hosted on a BusAttachment shared with other objects by registering with
+//	a TBStartAllJoynHost rather than calling Start:
 //	1. No Actions: Instantiate a twobulls::TBStartAllJoyn with appropriate parameters and TriggerEvents on that instance
 //	 as required
 //	2. With Actions: Define a custom class that inherits from twobulls::TBStartAllJoyn. This class will have extra member
@@ -89,6 +390,8 @@ struct ActionDescriptor {
 class TBStartAllJoyn :
 	public ajn::BusObject
 	,public ajn::SessionPortListener
+	,public ajn::SessionListener
+	,public TBBusEndpoint
 {
 	public:
 		// The constructor requires some configuration data to appropriately initialize and announce a custom service.
@@ -103,40 +406,322 @@ class TBStartAllJoyn :
 		// 'events' vector is a list of EventDescriptors which concisely describe a set of sessionless Events this BusObject
 		//	 may generate.
 		// 'actions' vector is a list of ActionDescriptors which concisely describe a set of Actions this BusObject can handle.
+		// 'properties' vector is a list of PropertyDescriptors which concisely describe the state this BusObject exposes.
 		TBStartAllJoyn(const std::string& aboutXML, const std::string& pathName, const ajn::SessionPort port, 
 						const std::vector< EventDescriptor >& events = std::vector< EventDescriptor >(), 
-						const std::vector< ActionDescriptor >& actions = std::vector< ActionDescriptor >());
+						const std::vector< ActionDescriptor >& actions = std::vector< ActionDescriptor >(),
+						const std::vector< PropertyDescriptor >& properties = std::vector< PropertyDescriptor >());
 		
 		virtual ~TBStartAllJoyn();
 
 		// This does the bulk of the AllJoyn setup, calling this method should result in a new device announcing
 		//	its presence to the wider network.
-		// Returns true on success and false on failure, in conjunction with ENABLE_TBSTARTALLJOYN_LOGGING; errors can
-		//	be tracked down to particular configuration issues.
+		// Returns true on success and false on failure, in conjunction with ENABLE_TBSTARTALLJOYN_LOGGING (see TBLog.h);
+		//	errors can be tracked down to particular configuration issues.
 		bool Start();
 
+		// This does the same as Start, but on a thread of its own so that the caller isn't held up. The interface and
+		//	About data are prepared while the router connection is being made, and 'callback' is called, on that
+		//	thread, as each StartPhase completes. The returned future holds the result of the start; note that its
+		//	destructor waits for the start to finish.
+		std::future< bool > StartAsync(const StartCallback& callback = StartCallback());
+
+		// Suspend withdraws the announcement and disconnects from the router, for a device that goes offline to save
+		//	power, and Resume reconnects and announces again. Unlike Stop and Start, the BusAttachment, the interface
+		//	and the registration of the object are kept, so a Resume costs a reconnect rather than a rebuild. Sessions
+		//	are lost on Suspend, and Events Triggered while suspended aren't sent, though Property changes are notified
+		//	on Resume. Only an object with a BusAttachment of its own can be suspended, and neither may be called at the
+		//	same time as Start or Stop.
+		// Returns false if the object isn't started, or is already suspended (or for Resume, isn't), or if it fails
+		//	to unbind the session port and disconnect, or to reconnect. Either way the steps taken are undone, so the
+		//	object carries on as it was and a failed Resume can be retried.
+		bool Suspend();
+		bool Resume();
+		bool IsSuspended() const;
+
 		// This does the teardown of AllJoyn, calling this method should result in the new device no longer being
-		//	accessible.
+		//	accessible. A hosted object is unregistered from its TBStartAllJoynHost instead, unless the host has been
+		//	stopped or destroyed already, which leaves the object without one.
 		void Stop();
 
 		// This causes the named Event to be triggered by the TBStartAllJoyn, this notifies all listeners in the
 		//	wider network to such an Event to hear this Event and do things.
+		// Returns false on failure; a Trigger held back by the Event's EmissionPolicy is not a failure.
 		bool TriggerEvent(const std::string& eventName);
 
+		// As above, but for an Event previously looked up with GetEventHandle. This is the cheaper call for Events
+		//	that are Triggered frequently.
+		bool TriggerEvent(EventHandle event);
+
+		// Returns the EventHandle of the named Event, or INVALID_EVENT_HANDLE if there is no such Event. The handle
+		//	remains valid for the lifetime of the TBStartAllJoyn, across Stop and Start.
+		EventHandle GetEventHandle(const std::string& eventName) const;
+
+		// Looks up the TypedEventHandle of the named Event. Returns false if there is no such Event or if its
+		//	signature doesn't match 'Args'.
+		template< typename... Args >
+		bool GetEventHandle(const std::string& eventName, TypedEventHandle< Args... >& event) const {
+			const EventHandle handle = GetEventHandle(eventName);
+			const bool result = handle != INVALID_EVENT_HANDLE && mEvents[handle].mSignature == Signature< Args... >();
+			event.mHandle = result ? handle : INVALID_EVENT_HANDLE;
+			return result;
+		}
+
+		// Triggers an Event described with TypedEventDescriptor, with the given argument values. The values are
+		//	marshalled into MsgArgs that are allocated once per Event, rather than on every Trigger.
+		template< typename... Args >
+		bool TriggerEvent(TypedEventHandle< Args... > event, const typename NonDeduced< Args >::type&... args) {
+			const uint64_t triggeredAt = MonotonicNanoseconds();
+			bool result = IsEventReady(event.mHandle);
+
+			if(result) {
+				EventState& state = mEventStates[event.mHandle];
+				std::lock_guard< std::mutex > lock(state.mArgsMutex);
+
+				if(AdmitEvent(event.mHandle)) {
+					result = MarshalArgs(state.mArgs, args...) && EmitEvent(event.mHandle, state.mArgs, sizeof...(Args));
+				} else if(mEvents[event.mHandle].mPolicy.mMode == EmissionPolicy::EMIT_TRAILING) {
+					// The trailing emission carries the latest values, which have to outlive the caller's
+					result = MarshalArgs(state.mArgs, args...);
+					for(size_t index = 0; index < sizeof...(Args); ++index) {
+						state.mArgs[index].Stabilize();
+					}
+				}
+			}
+
+			CountTrigger(triggeredAt);
+
+			return result;
+		}
+
+		// This queues the Event to be Triggered on the TBStartAllJoyn's emitter thread, so the caller never waits on the
+		//	router. The queue is disabled until SetEventQueueOptions is called with a non-zero capacity.
+		// Returns false if the Event was dropped as per the overflow policy, or if the queue isn't running.
+		bool TriggerEventAsync(const std::string& eventName);
+		bool TriggerEventAsync(EventHandle event);
+
+		// Configures the queue used by TriggerEventAsync; this must be called before Start. Returns false otherwise.
+		bool SetEventQueueOptions(const EventQueueOptions& options);
+
+		// Returns the counters of the queue used by TriggerEventAsync.
+		EventQueueStats GetEventQueueStats() const;
+
+		// Returns how many Triggers of the Event were suppressed or coalesced by its EmissionPolicy.
+		EventStats GetEventStats(EventHandle event) const;
+
+		// Configures the worker pool that Action handlers are dispatched onto, so that a slow handler doesn't hold up the
+		//	AllJoyn dispatcher thread. There is no pool until this is called; it must be called before Start.
+		// Returns false otherwise.
+		bool SetActionPoolOptions(const ActionPoolOptions& options);
+
+		// Keeps a record of the most recently emitted Events, and adds the GetEventsSince Action through which a late
+		//	joiner can catch up on them in one call rather than polling; it takes the last sequence number seen, and
+		//	replies with the (sequence number, Unix time in milliseconds, Event name) of each Event after it. There is no
+		//	history until this is called; it must be called before Start.
+		// Returns false otherwise.
+		bool SetEventHistoryOptions(const EventHistoryOptions& options);
+
+		// Chooses how the interface is defined on the BusAttachment; see InterfaceOptions. Building it from introspection
+		//	XML makes a noticeable difference to starting objects with hundreds of members. It must be called before
+		//	Start, and has no effect on an object on a TBBusBackend.
+		// Returns false otherwise.
+		bool SetInterfaceOptions(const InterfaceOptions& options);
+
+		// Chooses how Events are delivered. Session delivery binds the session port as multipoint, and sends each Event
+		//	straight to the joined members, which avoids the round trip through the router's sessionless cache. It must
+		//	be called before Start, and has no effect on an object hosted by a TBStartAllJoynHost.
+		// Returns false otherwise.
+		bool SetEventDelivery(EventDelivery delivery);
+
+		// Runs the object on 'backend' rather than on a BusAttachment of its own, eg. on a TBLoopbackBus to exercise
+		//	it without a router. The backend isn't owned, and must outlive the object's Stop. Calls through a
+		//	TBAllJoynBackend are dispatched as on the object's own BusAttachment, and plain MethodHandlers reply
+		//	through the backend; calls on a TBLoopbackBus carry no Message, so only typed Actions can be called there,
+		//	on the calling thread. An object on a backend can't be hosted by a TBStartAllJoynHost, and StartAsync only
+		//	reports its completion. It must be called before Start; NULL goes back to AllJoyn.
+		// Returns false otherwise.
+		bool SetBusBackend(TBBusBackend* backend);
+
+		// Looks up a Property by name. Returns INVALID_PROPERTY_HANDLE if there is no such Property.
+		PropertyHandle GetPropertyHandle(const std::string& propertyName) const;
+
+		// Updates the cached value of a Property, which is what consumers are served when they read it. Consumers are
+		//	notified of changes with PropertiesChanged, coalesced as per SetPropertyFlushInterval. The value can be set
+		//	before Start. Returns false if the value doesn't match the signature of the Property.
+		// Writes by consumers to a writable Property update the same cached value, and are picked up with GetProperty.
+		bool SetProperty(PropertyHandle property, const ajn::MsgArg& value);
+
+		template< typename T >
+		bool SetProperty(PropertyHandle property, const T& value) {
+			ajn::MsgArg arg;
+			bool result = property < mProperties.size() && mProperties[property].mSignature == Signature< T >() && SetMsgArg(arg, value) == ER_OK;
+
+			if(result) {
+				arg.Stabilize();
+				result = SetProperty(property, arg);
+			}
+
+			return result;
+		};
+
+		// Returns a copy of the cached value of a Property. Returns false if it has never been set.
+		bool GetProperty(PropertyHandle property, ajn::MsgArg& value) const;
+
+		// Changes to Properties are notified together, in one PropertiesChanged, no more often than every 'intervalMs';
+		//	zero notifies them as soon as the emitter gets to them. The default is 100ms. It must be called before Start.
+		// Returns false otherwise.
+		bool SetPropertyFlushInterval(uint32_t intervalMs);
+
+		// The same as the GetEventsSince Action, for local use.
+		std::vector< EventRecord > GetEventsSince(uint64_t since) const;
+
+		// Returns the dispatch counters of the named Action.
+		ActionStats GetActionStats(const std::string& actionName) const;
+
+		// Returns how long each step of the last Start or StartAsync, and of any Stop, Suspend or Resume since, took.
+		LifecycleStats GetLifecycleStats() const;
+
+		// Returns the members of the sessions joined to the object, with what they have sent it. This doesn't wait on
+		//	sessions being joined or lost.
+		std::vector< SessionInfo > GetSessions() const;
+
+		// Limits who may join a session with the object, and how often; see AdmissionOptions. This can be called at any
+		//	time, and has no effect on an object hosted by a TBStartAllJoynHost, which has its own.
+		void SetAdmissionOptions(const AdmissionOptions& options);
+		AdmissionStats GetAdmissionStats() const;
+
+		// Changes the About data of a running object without a Stop and Start, so its sessions carry on. Only the
+		//	fields that differ from the current About data are set on it, and the object is Announced again if any did.
+		//	'aboutXML' has the same form as in the constructor, though fields left out of it keep their values, as do
+		//	those not in 'fields', which are in the default language. Before Start this only changes what Start will
+		//	announce. It must not be called at the same time as Start or Stop. A new AppName is also the name of the
+		//	BusAttachment, and the description of the interface, from the next Start on.
+		// Returns false if the About data would be invalid, or changes the DefaultLanguage, or if the object is hosted
+		//	by a TBStartAllJoynHost, whose About data is its own; the About data is left as it was.
+		bool UpdateAbout(const std::string& aboutXML);
+		bool UpdateAbout(const std::map< std::string, std::string >& fields);
+
+		// Returns the counters and latency histograms the object keeps of its Events, Actions, sessions and lifecycle,
+		//	which are always on. They can be exported in the Prometheus text format with TBMetricsRegistry::ToPrometheus
+		//	or WritePrometheusFile, or served on a UNIX domain socket by a TBMetricsSocket.
+		const TBMetricsRegistry& GetMetrics() const;
+
+		// Adds the read only Metrics Property, through which consumers can read the same metrics as a dictionary of
+		//	name to value (a{sd}, see TBMetricsRegistry::GetValues). Its value is made up each time it is read, so there
+		//	is no notification of its changes. It must be called before Start.
+		// Returns false otherwise, or if there is already a Property of that name.
+		bool SetMetricsProperty(bool enabled);
+
 	protected:
 		// The protected members deal with the intricacies of setting up a valid AllJoyn BusObject, looking into 
 		//	the source, you can see the order of calls and what information is required.
 
  		bool SetupBusAttachment();
+ 		bool CreateBusAttachment();
  		bool DefineInterface();
  		bool AttachInterface();
+ 		bool DefineInterfacesFromXml();
+ 		bool AttachInterfacesFromXml();
+ 		bool BindSessionPort();
  		bool SetupAboutObject();
+ 		bool PrepareAboutData();
+ 		bool AnnounceAboutObject();
+ 		bool RunStartAsync(StartCallback callback);
+ 		void ReportStartPhase(const StartCallback& callback, StartPhase phase, bool result);
+ 		void RecordLifecycleStep(LifecycleStep step, uint64_t startNs, bool result);
+ 		void ClearLifecycleSteps();
+ 		static QStatus ReplyEventsSince(TBStartAllJoyn& object, const ActionDescriptor& action, const ajn::MsgArg* args, size_t argCount, ActionReply& reply);
+		bool StartEmitter();
+		void StopEmitter();
+		void EmitterLoop();
+
+		// AdmitEvent applies the EmissionPolicy to a Trigger, EmitEvent does the actual Signal.
+		bool AdmitEvent(EventHandle event);
+		bool EmitEvent(EventHandle event, const ajn::MsgArg* args = NULL, size_t argCount = 0);
+		bool EmitSessionlessEvent(EventHandle event, const ajn::MsgArg* args, size_t argCount);
+		bool IsEventReady(EventHandle event) const;
+		bool SignalEvent(EventHandle event, const ajn::MsgArg* args, size_t argCount, ajn::SessionId session, uint32_t* serial);
+		bool CancelEventSignal(EventHandle event, uint32_t serial);
+		void CountTrigger(uint64_t triggeredAt);
+		QStatus GetMetricsValue(ajn::MsgArg& value) const;
+		uint64_t FlushTrailingEvents(bool force);
+		uint64_t FlushProperties(bool force);
+		void EmitPropertiesChanged(const char** propertyNames, size_t propertyCount);
+
+		// From BusObject; Properties are served from, and written to, their cached values.
+		QStatus Get(const char* ifcName, const char* propName, ajn::MsgArg& val);
+		QStatus Set(const char* ifcName, const char* propName, ajn::MsgArg& val);
+
+		// The counterparts of Start and Stop for an object on a TBBusBackend.
+		bool IsStarted() const;
+		bool StartOnBackend();
+		void StopOnBackend();
+		BusInterface DescribeInterface() const;
+
+		// From TBBusEndpoint
+		QStatus HandleCall(const BusCall& call, ActionReply& reply);
+		QStatus GetPropertyValue(const char* propertyName, ajn::MsgArg& value);
+		QStatus SetPropertyValue(const char* propertyName, ajn::MsgArg& value);
 
  		// From SessionPortListener
 		bool AcceptSessionJoiner(ajn::SessionPort sessionPort, const char* joiner, const ajn::SessionOpts& opts);
 		void SessionJoined(ajn::SessionPort sessionPort, ajn::SessionId id, const char* joiner);
 
- 		std::string mAboutXML;
+		// From SessionListener
+		void SessionLost(ajn::SessionId sessionId, ajn::SessionListener::SessionLostReason reason);
+		void SessionMemberRemoved(ajn::SessionId sessionId, const char* uniqueName);
+
+		// Replies to a Method call through whichever bus the object is on; plain MethodHandlers reply with these, which
+		//	hide those of ajn::BusObject so that they work the same on a TBBusBackend.
+		QStatus MethodReply(const ajn::Message& message, const ajn::MsgArg* args = NULL, size_t argCount = 0);
+		QStatus MethodReply(const ajn::Message& message, const char* error, const char* errorMessage = NULL);
+		QStatus MethodReply(const ajn::Message& message, QStatus status);
+
+		// The MethodHandler of every Action. DispatchCall runs the Action's handler inline or queues it onto the worker
+		//	pool, for calls on the object's own BusAttachment and those a TBBusBackend passes on with their Message.
+		void DispatchAction(const ajn::InterfaceDescription::Member* member, ajn::Message& message);
+		void DispatchCall(size_t action, const ajn::InterfaceDescription::Member* member, ajn::Message& message, uint64_t received);
+		bool QueueAction(size_t action, const ajn::InterfaceDescription::Member* member, ajn::Message& message, uint64_t received);
+		void RunPooledAction(size_t action, const ajn::InterfaceDescription::Member* member, ajn::Message& message, uint64_t received);
+		void RunAction(size_t action, const ajn::InterfaceDescription::Member* member, ajn::Message& message, uint64_t received);
+		void CompleteAction(size_t action, uint64_t received, uint64_t started, bool result);
+		bool UsesActionPool(const ActionDescriptor& action) const;
+		bool StartActionPool();
+		void StopActionPool();
+
+		// The counterparts of Start and Stop for an object on the BusAttachment of a TBStartAllJoynHost.
+		friend class TBStartAllJoynHost;
+		bool StartHosted(TBStartAllJoynHost& host);
+		void StopHosted();
+
+		// Sends the result of a typed Action as the reply to its Method call.
+		class MessageActionReply :
+			public ActionReply
+		{
+			public:
+				MessageActionReply(TBStartAllJoyn& object, ajn::Message& message);
+				QStatus Reply(const ajn::MsgArg* args, size_t argCount);
+				bool mReplied;
+
+			private:
+				TBStartAllJoyn& mObject;
+				ajn::Message& mMessage;
+		};
+
+		// Passes the reply to a call that HandleCall runs inline on, noting its size for the session table.
+		class CountingActionReply :
+			public ActionReply
+		{
+			public:
+				CountingActionReply(ActionReply& reply);
+				QStatus Reply(const ajn::MsgArg* args, size_t argCount);
+				size_t mBytes;
+
+			private:
+				ActionReply& mReply;
+		};
+
+ 		TBAboutDescription mAboutDescription;
 		ajn::BusAttachment* mBusAttachment;
 		ajn::AboutData* mAboutData;
 		ajn::AboutObj* mAboutObject;
@@ -144,19 +729,234 @@ class TBStartAllJoyn :
 		ajn::AboutIconObj* mAboutIconObject;
 		std::vector< ActionDescriptor > mActions;
 		size_t mActionCount;
+		std::map< const ajn::InterfaceDescription::Member*, size_t > mActionIndex;
 		std::vector< EventDescriptor > mEvents;
 		size_t mEventCount;
+		std::vector< const ajn::InterfaceDescription::Member* > mEventMembers;
 		const ajn::InterfaceDescription* mInterface;
 		std::string mApplicationName;
 		std::string mInterfaceName;
+		InterfaceOptions mInterfaceOptions;
+		std::string mIntrospectionXml;
+		std::vector< std::string > mInterfaceParts;
 		std::string mLanguage;
 		ajn::SessionPort mSessionPort;
+		EventQueueOptions mEventQueueOptions;
+		TBEventQueue* mEventQueue;
+		std::thread mEmitterThread;
+
+		// The EmissionPolicy bookkeeping of an Event, all lock-free as it is updated by every Trigger. The MsgArgs of a
+		//	typed Event are reused by every Trigger, under mArgsMutex.
+		struct EventState {
+			EventState() :
+				mLastEmitted(0)
+				,mWindow(0)
+				,mPending(false)
+				,mSuppressed(0)
+				,mCoalesced(0)
+				,mLastSerial(0)
+				,mArgs(NULL)
+			{};
+			~EventState() {
+				delete[] mArgs;
+			};
+			std::atomic< uint64_t > mLastEmitted;
+			std::atomic< uint64_t > mWindow;		// the start of the window in milliseconds, high, and its count, low
+			std::atomic< bool > mPending;
+			std::atomic< uint64_t > mSuppressed;
+			std::atomic< uint64_t > mCoalesced;
+			std::atomic< uint32_t > mLastSerial;	// of the last Signal of a superseding Event, zero if there isn't one
+			std::mutex mArgsMutex;
+			ajn::MsgArg* mArgs;
+		};
+		EventState* mEventStates;
+		std::vector< EventHandle > mTrailingEvents;
+
+		// The dispatch bookkeeping of an Action. Invocations held back by the concurrency limit wait in mPending.
+		struct PendingAction {
+			PendingAction(const ajn::InterfaceDescription::Member* member, const ajn::Message& message, uint64_t received) :
+				mMember(member)
+				,mMessage(message)
+				,mReceived(received)
+			{};
+			const ajn::InterfaceDescription::Member* mMember;
+			ajn::Message mMessage;
+			uint64_t mReceived;
+		};
+		struct ActionState {
+			ActionState() :
+				mQueued(0)
+				,mRunning(0)
+				,mCompleted(0)
+				,mTotalWaitNs(0)
+				,mTotalLatencyNs(0)
+				,mMaxLatencyNs(0)
+				,mInFlight(0)
+			{};
+			std::atomic< uint64_t > mQueued;
+			std::atomic< uint64_t > mRunning;
+			std::atomic< uint64_t > mCompleted;
+			std::atomic< uint64_t > mTotalWaitNs;
+			std::atomic< uint64_t > mTotalLatencyNs;
+			std::atomic< uint64_t > mMaxLatencyNs;
+			std::mutex mPendingMutex;
+			size_t mInFlight;
+			std::deque< PendingAction > mPending;
+		};
+		ActionState* mActionStates;
+		ActionPoolOptions mActionPoolOptions;
+		TBWorkerPool* mActionPool;
+		EventHistoryOptions mEventHistoryOptions;
+		TBEventHistory* mEventHistory;
+		EventDelivery mEventDelivery;
+		std::atomic< ajn::SessionId > mEventSession;
+
+		// The cached value of a Property, and whether it has changed since consumers were last notified.
+		struct PropertyState {
+			PropertyState() :
+				mHasValue(false)
+				,mChanged(false)
+			{};
+			mutable std::mutex mMutex;
+			ajn::MsgArg mValue;
+			bool mHasValue;
+			std::atomic< bool > mChanged;
+		};
+		std::vector< PropertyDescriptor > mProperties;
+		std::map< std::string, PropertyHandle > mPropertyIndex;
+		PropertyState* mPropertyStates;
+		std::atomic< bool > mPropertiesChanged;
+		std::atomic< bool > mPropertyFlushForced;
+		uint32_t mPropertyFlushIntervalMs;
+		uint64_t mLastPropertyFlush;
+		TBStartAllJoynHost* mHost;
+		bool mRuntimeAcquired;
+		std::atomic< bool > mSuspended;
+
+		TBBusBackend* mBackend;
+		bool mBackendConnected;
+		std::vector< BusSignalHandle > mBusSignals;
+		std::map< std::string, size_t > mActionNames;
+
+		// The metrics of the object, and the counters and histograms in it that are updated as things happen. The
+		//	lifecycle histograms are indexed by LifecycleStep, and are only there for the steps that are whole calls.
+		struct Instruments {
+			Instruments(TBMetricsRegistry& registry);
+			TBCounter& mEventsTriggered;
+			TBCounter& mEventsEmitted;
+			TBCounter& mEventsFailed;
+			TBCounter& mEventsSuppressed;
+			TBCounter& mEventsCoalesced;
+			TBCounter& mActionsCompleted;
+			TBCounter& mActionsFailed;
+			TBCounter& mSessionsJoined;
+			TBCounter& mSessionsLost;
+			TBLatencyHistogram& mTriggerLatency;
+			TBLatencyHistogram& mActionLatency;
+			TBLatencyHistogram& mSessionJoinLatency;
+			TBLatencyHistogram* mLifecycleLatency[LIFECYCLE_STEP_COUNT];
+		};
+		TBMetricsRegistry mMetrics;
+		Instruments mInstruments;
+		bool mMetricsProperty;
+
+		LifecycleStats mLifecycleStats;
+		mutable std::mutex mLifecycleMutex;
+
+		TBSessionTable mSessions;
+		TBAdmissionControl mAdmission;
 
 	private:
 		// The private members are internal methods for grabbing further configuration detail from the provided configuration.
 
 		bool DigestPathName(const std::string& pathName);
-		bool DigestAboutXML();
+		bool DigestAboutXML(const std::string& aboutXML);
+		bool ApplyAboutUpdate(const TBAboutDescription& updated);
+};
+
+template< typename Ret, typename... Args >
+struct TypedActionInvoker {
+	typedef Ret (TBStartAllJoyn::*Handler)(Args...);
+	typedef std::tuple< typename std::decay< Args >::type... > Values;
+	typedef typename MakeIndexSequence< sizeof...(Args) >::Type Indices;
+
+	static QStatus Invoke(TBStartAllJoyn& object, const ActionDescriptor& action, const ajn::MsgArg* args, size_t argCount, ActionReply& reply) {
+		Values values;
+		if(argCount != sizeof...(Args) || !UnmarshalArgs(args, values, Indices())) {
+			return ER_BUS_BAD_SIGNATURE;
+		}
+		return Call(object, action.mTypedHandler.Load< Handler >(), values, reply, Indices());
+	}
+
+	template< size_t... I >
+	static QStatus Call(TBStartAllJoyn& object, Handler handler, Values& values, ActionReply& reply, IndexSequence< I... >) {
+		const Ret result = (object.*handler)(std::get< I >(values)...);
+		ajn::MsgArg arg;
+		return SetMsgArg(arg, result) == ER_OK ? reply.Reply(&arg, 1) : ER_BUS_BAD_SIGNATURE;
+	}
+};
+
+template< typename... Args >
+struct TypedActionInvoker< void, Args... > {
+	typedef void (TBStartAllJoyn::*Handler)(Args...);
+	typedef std::tuple< typename std::decay< Args >::type... > Values;
+	typedef typename MakeIndexSequence< sizeof...(Args) >::Type Indices;
+
+	static QStatus Invoke(TBStartAllJoyn& object, const ActionDescriptor& action, const ajn::MsgArg* args, size_t argCount, ActionReply& reply) {
+		Values values;
+		if(argCount != sizeof...(Args) || !UnmarshalArgs(args, values, Indices())) {
+			return ER_BUS_BAD_SIGNATURE;
+		}
+		return Call(object, action.mTypedHandler.Load< Handler >(), values, reply, Indices());
+	}
+
+	template< size_t... I >
+	static QStatus Call(TBStartAllJoyn& object, Handler handler, Values& values, ActionReply& reply, IndexSequence< I... >) {
+		(object.*handler)(std::get< I >(values)...);
+		return reply.Reply(NULL, 0);
+	}
+};
+
+// As TypedActionInvoker, for an Action whose handler is the ActionCallable of its descriptor.
+template< typename Function, typename Ret, typename... Args >
+struct CallableActionInvoker {
+	typedef std::tuple< typename std::decay< Args >::type... > Values;
+	typedef typename MakeIndexSequence< sizeof...(Args) >::Type Indices;
+
+	static QStatus Invoke(TBStartAllJoyn& object, const ActionDescriptor& action, const ajn::MsgArg* args, size_t argCount, ActionReply& reply) {
+		Values values;
+		if(argCount != sizeof...(Args) || !UnmarshalArgs(args, values, Indices())) {
+			return ER_BUS_BAD_SIGNATURE;
+		}
+		return Call(action.mCallable.Get< Function >(), values, reply, Indices());
+	}
+
+	template< size_t... I >
+	static QStatus Call(const Function& function, Values& values, ActionReply& reply, IndexSequence< I... >) {
+		const Ret result = function(std::get< I >(values)...);
+		ajn::MsgArg arg;
+		return SetMsgArg(arg, result) == ER_OK ? reply.Reply(&arg, 1) : ER_BUS_BAD_SIGNATURE;
+	}
+};
+
+template< typename Function, typename... Args >
+struct CallableActionInvoker< Function, void, Args... > {
+	typedef std::tuple< typename std::decay< Args >::type... > Values;
+	typedef typename MakeIndexSequence< sizeof...(Args) >::Type Indices;
+
+	static QStatus Invoke(TBStartAllJoyn& object, const ActionDescriptor& action, const ajn::MsgArg* args, size_t argCount, ActionReply& reply) {
+		Values values;
+		if(argCount != sizeof...(Args) || !UnmarshalArgs(args, values, Indices())) {
+			return ER_BUS_BAD_SIGNATURE;
+		}
+		return Call(action.mCallable.Get< Function >(), values, reply, Indices());
+	}
+
+	template< size_t... I >
+	static QStatus Call(const Function& function, Values& values, ActionReply& reply, IndexSequence< I... >) {
+		function(std::get< I >(values)...);
+		return reply.Reply(NULL, 0);
+	}
 };
 
 } // namespace twobulls
@@ -0,0 +1,115 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#ifndef TWOBULLS_STARTALLJOYNHOST_H
+#define TWOBULLS_STARTALLJOYNHOST_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <alljoyn/SessionListener.h>
+#include <alljoyn/SessionPortListener.h>
+
+#include "TBAboutDescription.h"
+#include "TBAdmissionControl.h"
+
+// Forward Declarations
+namespace ajn {
+	class AboutData;
+	class AboutObj;
+	class BusAttachment;
+}
+
+namespace twobulls {
+
+class TBStartAllJoyn;
+
+// A single BusAttachment and About announcement shared by many TBStartAllJoyn objects, for processes like gateways
+//	that present lots of devices at once. Each object registered with the host adds its interface to the shared
+//	BusAttachment and to the objects listed in the host's announcement, rather than setting up an attachment, router
+//	connection and announcement of its own.
+//
+// Usage:
+//	1. Instantiate a twobulls::TBStartAllJoynHost with the About metadata of the process and Start it
+//	2. Instantiate any number of twobulls::TBStartAllJoyn objects as usual, and Register them with the host instead of
+//	 calling their Start. Unregistering, or calling Stop on an object, removes it again
+//
+class TBStartAllJoynHost :
+	public ajn::SessionPortListener
+	,public ajn::SessionListener
+{
+	public:
+		// 'aboutXML' string is the metadata description of the process, as for TBStartAllJoyn.
+		// 'port' is the session port that is announced, and that consumers join to reach any of the hosted objects.
+		TBStartAllJoynHost(const std::string& aboutXML, const ajn::SessionPort port);
+
+		// This stops the host, which detaches every hosted object from it, so the objects may outlive the host. An
+		//	object's Stop must not run on another thread meanwhile.
+		virtual ~TBStartAllJoynHost();
+
+		// This sets up and connects the shared BusAttachment and makes the first announcement.
+		bool Start();
+
+		// This unregisters every hosted object, leaving it without a host, and tears down the shared BusAttachment.
+		void Stop();
+
+		// This sets up the object on the shared BusAttachment. When 'announce' is false, the announcement isn't updated
+		//	until the next call to Announce, which saves re-announcing for every object when registering lots at once.
+		bool Register(TBStartAllJoyn& object, bool announce = true);
+
+		// This removes the object from the shared BusAttachment.
+		void Unregister(TBStartAllJoyn& object, bool announce = true);
+
+		// This re-announces the host with the current set of hosted objects.
+		bool Announce();
+
+		ajn::BusAttachment* GetBusAttachment() const;
+		ajn::SessionPort GetSessionPort() const;
+		size_t GetObjectCount() const;
+
+		// As for TBStartAllJoyn, for the sessions on the shared session port.
+		void SetAdmissionOptions(const AdmissionOptions& options);
+		AdmissionStats GetAdmissionStats() const;
+
+	protected:
+		// From SessionPortListener
+		bool AcceptSessionJoiner(ajn::SessionPort sessionPort, const char* joiner, const ajn::SessionOpts& opts);
+		void SessionJoined(ajn::SessionPort sessionPort, ajn::SessionId id, const char* joiner);
+
+		// From SessionListener
+		void SessionLost(ajn::SessionId sessionId, ajn::SessionListener::SessionLostReason reason);
+		void SessionMemberRemoved(ajn::SessionId sessionId, const char* uniqueName);
+
+		TBAboutDescription mAboutDescription;
+		bool mAboutDescriptionValid;
+		ajn::BusAttachment* mBusAttachment;
+		ajn::AboutData* mAboutData;
+		ajn::AboutObj* mAboutObject;
+		ajn::SessionPort mSessionPort;
+		bool mRuntimeAcquired;
+		TBAdmissionControl mAdmission;
+		std::atomic< size_t > mSessionCount;
+		mutable std::mutex mMutex;
+		std::vector< TBStartAllJoyn* > mObjects;
+};
+
+} // namespace twobulls
+
+#endif // TWOBULLS_STARTALLJOYNHOST_H
@@ -0,0 +1,79 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#ifndef TWOBULLS_WORKERPOOL_H
+#define TWOBULLS_WORKERPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stddef.h>
+#include <thread>
+#include <vector>
+
+namespace twobulls {
+
+// A fixed set of worker threads, each with its own queue of tasks. Submitted tasks are spread across the queues, a
+//	worker runs the tasks of its own queue first and steals from the others when it runs out, so one slow task only
+//	holds up the tasks behind it until another worker comes looking.
+class TBWorkerPool {
+	public:
+		typedef std::function< void() > Task;
+
+		TBWorkerPool(size_t threadCount);
+		~TBWorkerPool();
+
+		// Queues the task to be run by a worker. Returns false once the pool is shutting down.
+		bool Submit(const Task& task);
+
+		// Runs the tasks already queued, then stops and joins the workers.
+		void Shutdown();
+
+		// The number of tasks queued and not yet started.
+		size_t GetQueueDepth() const;
+		size_t GetThreadCount() const;
+
+	private:
+		struct Worker {
+			std::mutex mMutex;
+			std::deque< Task > mTasks;
+			std::thread mThread;
+		};
+
+		void WorkerLoop(size_t index);
+		bool TakeTask(size_t index, Task& task);
+
+		std::vector< Worker* > mWorkers;
+		std::atomic< size_t > mNextWorker;
+		std::atomic< size_t > mQueueDepth;
+		std::atomic< size_t > mSubmitting;
+		std::atomic< bool > mShuttingDown;
+
+		std::mutex mMutex;
+		std::condition_variable mCondition;
+		std::atomic< size_t > mSleeping;
+
+		TBWorkerPool(const TBWorkerPool&);
+		TBWorkerPool& operator=(const TBWorkerPool&);
+};
+
+} // namespace twobulls
+
+#endif // TWOBULLS_WORKERPOOL_H
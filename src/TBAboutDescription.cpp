@@ -0,0 +1,167 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#include "TBAboutDescription.h"
+
+#include "TBLog.h"
+#include "tinyxml2.h"
+
+#include <alljoyn/AboutData.h>
+#include <alljoyn/MsgArg.h>
+
+#define TBABOUTDESCRIPTIONLOG(...) TBLOG(TBLOG_LEVEL_TRACE, "twobulls::TBAboutDescription", __VA_ARGS__)
+
+namespace twobulls {
+
+TBAboutDescription::TBAboutDescription() :
+	mApplicationName()
+	,mLanguage()
+	,mFields()
+{
+}
+
+bool TBAboutDescription::Parse(const char* aboutXML) {
+	TBABOUTDESCRIPTIONLOG("::Parse -> ");
+
+	tinyxml2::XMLDocument xmlDoc;
+
+	mApplicationName.clear();
+	mLanguage.clear();
+	mFields.clear();
+
+	bool result = aboutXML != NULL && xmlDoc.Parse(aboutXML) == tinyxml2::XML_SUCCESS;
+	TBABOUTDESCRIPTIONLOG("::Parse -- xmlDoc.Parse <- %d", result);
+
+	const tinyxml2::XMLElement* root = NULL;
+
+	if(result) {
+		result = (root = xmlDoc.RootElement()) != NULL;
+		TBABOUTDESCRIPTIONLOG("::Parse -- xmlDoc.RootElement <- %d", result);
+	}
+
+	if(result) {
+		result = std::string(root->Name()) == "About";
+		TBABOUTDESCRIPTIONLOG("::Parse -- root->Name == 'About' <- %d", result);
+	}
+
+	if(result) {
+		for(const tinyxml2::XMLElement* child = root->FirstChildElement(); child != NULL; child = child->NextSiblingElement()) {
+			const char* language = child->Attribute("lang");
+			const char* value = child->GetText();
+			mFields.push_back(AboutField(child->Name(), language != NULL ? language : "", value != NULL ? value : ""));
+
+			const AboutField& field = mFields.back();
+			if(field.mName == "AppName") {
+				mApplicationName = field.mValue;
+			} else if(field.mName == "DefaultLanguage") {
+				mLanguage = field.mValue;
+			}
+		}
+		result = mApplicationName.length() > 0 && mLanguage.length() > 0;
+		TBABOUTDESCRIPTIONLOG("::Parse -- mApplicationName.length && mLanguage.length <- %d", result);
+	}
+
+	TBABOUTDESCRIPTIONLOG("::Parse <- %d", result);
+
+	return result;
+}
+
+bool TBAboutDescription::Apply(ajn::AboutData& aboutData) const {
+	return Apply(aboutData, mFields);
+}
+
+bool TBAboutDescription::Apply(ajn::AboutData& aboutData, const std::vector< AboutField >& fields) const {
+	TBABOUTDESCRIPTIONLOG("::Apply -> fields = %u", static_cast< unsigned int >(fields.size()));
+
+	bool result = mLanguage.length() > 0;
+	TBABOUTDESCRIPTIONLOG("::Apply -- mLanguage.length <- %d", result);
+
+	for(size_t index = 0; result && index < fields.size(); ++index) {
+		const AboutField& field = fields[index];
+
+		if(field.mName == "AppId") {
+			// The AppId is written as hex in the XML, and SetAppId takes it as such
+			result = aboutData.SetAppId(field.mValue.c_str()) == ER_OK;
+		} else if(field.mName == "SupportedLanguages") {
+			// This is worked out by AboutData from the languages of the localized fields, as with CreateFromXml
+			continue;
+		} else {
+			ajn::MsgArg value("s", field.mValue.c_str());
+			value.Stabilize();
+			result = aboutData.SetField(field.mName.c_str(), value, field.mLanguage.length() > 0 ? field.mLanguage.c_str() : NULL) == ER_OK;
+		}
+		TBABOUTDESCRIPTIONLOG("::Apply -- %s <- %d", field.mName.c_str(), result);
+	}
+
+	TBABOUTDESCRIPTIONLOG("::Apply <- %d", result);
+
+	return result;
+}
+
+void TBAboutDescription::SetField(const AboutField& field) {
+	TBABOUTDESCRIPTIONLOG("::SetField -> %s", field.mName.c_str());
+
+	size_t index = 0;
+	while(index < mFields.size() && !IsSameField(mFields[index], field.mName, field.mLanguage)) {
+		++index;
+	}
+
+	if(index < mFields.size()) {
+		mFields[index].mValue = field.mValue;
+	} else {
+		mFields.push_back(field);
+	}
+
+	if(field.mName == "AppName") {
+		mApplicationName = field.mValue;
+	} else if(field.mName == "DefaultLanguage") {
+		mLanguage = field.mValue;
+	}
+
+	TBABOUTDESCRIPTIONLOG("::SetField <-");
+}
+
+std::vector< AboutField > TBAboutDescription::Diff(const TBAboutDescription& previous) const {
+	std::vector< AboutField > result;
+
+	for(size_t index = 0; index < mFields.size(); ++index) {
+		const AboutField& field = mFields[index];
+
+		size_t match = 0;
+		while(match < previous.mFields.size() && !previous.IsSameField(previous.mFields[match], field.mName, field.mLanguage)) {
+			++match;
+		}
+
+		if(match == previous.mFields.size() || previous.mFields[match].mValue != field.mValue) {
+			result.push_back(field);
+		}
+	}
+
+	return result;
+}
+
+bool TBAboutDescription::IsSameField(const AboutField& field, const std::string& name, const std::string& language) const {
+	if(field.mName != name) {
+		return false;
+	}
+
+	const std::string& fieldLanguage = field.mLanguage.length() > 0 ? field.mLanguage : mLanguage;
+	return fieldLanguage == (language.length() > 0 ? language : mLanguage);
+}
+
+} // namespace twobulls
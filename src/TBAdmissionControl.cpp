@@ -0,0 +1,129 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#include "TBAdmissionControl.h"
+
+#include <algorithm>
+
+#include "TBClock.h"
+
+namespace twobulls {
+
+namespace {
+
+// FNV-1a
+size_t HashJoiner(const char* joiner) {
+	uint32_t result = 2166136261u;
+	for(; joiner != NULL && *joiner != '\0'; ++joiner) {
+		result = (result ^ static_cast< uint8_t >(*joiner)) * 16777619u;
+	}
+	return result;
+}
+
+} // namespace
+
+TBAdmissionControl::TBAdmissionControl() :
+	mMutex()
+	,mOptions()
+	,mAccepted(0)
+	,mRejectedPort(0)
+	,mRejectedCapacity(0)
+	,mRejectedRate(0)
+	,mRejectedPredicate(0)
+{
+}
+
+void TBAdmissionControl::SetOptions(const AdmissionOptions& options) {
+	std::lock_guard< std::mutex > lock(mMutex);
+
+	mOptions = options;
+
+	// Every joiner starts over with a full bucket
+	for(size_t index = 0; index < BUCKET_COUNT; ++index) {
+		mBuckets[index] = Bucket();
+	}
+}
+
+bool TBAdmissionControl::Admit(bool portMatches, const char* joiner, const ajn::SessionOpts& opts, size_t memberCount) {
+	if(!portMatches) {
+		mRejectedPort.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	AdmissionPredicate predicate;
+	{
+		std::lock_guard< std::mutex > lock(mMutex);
+
+		if(mOptions.mMaxMembers > 0 && memberCount >= mOptions.mMaxMembers) {
+			mRejectedCapacity.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		if(!TakeToken(joiner)) {
+			mRejectedRate.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		predicate = mOptions.mPredicate;
+	}
+
+	// The predicate is the application's, so it isn't called with the lock held
+	if(predicate && !predicate(joiner, opts)) {
+		mRejectedPredicate.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	mAccepted.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+AdmissionStats TBAdmissionControl::GetStats() const {
+	AdmissionStats stats;
+	stats.mAccepted = mAccepted.load(std::memory_order_relaxed);
+	stats.mRejectedPort = mRejectedPort.load(std::memory_order_relaxed);
+	stats.mRejectedCapacity = mRejectedCapacity.load(std::memory_order_relaxed);
+	stats.mRejectedRate = mRejectedRate.load(std::memory_order_relaxed);
+	stats.mRejectedPredicate = mRejectedPredicate.load(std::memory_order_relaxed);
+	return stats;
+}
+
+// Called with mMutex held.
+bool TBAdmissionControl::TakeToken(const char* joiner) {
+	if(mOptions.mJoinRate <= 0) {
+		return true;
+	}
+
+	Bucket& bucket = mBuckets[HashJoiner(joiner) % BUCKET_COUNT];
+	const uint64_t now = MonotonicNanoseconds();
+
+	if(bucket.mRefilledNs == 0) {
+		bucket.mTokens = mOptions.mJoinBurst;
+	} else {
+		bucket.mTokens = std::min(mOptions.mJoinBurst, bucket.mTokens + (now - bucket.mRefilledNs) * mOptions.mJoinRate / 1e9);
+	}
+	bucket.mRefilledNs = now;
+
+	const bool result = bucket.mTokens >= 1;
+	if(result) {
+		bucket.mTokens -= 1;
+	}
+
+	return result;
+}
+
+} // namespace twobulls
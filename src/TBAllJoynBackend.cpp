@@ -0,0 +1,571 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#include "TBAllJoynBackend.h"
+
+#include <algorithm>
+#include <string.h>
+
+#include "TBAboutDescription.h"
+#include "TBAllJoynRuntime.h"
+#include "TBLog.h"
+
+#include <alljoyn/AboutObj.h>
+#include <alljoyn/BusAttachment.h>
+
+#define TBALLJOYNBACKENDLOG(...) TBLOG(TBLOG_LEVEL_TRACE, "twobulls::TBAllJoynBackend", __VA_ARGS__)
+
+namespace twobulls {
+
+TBAllJoynBackend::TBAllJoynBackend() :
+	mConnectMutex()
+	,mMutex()
+	,mConnections(0)
+	,mRuntimeAcquired(false)
+	,mBusAttachment(NULL)
+	,mAboutData(NULL)
+	,mAboutObject(NULL)
+	,mObjects()
+	,mPortListeners()
+	,mSignals()
+{
+}
+
+TBAllJoynBackend::~TBAllJoynBackend() {
+	TBALLJOYNBACKENDLOG("::~TBAllJoynBackend -> ");
+
+	std::lock_guard< std::mutex > lock(mConnectMutex);
+	TearDown();
+	mConnections = 0;
+
+	TBALLJOYNBACKENDLOG("::~TBAllJoynBackend <-");
+}
+
+bool TBAllJoynBackend::Connect(const std::string& applicationName) {
+	TBALLJOYNBACKENDLOG("::Connect -> applicationName = %s", applicationName.c_str());
+
+	std::lock_guard< std::mutex > lock(mConnectMutex);
+
+	// Only the first object to connect brings the BusAttachment up, the others share it
+	bool result = mConnections > 0;
+	TBALLJOYNBACKENDLOG("::Connect -- mConnections <- %d", result);
+
+	if(!result) {
+		ajn::BusAttachment* busAttachment = NULL;
+
+		result = mRuntimeAcquired = TBAllJoynRuntime::Acquire();
+		TBALLJOYNBACKENDLOG("::Connect -- TBAllJoynRuntime::Acquire <- %d", result);
+
+		if(result) {
+			result = (busAttachment = new ajn::BusAttachment(applicationName.c_str(), true)) != NULL;
+			TBALLJOYNBACKENDLOG("::Connect -- new ajn::BusAttachment <- %d", result);
+		}
+
+		if(result) {
+			std::lock_guard< std::mutex > objectsLock(mMutex);
+			mBusAttachment = busAttachment;
+		}
+
+		if(result) {
+			result = busAttachment->Start() == ER_OK;
+			TBALLJOYNBACKENDLOG("::Connect -- busAttachment->Start <- %d", result);
+		}
+
+		if(result) {
+			result = busAttachment->Connect() == ER_OK;
+			TBALLJOYNBACKENDLOG("::Connect -- busAttachment->Connect <- %d", result);
+		}
+
+		if(!result) {
+			TearDown();
+		}
+	}
+
+	if(result) {
+		++mConnections;
+	}
+
+	TBALLJOYNBACKENDLOG("::Connect <- %d", result);
+
+	return result;
+}
+
+void TBAllJoynBackend::Disconnect() {
+	TBALLJOYNBACKENDLOG("::Disconnect -> ");
+
+	std::lock_guard< std::mutex > lock(mConnectMutex);
+
+	if(mConnections > 0 && --mConnections == 0) {
+		TearDown();
+	}
+
+	TBALLJOYNBACKENDLOG("::Disconnect <-");
+}
+
+// Called with mConnectMutex held. Everything is taken out from under mMutex before the BusAttachment is stopped, as
+//	that waits on handlers which may be emitting Signals.
+void TBAllJoynBackend::TearDown() {
+	ajn::BusAttachment* busAttachment = NULL;
+	ajn::AboutData* aboutData = NULL;
+	ajn::AboutObj* aboutObject = NULL;
+	std::map< std::string, Object* > objects;
+	std::map< ajn::SessionPort, PortListener* > portListeners;
+	{
+		std::lock_guard< std::mutex > lock(mMutex);
+		std::swap(busAttachment, mBusAttachment);
+		std::swap(aboutData, mAboutData);
+		std::swap(aboutObject, mAboutObject);
+		objects.swap(mObjects);
+		portListeners.swap(mPortListeners);
+		mSignals.clear();
+	}
+
+	delete aboutObject;
+
+	if(busAttachment != NULL) {
+		busAttachment->Stop();
+		busAttachment->Join();
+
+		for(std::map< std::string, Object* >::iterator object = objects.begin(); object != objects.end(); ++object) {
+			busAttachment->UnregisterBusObject(*object->second);
+		}
+	}
+
+	for(std::map< std::string, Object* >::iterator object = objects.begin(); object != objects.end(); ++object) {
+		delete object->second;
+	}
+
+	delete busAttachment;
+
+	for(std::map< ajn::SessionPort, PortListener* >::iterator listener = portListeners.begin(); listener != portListeners.end(); ++listener) {
+		delete listener->second;
+	}
+
+	delete aboutData;
+
+	if(mRuntimeAcquired) {
+		TBAllJoynRuntime::Release();
+		mRuntimeAcquired = false;
+	}
+}
+
+bool TBAllJoynBackend::DefineInterface(const BusInterface& definition) {
+	TBALLJOYNBACKENDLOG("::DefineInterface -> name = %s", definition.mName.c_str());
+
+	std::lock_guard< std::mutex > lock(mMutex);
+
+	bool result = mBusAttachment != NULL;
+	TBALLJOYNBACKENDLOG("::DefineInterface -- mBusAttachment <- %d", result);
+
+	const bool defined = result && mBusAttachment->GetInterface(definition.mName.c_str()) != NULL;
+	TBALLJOYNBACKENDLOG("::DefineInterface -- mBusAttachment->GetInterface <- %d", defined);
+
+	ajn::InterfaceDescription* interfaceDefinition = NULL;
+
+	if(result && !defined) {
+		result = mBusAttachment->CreateInterface(definition.mName.c_str(), interfaceDefinition) == ER_OK && interfaceDefinition != NULL;
+		TBALLJOYNBACKENDLOG("::DefineInterface -- mBusAttachment->CreateInterface && interfaceDefinition <- %d", result);
+	}
+
+	if(result && !defined) {
+		interfaceDefinition->SetDescriptionLanguage(definition.mLanguage.c_str());
+		interfaceDefinition->SetDescription(definition.mDescription.c_str());
+	}
+
+	for(std::vector< BusMember >::const_iterator member = definition.mMembers.begin(); result && !defined && member != definition.mMembers.end(); ++member) {
+		if(member->mType == BUS_MEMBER_SIGNAL) {
+			result = interfaceDefinition->AddSignal(member->mName.c_str(), member->mInputSignature.c_str(), member->mArgNames.c_str()) == ER_OK
+				&& interfaceDefinition->SetMemberDescription(member->mName.c_str(), member->mDescription.c_str(), true) == ER_OK;
+			TBALLJOYNBACKENDLOG("::DefineInterface -- interfaceDefinition->AddSignal <- %d", result);
+		} else if(member->mType == BUS_MEMBER_METHOD) {
+			result = interfaceDefinition->AddMethod(member->mName.c_str(), member->mInputSignature.c_str(), member->mOutputSignature.c_str(), member->mArgNames.c_str(), member->mAnnotation) == ER_OK
+				&& interfaceDefinition->SetMemberDescription(member->mName.c_str(), member->mDescription.c_str()) == ER_OK;
+			TBALLJOYNBACKENDLOG("::DefineInterface -- interfaceDefinition->AddMethod <- %d", result);
+		} else {
+			result = interfaceDefinition->AddProperty(member->mName.c_str(), member->mInputSignature.c_str(), member->mWritable ? ajn::PROP_ACCESS_RW : ajn::PROP_ACCESS_READ) == ER_OK
+				&& interfaceDefinition->AddPropertyAnnotation(member->mName.c_str(), "org.freedesktop.DBus.Property.EmitsChangedSignal", member->mEmitsChanged ? "true" : "false") == ER_OK
+				&& interfaceDefinition->SetPropertyDescription(member->mName.c_str(), member->mDescription.c_str()) == ER_OK;
+			TBALLJOYNBACKENDLOG("::DefineInterface -- interfaceDefinition->AddProperty <- %d", result);
+		}
+	}
+
+	if(result && !defined) {
+		interfaceDefinition->Activate();
+	}
+
+	TBALLJOYNBACKENDLOG("::DefineInterface <- %d", result);
+
+	return result;
+}
+
+bool TBAllJoynBackend::RegisterObject(const std::string& path, const std::string& interfaceName, TBBusEndpoint& endpoint) {
+	TBALLJOYNBACKENDLOG("::RegisterObject -> path = %s, interfaceName = %s", path.c_str(), interfaceName.c_str());
+
+	std::lock_guard< std::mutex > lock(mMutex);
+
+	bool result = mBusAttachment != NULL && mObjects.find(path) == mObjects.end();
+	TBALLJOYNBACKENDLOG("::RegisterObject -- mBusAttachment && !mObjects.find <- %d", result);
+
+	const ajn::InterfaceDescription* definition = NULL;
+	if(result) {
+		result = (definition = mBusAttachment->GetInterface(interfaceName.c_str())) != NULL;
+		TBALLJOYNBACKENDLOG("::RegisterObject -- mBusAttachment->GetInterface <- %d", result);
+	}
+
+	Object* object = NULL;
+	if(result) {
+		result = (object = new Object(path, *definition, endpoint)) != NULL;
+		TBALLJOYNBACKENDLOG("::RegisterObject -- new Object <- %d", result);
+	}
+
+	if(result) {
+		result = object->Attach();
+		TBALLJOYNBACKENDLOG("::RegisterObject -- object->Attach <- %d", result);
+	}
+
+	if(result) {
+		result = mBusAttachment->RegisterBusObject(*object, false) == ER_OK;
+		TBALLJOYNBACKENDLOG("::RegisterObject -- mBusAttachment->RegisterBusObject <- %d", result);
+	}
+
+	if(result) {
+		mObjects[path] = object;
+	} else {
+		delete object;
+	}
+
+	TBALLJOYNBACKENDLOG("::RegisterObject <- %d", result);
+
+	return result;
+}
+
+void TBAllJoynBackend::UnregisterObject(const std::string& path) {
+	TBALLJOYNBACKENDLOG("::UnregisterObject -> path = %s", path.c_str());
+
+	ajn::BusAttachment* busAttachment = NULL;
+	Object* object = NULL;
+	{
+		std::lock_guard< std::mutex > lock(mMutex);
+
+		std::map< std::string, Object* >::iterator entry = mObjects.find(path);
+		if(entry != mObjects.end()) {
+			busAttachment = mBusAttachment;
+			object = entry->second;
+			mObjects.erase(entry);
+
+			// The handles of its Signals stay taken, so that they don't come to mean another object's
+			for(std::vector< SignalEntry >::iterator signal = mSignals.begin(); signal != mSignals.end(); ++signal) {
+				if(signal->mObject == object) {
+					*signal = SignalEntry();
+				}
+			}
+		}
+	}
+
+	// Unregistering waits on the object's handlers, which may be emitting Signals, so it is done outside of the lock
+	if(object != NULL && busAttachment != NULL) {
+		busAttachment->UnregisterBusObject(*object);
+	}
+
+	delete object;
+
+	TBALLJOYNBACKENDLOG("::UnregisterObject <-");
+}
+
+bool TBAllJoynBackend::BindSessionPort(ajn::SessionPort port, bool multipoint, ajn::SessionPortListener& portListener, ajn::SessionListener& sessionListener) {
+	TBALLJOYNBACKENDLOG("::BindSessionPort -> port = %d, multipoint = %d", port, multipoint);
+
+	std::lock_guard< std::mutex > lock(mMutex);
+
+	bool result = mBusAttachment != NULL && mPortListeners.find(port) == mPortListeners.end();
+	TBALLJOYNBACKENDLOG("::BindSessionPort -- mBusAttachment && !mPortListeners.find <- %d", result);
+
+	PortListener* listener = NULL;
+	if(result) {
+		result = (listener = new PortListener(*mBusAttachment, portListener, sessionListener)) != NULL;
+		TBALLJOYNBACKENDLOG("::BindSessionPort -- new PortListener <- %d", result);
+	}
+
+	if(result) {
+		ajn::SessionOpts opts(ajn::SessionOpts::TRAFFIC_MESSAGES, multipoint, ajn::SessionOpts::PROXIMITY_ANY, ajn::TRANSPORT_ANY);
+
+		result = mBusAttachment->BindSessionPort(port, opts, *listener) == ER_OK;
+		TBALLJOYNBACKENDLOG("::BindSessionPort -- mBusAttachment->BindSessionPort <- %d", result);
+	}
+
+	if(result) {
+		mPortListeners[port] = listener;
+	} else {
+		delete listener;
+	}
+
+	TBALLJOYNBACKENDLOG("::BindSessionPort <- %d", result);
+
+	return result;
+}
+
+void TBAllJoynBackend::UnbindSessionPort(ajn::SessionPort port) {
+	TBALLJOYNBACKENDLOG("::UnbindSessionPort -> port = %d", port);
+
+	std::lock_guard< std::mutex > lock(mMutex);
+
+	std::map< ajn::SessionPort, PortListener* >::iterator listener = mPortListeners.find(port);
+	if(listener != mPortListeners.end()) {
+		if(mBusAttachment != NULL) {
+			mBusAttachment->UnbindSessionPort(port);
+		}
+
+		delete listener->second;
+		mPortListeners.erase(listener);
+	}
+
+	TBALLJOYNBACKENDLOG("::UnbindSessionPort <-");
+}
+
+BusSignalHandle TBAllJoynBackend::ResolveSignal(const std::string& path, const std::string& signalName) {
+	std::lock_guard< std::mutex > lock(mMutex);
+
+	std::map< std::string, Object* >::const_iterator object = mObjects.find(path);
+	const ajn::InterfaceDescription::Member* member = object != mObjects.end() ? object->second->mDefinition.GetSignal(signalName.c_str()) : NULL;
+
+	if(member == NULL) {
+		return INVALID_BUS_SIGNAL;
+	}
+
+	mSignals.push_back(SignalEntry(object->second, member));
+
+	return mSignals.size() - 1;
+}
+
+bool TBAllJoynBackend::EmitSignal(BusSignalHandle signal, const ajn::MsgArg* args, size_t argCount, ajn::SessionId session, uint16_t timeToLive, uint32_t* serial) {
+	SignalEntry entry;
+	{
+		std::lock_guard< std::mutex > lock(mMutex);
+		if(signal < mSignals.size()) {
+			entry = mSignals[signal];
+		}
+	}
+
+	return entry.mObject != NULL && entry.mObject->EmitSignal(*entry.mMember, args, argCount, session, timeToLive, serial) == ER_OK;
+}
+
+bool TBAllJoynBackend::CancelSignal(BusSignalHandle signal, uint32_t serial) {
+	SignalEntry entry;
+	{
+		std::lock_guard< std::mutex > lock(mMutex);
+		if(signal < mSignals.size()) {
+			entry = mSignals[signal];
+		}
+	}
+
+	return entry.mObject != NULL && entry.mObject->CancelSignal(serial) == ER_OK;
+}
+
+bool TBAllJoynBackend::EmitPropertiesChanged(const std::string& path, const char** propertyNames, size_t propertyCount, ajn::SessionId session) {
+	Object* object = FindObject(path);
+
+	if(object != NULL) {
+		object->EmitPropertiesChanged(propertyNames, propertyCount, session);
+	}
+
+	return object != NULL;
+}
+
+// Every object shares the one About object, so each Announce replaces the About data of the last. The previous data is
+//	only deleted once the About object has been given the new one.
+bool TBAllJoynBackend::Announce(ajn::SessionPort port, const TBAboutDescription& about) {
+	TBALLJOYNBACKENDLOG("::Announce -> port = %d", port);
+
+	std::lock_guard< std::mutex > lock(mMutex);
+
+	bool result = mBusAttachment != NULL;
+	TBALLJOYNBACKENDLOG("::Announce -- mBusAttachment <- %d", result);
+
+	ajn::AboutData* aboutData = NULL;
+	if(result) {
+		result = (aboutData = new ajn::AboutData(about.GetLanguage().c_str())) != NULL;
+		TBALLJOYNBACKENDLOG("::Announce -- new ajn::AboutData <- %d", result);
+	}
+
+	if(result) {
+		result = about.Apply(*aboutData) && aboutData->IsValid(about.GetLanguage().c_str()) == QCC_TRUE;
+		TBALLJOYNBACKENDLOG("::Announce -- about.Apply && aboutData->IsValid <- %d", result);
+	}
+
+	if(result && mAboutObject == NULL) {
+		result = (mAboutObject = new ajn::AboutObj(*mBusAttachment)) != NULL;
+		TBALLJOYNBACKENDLOG("::Announce -- new ajn::AboutObj <- %d", result);
+	}
+
+	if(result) {
+		result = mAboutObject->Announce(port, *aboutData) == ER_OK;
+		TBALLJOYNBACKENDLOG("::Announce -- mAboutObject->Announce <- %d", result);
+	}
+
+	if(result) {
+		delete mAboutData;
+		mAboutData = aboutData;
+	} else {
+		delete aboutData;
+	}
+
+	TBALLJOYNBACKENDLOG("::Announce <- %d", result);
+
+	return result;
+}
+
+// The reply goes through the BusObject the call came in on, which is the one registered with the BusAttachment.
+QStatus TBAllJoynBackend::ReplyToCall(const std::string& path, const ajn::Message& message, const ajn::MsgArg* args, size_t argCount) {
+	Object* object = FindObject(path);
+
+	return object != NULL ? object->MethodReply(message, args, argCount) : ER_BUS_NO_SUCH_OBJECT;
+}
+
+QStatus TBAllJoynBackend::ReplyToCall(const std::string& path, const ajn::Message& message, const char* error, const char* errorMessage) {
+	Object* object = FindObject(path);
+
+	return object != NULL ? object->MethodReply(message, error, errorMessage) : ER_BUS_NO_SUCH_OBJECT;
+}
+
+QStatus TBAllJoynBackend::ReplyToCall(const std::string& path, const ajn::Message& message, QStatus status) {
+	Object* object = FindObject(path);
+
+	return object != NULL ? object->MethodReply(message, status) : ER_BUS_NO_SUCH_OBJECT;
+}
+
+// Only the lookup is done under the lock. The object stays valid until UnregisterObject, which its endpoint doesn't
+//	call while it is still using it.
+TBAllJoynBackend::Object* TBAllJoynBackend::FindObject(const std::string& path) const {
+	std::lock_guard< std::mutex > lock(mMutex);
+	std::map< std::string, Object* >::const_iterator entry = mObjects.find(path);
+
+	return entry != mObjects.end() ? entry->second : NULL;
+}
+
+ajn::BusAttachment* TBAllJoynBackend::GetBusAttachment() const {
+	std::lock_guard< std::mutex > lock(mMutex);
+	return mBusAttachment;
+}
+
+TBAllJoynBackend::Object::Object(const std::string& path, const ajn::InterfaceDescription& definition, TBBusEndpoint& endpoint) :
+	ajn::BusObject(path.c_str())
+	,mDefinition(definition)
+	,mEndpoint(endpoint)
+{
+}
+
+bool TBAllJoynBackend::Object::Attach() {
+	bool result = AddInterface(mDefinition, ajn::BusObject::ANNOUNCED) == ER_OK;
+
+	std::vector< const ajn::InterfaceDescription::Member* > members(mDefinition.GetMembers());
+	if(!members.empty()) {
+		mDefinition.GetMembers(&members[0], members.size());
+	}
+
+	for(size_t index = 0; result && index < members.size(); ++index) {
+		if(members[index]->memberType == ajn::MESSAGE_METHOD_CALL) {
+			result = AddMethodHandler(members[index], static_cast< ajn::MessageReceiver::MethodHandler >(&Object::HandleCall)) == ER_OK;
+		}
+	}
+
+	return result;
+}
+
+QStatus TBAllJoynBackend::Object::EmitSignal(const ajn::InterfaceDescription::Member& member, const ajn::MsgArg* args, size_t argCount, ajn::SessionId session, uint16_t timeToLive, uint32_t* serial) {
+	if(session != 0) {
+		return Signal(NULL, session, member, args, argCount);
+	}
+
+	if(serial == NULL) {
+		return Signal(NULL, 0, member, args, argCount, timeToLive, ajn::ALLJOYN_FLAG_SESSIONLESS);
+	}
+
+	ajn::Message message(*bus);
+	QStatus status = Signal(NULL, 0, member, args, argCount, timeToLive, ajn::ALLJOYN_FLAG_SESSIONLESS, &message);
+
+	if(status == ER_OK) {
+		*serial = message->GetCallSerial();
+	}
+
+	return status;
+}
+
+QStatus TBAllJoynBackend::Object::CancelSignal(uint32_t serial) {
+	return CancelSessionlessMessage(serial);
+}
+
+void TBAllJoynBackend::Object::EmitPropertiesChanged(const char** propertyNames, size_t propertyCount, ajn::SessionId session) {
+	EmitPropChanged(mDefinition.GetName(), propertyNames, propertyCount, session, session == 0 ? ajn::ALLJOYN_FLAG_SESSIONLESS : 0);
+}
+
+void TBAllJoynBackend::Object::HandleCall(const ajn::InterfaceDescription::Member* member, ajn::Message& message) {
+	TBALLJOYNBACKENDLOG("::Object::HandleCall -> member = %s", member->name.c_str());
+
+	size_t argCount = 0;
+	const ajn::MsgArg* args = NULL;
+	message->GetArgs(argCount, args);
+
+	MessageReply reply(*this, message);
+	QStatus status = mEndpoint.HandleCall(BusCall(member->name.c_str(), args, argCount, message->GetSessionId(), message->GetSender(), message->GetBufferSize(), member, &message), reply);
+
+	if(status != ER_OK && !reply.mReplied) {
+		MethodReply(message, status);
+	}
+
+	TBALLJOYNBACKENDLOG("::Object::HandleCall <- %d", status);
+}
+
+QStatus TBAllJoynBackend::Object::Get(const char* ifcName, const char* propName, ajn::MsgArg& val) {
+	return strcmp(ifcName, mDefinition.GetName()) == 0 ? mEndpoint.GetPropertyValue(propName, val) : ER_BUS_NO_SUCH_PROPERTY;
+}
+
+QStatus TBAllJoynBackend::Object::Set(const char* ifcName, const char* propName, ajn::MsgArg& val) {
+	return strcmp(ifcName, mDefinition.GetName()) == 0 ? mEndpoint.SetPropertyValue(propName, val) : ER_BUS_NO_SUCH_PROPERTY;
+}
+
+TBAllJoynBackend::Object::MessageReply::MessageReply(Object& object, ajn::Message& message) :
+	mReplied(false)
+	,mObject(object)
+	,mMessage(message)
+{
+}
+
+QStatus TBAllJoynBackend::Object::MessageReply::Reply(const ajn::MsgArg* args, size_t argCount) {
+	mReplied = true;
+	return mObject.MethodReply(mMessage, args, argCount);
+}
+
+TBAllJoynBackend::PortListener::PortListener(ajn::BusAttachment& busAttachment, ajn::SessionPortListener& portListener, ajn::SessionListener& sessionListener) :
+	mBusAttachment(busAttachment)
+	,mPortListener(portListener)
+	,mSessionListener(sessionListener)
+{
+}
+
+bool TBAllJoynBackend::PortListener::AcceptSessionJoiner(ajn::SessionPort sessionPort, const char* joiner, const ajn::SessionOpts& opts) {
+	return mPortListener.AcceptSessionJoiner(sessionPort, joiner, opts);
+}
+
+void TBAllJoynBackend::PortListener::SessionJoined(ajn::SessionPort sessionPort, ajn::SessionId id, const char* joiner) {
+	QStatus status = mBusAttachment.SetSessionListener(id, &mSessionListener);
+	TBALLJOYNBACKENDLOG("::PortListener::SessionJoined -- mBusAttachment->SetSessionListener <- %d", status);
+
+	mPortListener.SessionJoined(sessionPort, id, joiner);
+}
+
+} // namespace twobulls
@@ -0,0 +1,97 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#include "TBAllJoynRuntime.h"
+
+#include "TBLog.h"
+#include "TBStartAllJoyn.h"
+
+#if defined(ALLJOYN_VERSION) && ALLJOYN_VERSION >= 1504
+#include <alljoyn/Init.h>
+#endif
+
+#define TBALLJOYNRUNTIMELOG(...) TBLOG(TBLOG_LEVEL_TRACE, "twobulls::TBAllJoynRuntime", __VA_ARGS__)
+
+namespace twobulls {
+
+std::mutex TBAllJoynRuntime::sMutex;
+size_t TBAllJoynRuntime::sReferenceCount = 0;
+
+bool TBAllJoynRuntime::Acquire() {
+	std::lock_guard< std::mutex > lock(sMutex);
+
+	TBALLJOYNRUNTIMELOG("::Acquire -> sReferenceCount = %u", static_cast< unsigned int >(sReferenceCount));
+
+	bool result = true;
+
+#if defined(ALLJOYN_VERSION) && ALLJOYN_VERSION >= 1504
+	if(sReferenceCount == 0) {
+		result = AllJoynInit() == ER_OK;
+		TBALLJOYNRUNTIMELOG("::Acquire -- AllJoynInit <- %d", result);
+
+#if defined(ALLJOYN_BUNDLED_ROUTER)
+		// An instance of AllJoyn Router (aka Daemon) needs to be running on a typical peer. This can
+		// be omitted if another process is responsible for running the Router. It can also be
+		// omitted if the peer is running as a Thin Client.
+		if(result) {
+			if(AllJoynRouterInit() != ER_OK) {
+				AllJoynShutdown();
+				result = false;
+			}
+			TBALLJOYNRUNTIMELOG("::Acquire -- AllJoynRouterInit <- %d", result);
+		}
+#endif
+	}
+#endif
+
+	if(result) {
+		++sReferenceCount;
+	}
+
+	TBALLJOYNRUNTIMELOG("::Acquire <- %d", result);
+
+	return result;
+}
+
+void TBAllJoynRuntime::Release() {
+	std::lock_guard< std::mutex > lock(sMutex);
+
+	TBALLJOYNRUNTIMELOG("::Release -> sReferenceCount = %u", static_cast< unsigned int >(sReferenceCount));
+
+	if(sReferenceCount > 0 && --sReferenceCount == 0) {
+#if defined(ALLJOYN_VERSION) && ALLJOYN_VERSION >= 1504
+
+#if defined(ALLJOYN_BUNDLED_ROUTER)
+		AllJoynRouterShutdown();
+		TBALLJOYNRUNTIMELOG("::Release -- AllJoynRouterShutdown <-");
+#endif
+
+		AllJoynShutdown();
+		TBALLJOYNRUNTIMELOG("::Release -- AllJoynShutdown <-");
+#endif
+	}
+
+	TBALLJOYNRUNTIMELOG("::Release <-");
+}
+
+size_t TBAllJoynRuntime::GetReferenceCount() {
+	std::lock_guard< std::mutex > lock(sMutex);
+	return sReferenceCount;
+}
+
+} // namespace twobulls
@@ -0,0 +1,85 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#include "TBEventHistory.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace twobulls {
+
+TBEventHistory::TBEventHistory(size_t capacity) :
+	mCapacity(capacity > 0 ? capacity : 1)
+	,mSlots(new Slot[mCapacity])
+	,mLatestSequence(0)
+{
+}
+
+TBEventHistory::~TBEventHistory() {
+	delete[] mSlots;
+}
+
+uint64_t TBEventHistory::Record(EventHandle event) {
+	const uint64_t timestamp = static_cast< uint64_t >(std::chrono::duration_cast< std::chrono::milliseconds >(std::chrono::system_clock::now().time_since_epoch()).count());
+	const uint64_t sequence = mLatestSequence.fetch_add(1) + 1;
+	Slot& slot = mSlots[sequence % mCapacity];
+
+	slot.mVersion.store(sequence * 2 - 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.mTimestampMs.store(timestamp, std::memory_order_relaxed);
+	slot.mEvent.store(event, std::memory_order_relaxed);
+	slot.mVersion.store(sequence * 2, std::memory_order_release);
+
+	return sequence;
+}
+
+size_t TBEventHistory::GetSince(uint64_t since, EventRecord* records, size_t maxRecords) const {
+	const uint64_t latest = mLatestSequence.load();
+	const uint64_t oldest = latest >= mCapacity ? latest - mCapacity + 1 : 1;
+	size_t result = 0;
+
+	for(uint64_t sequence = std::max(since + 1, oldest); sequence <= latest && result < maxRecords; ++sequence) {
+		const Slot& slot = mSlots[sequence % mCapacity];
+
+		const uint64_t version = slot.mVersion.load(std::memory_order_acquire);
+		EventRecord& record = records[result];
+		record.mSequence = sequence;
+		record.mTimestampMs = slot.mTimestampMs.load(std::memory_order_relaxed);
+		record.mEvent = slot.mEvent.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		if(version < sequence * 2) {
+			// Still being written, so this and anything after it is left for the next call
+			break;
+		} else if(version == sequence * 2 && slot.mVersion.load(std::memory_order_relaxed) == version) {
+			++result;
+		}
+	}
+
+	return result;
+}
+
+uint64_t TBEventHistory::GetLatestSequence() const {
+	return mLatestSequence.load();
+}
+
+size_t TBEventHistory::GetCapacity() const {
+	return mCapacity;
+}
+
+} // namespace twobulls
@@ -0,0 +1,198 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#include "TBEventQueue.h"
+
+namespace twobulls {
+
+namespace {
+
+size_t RoundUpToPowerOfTwo(size_t value) {
+	size_t result = 2;
+	while(result < value) {
+		result <<= 1;
+	}
+	return result;
+}
+
+} // namespace
+
+TBEventQueue::TBEventQueue(const EventQueueOptions& options) :
+	mOverflowPolicy(options.mOverflowPolicy)
+	,mMask(RoundUpToPowerOfTwo(options.mCapacity) - 1)
+	,mCells(new Cell[mMask + 1])
+	,mEnqueuePosition(0)
+	,mDequeuePosition(0)
+	,mClosed(false)
+	,mEmitterWaiting(false)
+	,mWakeRequested(false)
+	,mProducersWaiting(0)
+	,mEnqueued(0)
+	,mEmitted(0)
+	,mFailed(0)
+	,mDropped(0)
+{
+	for(size_t index = 0; index <= mMask; ++index) {
+		mCells[index].mSequence.store(index, std::memory_order_relaxed);
+	}
+}
+
+TBEventQueue::~TBEventQueue() {
+	delete[] mCells;
+}
+
+bool TBEventQueue::Push(EventHandle event) {
+	bool result = false;
+
+	while(!(result = TryPush(event))) {
+		if(mClosed.load()) {
+			break;
+		}
+
+		if(mOverflowPolicy == EVENT_QUEUE_DROP_NEWEST) {
+			break;
+		} else if(mOverflowPolicy == EVENT_QUEUE_DROP_OLDEST) {
+			EventHandle oldest;
+			if(TryPop(oldest)) {
+				mDropped.fetch_add(1, std::memory_order_relaxed);
+			}
+		} else {
+			// The timeout bounds the cost of a wakeup racing with the emitter, there is no need for it to be exact
+			std::unique_lock< std::mutex > lock(mMutex);
+			mProducersWaiting.fetch_add(1);
+			mSpaceCondition.wait_for(lock, std::chrono::milliseconds(1));
+			mProducersWaiting.fetch_sub(1);
+		}
+	}
+
+	if(result) {
+		mEnqueued.fetch_add(1, std::memory_order_relaxed);
+		Wake();
+	} else {
+		mDropped.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	return result;
+}
+
+bool TBEventQueue::Pop(EventHandle& event) {
+	bool result = TryPop(event);
+
+	if(result && mProducersWaiting.load() > 0) {
+		std::lock_guard< std::mutex > lock(mMutex);
+		mSpaceCondition.notify_all();
+	}
+
+	return result;
+}
+
+void TBEventQueue::Wait(std::chrono::nanoseconds timeout) {
+	std::unique_lock< std::mutex > lock(mMutex);
+
+	mEmitterWaiting.store(true);
+	if(!mWakeRequested.exchange(false) && !mClosed.load() && mDequeuePosition.load() == mEnqueuePosition.load()) {
+		mDataCondition.wait_for(lock, timeout);
+	}
+	mEmitterWaiting.store(false);
+	mWakeRequested.store(false);
+}
+
+void TBEventQueue::Wake() {
+	mWakeRequested.store(true);
+	if(mEmitterWaiting.load()) {
+		std::lock_guard< std::mutex > lock(mMutex);
+		mDataCondition.notify_one();
+	}
+}
+
+void TBEventQueue::Close() {
+	std::lock_guard< std::mutex > lock(mMutex);
+
+	mClosed.store(true);
+	mDataCondition.notify_all();
+	mSpaceCondition.notify_all();
+}
+
+void TBEventQueue::Open() {
+	mClosed.store(false);
+}
+
+bool TBEventQueue::IsClosed() const {
+	return mClosed.load();
+}
+
+void TBEventQueue::CountEmitted(bool result) {
+	(result ? mEmitted : mFailed).fetch_add(1, std::memory_order_relaxed);
+}
+
+EventQueueStats TBEventQueue::GetStats() const {
+	EventQueueStats stats;
+	stats.mEnqueued = mEnqueued.load(std::memory_order_relaxed);
+	stats.mEmitted = mEmitted.load(std::memory_order_relaxed);
+	stats.mFailed = mFailed.load(std::memory_order_relaxed);
+	stats.mDropped = mDropped.load(std::memory_order_relaxed);
+	return stats;
+}
+
+bool TBEventQueue::TryPush(EventHandle event) {
+	size_t position = mEnqueuePosition.load(std::memory_order_relaxed);
+
+	for(;;) {
+		Cell& cell = mCells[position & mMask];
+		const size_t sequence = cell.mSequence.load(std::memory_order_acquire);
+		const intptr_t difference = static_cast< intptr_t >(sequence) - static_cast< intptr_t >(position);
+
+		if(difference == 0) {
+			// Sequentially consistent so that it can't be reordered with the check of mEmitterWaiting in Push
+			if(mEnqueuePosition.compare_exchange_weak(position, position + 1)) {
+				cell.mEvent = event;
+				cell.mSequence.store(position + 1, std::memory_order_release);
+				return true;
+			}
+		} else if(difference < 0) {
+			return false;
+		} else {
+			position = mEnqueuePosition.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+// Producers also dequeue under EVENT_QUEUE_DROP_OLDEST, so the dequeue position is claimed with a compare-and-swap too.
+bool TBEventQueue::TryPop(EventHandle& event) {
+	size_t position = mDequeuePosition.load(std::memory_order_relaxed);
+
+	for(;;) {
+		Cell& cell = mCells[position & mMask];
+		const size_t sequence = cell.mSequence.load(std::memory_order_acquire);
+		const intptr_t difference = static_cast< intptr_t >(sequence) - static_cast< intptr_t >(position + 1);
+
+		if(difference == 0) {
+			if(mDequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+				event = cell.mEvent;
+				cell.mSequence.store(position + mMask + 1, std::memory_order_release);
+				return true;
+			}
+		} else if(difference < 0) {
+			return false;
+		} else {
+			position = mDequeuePosition.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+} // namespace twobulls
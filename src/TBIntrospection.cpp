@@ -0,0 +1,191 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#include "TBIntrospection.h"
+
+#include <stdio.h>
+
+namespace twobulls {
+
+namespace {
+
+std::string EscapeXml(const std::string& text) {
+	std::string result;
+	result.reserve(text.length());
+
+	for(std::string::const_iterator character = text.begin(); character != text.end(); ++character) {
+		switch(*character) {
+			case '&': result += "&amp;"; break;
+			case '<': result += "&lt;"; break;
+			case '>': result += "&gt;"; break;
+			case '"': result += "&quot;"; break;
+			case '\'': result += "&apos;"; break;
+			default: result += *character; break;
+		}
+	}
+
+	return result;
+}
+
+std::vector< std::string > SplitArgNames(const std::string& argNames) {
+	std::vector< std::string > result;
+
+	size_t start = 0;
+	while(start <= argNames.length() && argNames.length() > 0) {
+		const size_t end = argNames.find(',', start);
+		result.push_back(argNames.substr(start, end == std::string::npos ? std::string::npos : end - start));
+		start = end == std::string::npos ? argNames.length() + 1 : end + 1;
+	}
+
+	return result;
+}
+
+// Writes an arg element for each complete type of 'signature', named from 'names' starting at 'nameIndex'.
+void AppendArgs(std::string& xml, const std::string& signature, const std::vector< std::string >& names, size_t& nameIndex, const char* direction) {
+	const std::vector< std::string > types = SplitSignature(signature);
+
+	for(size_t index = 0; index < types.size(); ++index, ++nameIndex) {
+		xml += "<arg";
+		if(nameIndex < names.size() && names[nameIndex].length() > 0) {
+			xml += " name=\"" + EscapeXml(names[nameIndex]) + "\"";
+		}
+		xml += " type=\"" + EscapeXml(types[index]) + "\"";
+		if(direction != NULL) {
+			xml += std::string(" direction=\"") + direction + "\"";
+		}
+		xml += "/>";
+	}
+}
+
+void AppendDescription(std::string& xml, const std::string& description, const std::string& language) {
+	if(description.length() > 0) {
+		xml += "<description language=\"" + EscapeXml(language) + "\">" + EscapeXml(description) + "</description>";
+	}
+}
+
+void AppendMember(std::string& xml, const BusMember& member, const std::string& language) {
+	const std::vector< std::string > names = SplitArgNames(member.mArgNames);
+	size_t nameIndex = 0;
+
+	switch(member.mType) {
+		case BUS_MEMBER_SIGNAL:
+			// Events are sessionless Signals, as DefineInterface has them
+			xml += "<signal name=\"" + EscapeXml(member.mName) + "\" sessionless=\"true\">";
+			AppendArgs(xml, member.mInputSignature, names, nameIndex, NULL);
+			AppendDescription(xml, member.mDescription, language);
+			xml += "</signal>";
+			break;
+
+		case BUS_MEMBER_METHOD:
+			xml += "<method name=\"" + EscapeXml(member.mName) + "\">";
+			AppendArgs(xml, member.mInputSignature, names, nameIndex, "in");
+			AppendArgs(xml, member.mOutputSignature, names, nameIndex, "out");
+			AppendDescription(xml, member.mDescription, language);
+			if(member.mAnnotation & ajn::MEMBER_ANNOTATE_NO_REPLY) {
+				xml += "<annotation name=\"org.freedesktop.DBus.Method.NoReply\" value=\"true\"/>";
+			}
+			if(member.mAnnotation & ajn::MEMBER_ANNOTATE_DEPRECATED) {
+				xml += "<annotation name=\"org.freedesktop.DBus.Deprecated\" value=\"true\"/>";
+			}
+			xml += "</method>";
+			break;
+
+		case BUS_MEMBER_PROPERTY:
+			xml += "<property name=\"" + EscapeXml(member.mName) + "\" type=\"" + EscapeXml(member.mInputSignature) + "\" access=\"" +
+				(member.mWritable ? "readwrite" : "read") + "\">";
+			AppendDescription(xml, member.mDescription, language);
+			xml += std::string("<annotation name=\"org.freedesktop.DBus.Property.EmitsChangedSignal\" value=\"") +
+				(member.mEmitsChanged ? "true" : "false") + "\"/>";
+			xml += "</property>";
+			break;
+	}
+}
+
+} // namespace
+
+std::vector< BusInterface > SplitInterface(const BusInterface& definition, size_t maxMembers) {
+	std::vector< BusInterface > result(1, BusInterface(definition.mName, definition.mDescription, definition.mLanguage));
+
+	// Properties stay together on the first interface, so their changes go out in one PropertiesChanged
+	size_t partMembers = 0;
+	for(std::vector< BusMember >::const_iterator member = definition.mMembers.begin(); member != definition.mMembers.end(); ++member) {
+		if(member->mType == BUS_MEMBER_PROPERTY) {
+			result.front().mMembers.push_back(*member);
+			continue;
+		}
+
+		if(maxMembers > 0 && partMembers == maxMembers) {
+			char suffix[32];
+			snprintf(suffix, sizeof(suffix), ".Part%u", static_cast< unsigned int >(result.size() + 1));
+			result.push_back(BusInterface(definition.mName + suffix, definition.mDescription, definition.mLanguage));
+			partMembers = 0;
+		}
+
+		result.back().mMembers.push_back(*member);
+		++partMembers;
+	}
+
+	return result;
+}
+
+std::string IntrospectionXml(const std::vector< BusInterface >& interfaces) {
+	std::string result("<node>");
+
+	for(std::vector< BusInterface >::const_iterator definition = interfaces.begin(); definition != interfaces.end(); ++definition) {
+		result += "<interface name=\"" + EscapeXml(definition->mName) + "\">";
+		AppendDescription(result, definition->mDescription, definition->mLanguage);
+		for(std::vector< BusMember >::const_iterator member = definition->mMembers.begin(); member != definition->mMembers.end(); ++member) {
+			AppendMember(result, *member, definition->mLanguage);
+		}
+		result += "</interface>";
+	}
+
+	result += "</node>";
+
+	return result;
+}
+
+std::vector< std::string > SplitSignature(const std::string& signature) {
+	std::vector< std::string > result;
+
+	size_t start = 0;
+	while(start < signature.length()) {
+		// Arrays prefix the type of their elements, and structs and dictionary entries run to their closing bracket
+		size_t end = start;
+		while(end < signature.length() && signature[end] == 'a') {
+			++end;
+		}
+
+		int depth = 0;
+		do {
+			if(end < signature.length() && (signature[end] == '(' || signature[end] == '{')) {
+				++depth;
+			} else if(end < signature.length() && (signature[end] == ')' || signature[end] == '}')) {
+				--depth;
+			}
+			++end;
+		} while(depth > 0 && end < signature.length());
+
+		result.push_back(signature.substr(start, end - start));
+		start = end;
+	}
+
+	return result;
+}
+
+} // namespace twobulls
@@ -0,0 +1,107 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#include "TBLifecycleStats.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "TBClock.h"
+
+namespace twobulls {
+
+void LifecycleStats::Record(LifecycleStep step, uint64_t startNs, bool result) {
+	const uint64_t now = MonotonicNanoseconds();
+
+	LifecycleTiming& timing = mSteps[step];
+	timing.mRecorded = true;
+	timing.mResult = result;
+	timing.mStartNs = startNs;
+	timing.mDurationNs = now > startNs ? now - startNs : 0;
+}
+
+void LifecycleStats::Clear() {
+	for(size_t index = 0; index < LIFECYCLE_STEP_COUNT; ++index) {
+		mSteps[index] = LifecycleTiming();
+	}
+}
+
+std::string LifecycleStats::ToJSON() const {
+	uint64_t origin = UINT64_MAX;
+	for(size_t index = 0; index < LIFECYCLE_STEP_COUNT; ++index) {
+		if(mSteps[index].mRecorded && mSteps[index].mStartNs < origin) {
+			origin = mSteps[index].mStartNs;
+		}
+	}
+
+	std::string result("{\"steps\":[");
+	bool first = true;
+
+	for(size_t index = 0; index < LIFECYCLE_STEP_COUNT; ++index) {
+		const LifecycleTiming& timing = mSteps[index];
+		if(!timing.mRecorded) {
+			continue;
+		}
+
+		char buffer[160];
+		snprintf(buffer, sizeof(buffer), "%s{\"step\":\"%s\",\"start_ns\":%" PRIu64 ",\"duration_ns\":%" PRIu64 ",\"result\":%s}",
+			first ? "" : ",", GetStepName(static_cast< LifecycleStep >(index)), timing.mStartNs - origin, timing.mDurationNs,
+			timing.mResult ? "true" : "false");
+		result += buffer;
+		first = false;
+	}
+
+	result += "]}";
+
+	return result;
+}
+
+const char* LifecycleStats::GetStepName(LifecycleStep step) {
+	static const char* const names[LIFECYCLE_STEP_COUNT] = {
+		"Start",
+		"RuntimeAcquire",
+		"ActionPoolStart",
+		"SetupBusAttachment",
+		"BusCreate",
+		"BusStart",
+		"DefineInterface",
+		"AttachInterface",
+		"Connect",
+		"BindSessionPort",
+		"SetupAboutObject",
+		"AboutDataCreate",
+		"AboutDataValidate",
+		"Announce",
+		"EmitterStart",
+		"Stop",
+		"EmitterStop",
+		"BusStop",
+		"ActionPoolStop",
+		"UnregisterObject",
+		"DeleteBus",
+		"RuntimeRelease",
+		"Suspend",
+		"Unannounce",
+		"Disconnect",
+		"Resume"
+	};
+
+	return step < LIFECYCLE_STEP_COUNT ? names[step] : "Unknown";
+}
+
+} // namespace twobulls
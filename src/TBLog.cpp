@@ -0,0 +1,378 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#include "TBLog.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <inttypes.h>
+#include <mutex>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+namespace twobulls {
+
+namespace {
+
+// A single producer, single consumer ring of records. The producer is the thread that owns it, the consumer is
+//	whoever holds the drain lock.
+class LogRing {
+	public:
+		enum { CAPACITY = 256 };
+
+		LogRing() :
+			mHead(0)
+			,mTail(0)
+			,mDropped(0)
+			,mAbandoned(false)
+		{};
+
+		LogRecord* Begin() {
+			const size_t head = mHead.load(std::memory_order_relaxed);
+			if(head - mTail.load(std::memory_order_acquire) >= CAPACITY) {
+				mDropped.fetch_add(1, std::memory_order_relaxed);
+				return NULL;
+			}
+			return &mRecords[head % CAPACITY];
+		};
+
+		// Sequentially consistent, as the formatter's check of the rings before it sleeps pairs with the producer's check
+		//	of whether it is asleep after this
+		void Commit() {
+			mHead.store(mHead.load(std::memory_order_relaxed) + 1);
+		};
+
+		bool IsEmpty() const {
+			return mHead.load() == mTail.load(std::memory_order_relaxed);
+		};
+
+		template< typename F > bool Drain(F format) {
+			size_t tail = mTail.load(std::memory_order_relaxed);
+			const size_t head = mHead.load(std::memory_order_acquire);
+			const bool result = tail != head;
+			for(; tail != head; ++tail) {
+				format(mRecords[tail % CAPACITY]);
+				mTail.store(tail + 1, std::memory_order_release);
+			}
+			return result;
+		};
+
+		std::atomic< size_t > mHead;
+		std::atomic< size_t > mTail;
+		std::atomic< uint64_t > mDropped;
+		std::atomic< bool > mAbandoned;
+		LogRecord mRecords[CAPACITY];
+};
+
+// Owns the rings and the formatter thread. It is created by the first record logged and lives until the process exits.
+class LogFormatter {
+	public:
+		LogFormatter() :
+			mSink(NULL)
+			,mRetiredDropped(0)
+			,mIdle(false)
+			,mStopping(false)
+		{
+			mThread = std::thread(&LogFormatter::Run, this);
+		};
+
+		~LogFormatter() {
+			{
+				std::lock_guard< std::mutex > lock(mWaitMutex);
+				mStopping = true;
+				mWaitCondition.notify_all();
+			}
+			mThread.join();
+			DrainAll();
+
+			for(size_t index = 0; index < mRings.size(); ++index) {
+				delete mRings[index];
+			}
+		};
+
+		static LogFormatter& Instance() {
+			static LogFormatter instance;
+			return instance;
+		};
+
+		LogRing* AddRing() {
+			LogRing* ring = new LogRing();
+			std::lock_guard< std::mutex > lock(mRingsMutex);
+			mRings.push_back(ring);
+			return ring;
+		};
+
+		void SetSink(LogSink sink) {
+			std::lock_guard< std::mutex > lock(mDrainMutex);
+			mSink = sink;
+		};
+
+		// Called after each record, so it only costs a load unless the formatter is asleep; the first record since then
+		//	wakes it.
+		void WakeIfIdle() {
+			if(mIdle.load() && mIdle.exchange(false)) {
+				std::lock_guard< std::mutex > lock(mWaitMutex);
+				mWaitCondition.notify_one();
+			}
+		};
+
+		uint64_t GetDroppedCount() {
+			std::lock_guard< std::mutex > lock(mRingsMutex);
+			uint64_t result = mRetiredDropped;
+			for(size_t index = 0; index < mRings.size(); ++index) {
+				result += mRings[index]->mDropped.load(std::memory_order_relaxed);
+			}
+			return result;
+		};
+
+		void DrainAll() {
+			std::lock_guard< std::mutex > drainLock(mDrainMutex);
+
+			std::vector< LogRing* > rings;
+			{
+				std::lock_guard< std::mutex > lock(mRingsMutex);
+				rings = mRings;
+			}
+
+			for(size_t index = 0; index < rings.size(); ++index) {
+				LogRing* ring = rings[index];
+
+				// Abandonment is checked before draining, so that nothing is written to a ring retired after it
+				const bool abandoned = ring->mAbandoned.load(std::memory_order_acquire);
+				ring->Drain([this](const LogRecord& record) { Format(record); });
+
+				if(abandoned) {
+					std::lock_guard< std::mutex > lock(mRingsMutex);
+					mRetiredDropped += ring->mDropped.load(std::memory_order_relaxed);
+					mRings.erase(std::find(mRings.begin(), mRings.end(), ring));
+					delete ring;
+				}
+			}
+		};
+
+	private:
+		void Run() {
+			std::unique_lock< std::mutex > lock(mWaitMutex);
+			while(!mStopping) {
+				lock.unlock();
+				DrainAll();
+				lock.lock();
+
+				// Idle is announced before the rings are checked one last time, so a record committed after the check
+				//	finds the formatter idle and wakes it, and an idle formatter doesn't wake up at all
+				mIdle.store(true);
+				if(!AllRingsEmpty()) {
+					mIdle.store(false);
+					continue;
+				}
+
+				mWaitCondition.wait(lock, [this] { return !mIdle.load() || mStopping; });
+				mIdle.store(false);
+			}
+		};
+
+		bool AllRingsEmpty() {
+			std::lock_guard< std::mutex > lock(mRingsMutex);
+			for(size_t index = 0; index < mRings.size(); ++index) {
+				if(!mRings[index]->IsEmpty()) {
+					return false;
+				}
+			}
+			return true;
+		};
+
+		void Format(const LogRecord& record) {
+			char line[512];
+			const uint64_t microseconds = record.mTimestampNs / 1000;
+			size_t length = snprintf(line, sizeof(line), "[%c %" PRIu64 ".%06" PRIu64 "] %s", "TDIWE"[record.mLevel % LOG_LEVEL_NONE],
+				microseconds / 1000000, microseconds % 1000000, record.mCategory);
+
+			size_t arg = 0;
+			for(const char* format = record.mFormat; *format != '\0' && length < sizeof(line) - 1; ++format) {
+				if(*format != '%') {
+					line[length++] = *format;
+					continue;
+				}
+
+				if(format[1] == '%') {
+					line[length++] = '%';
+					++format;
+					continue;
+				}
+
+				// Flags, width and precision are kept, the length modifier is replaced by the one the recorded
+				//	type needs
+				std::string spec("%");
+				const char* cursor = format + 1;
+				while(*cursor != '\0' && strchr("-+ #0123456789.", *cursor) != NULL) {
+					spec += *cursor++;
+				}
+				while(*cursor != '\0' && strchr("hljztL", *cursor) != NULL) {
+					++cursor;
+				}
+				if(*cursor == '\0') {
+					break;
+				}
+				const char conversion = *cursor;
+				format = cursor;
+
+				length += FormatArg(line + length, sizeof(line) - length, spec, conversion, record, arg++);
+				length = std::min(length, sizeof(line) - 1);
+			}
+			line[length] = '\0';
+
+			if(mSink != NULL) {
+				mSink(record.mLevel, line);
+			} else {
+				printf("%s\n", line);
+			}
+		};
+
+		size_t FormatArg(char* buffer, size_t size, std::string spec, char conversion, const LogRecord& record, size_t index) {
+			if(index >= record.mArgCount) {
+				return snprintf(buffer, size, "(missing)");
+			}
+
+			const LogRecord::Arg& arg = record.mArgs[index];
+			int result = 0;
+
+			switch(conversion) {
+				case 'd':
+				case 'i':
+					spec += "lld";
+					result = snprintf(buffer, size, spec.c_str(), arg.mType == LogRecord::Arg::UNSIGNED ? static_cast< long long >(arg.mUnsigned) : static_cast< long long >(arg.mInteger));
+					break;
+				case 'u':
+				case 'x':
+				case 'X':
+				case 'o':
+					spec += "ll";
+					spec += conversion;
+					result = snprintf(buffer, size, spec.c_str(), arg.mType == LogRecord::Arg::INTEGER ? static_cast< unsigned long long >(arg.mInteger) : static_cast< unsigned long long >(arg.mUnsigned));
+					break;
+				case 'c':
+					spec += 'c';
+					result = snprintf(buffer, size, spec.c_str(), static_cast< int >(arg.mInteger));
+					break;
+				case 'f':
+				case 'F':
+				case 'e':
+				case 'E':
+				case 'g':
+				case 'G':
+					spec += conversion;
+					result = snprintf(buffer, size, spec.c_str(), arg.mType == LogRecord::Arg::REAL ? arg.mReal : static_cast< double >(arg.mInteger));
+					break;
+				case 's':
+					spec += 's';
+					result = snprintf(buffer, size, spec.c_str(), arg.mType == LogRecord::Arg::STRING ? record.mStrings + arg.mStringOffset : "(?)");
+					break;
+				case 'p':
+					spec += 'p';
+					result = snprintf(buffer, size, spec.c_str(), arg.mPointer);
+					break;
+				default:
+					result = snprintf(buffer, size, "(?)");
+					break;
+			}
+
+			return result > 0 ? static_cast< size_t >(result) : 0;
+		};
+
+		LogSink mSink;
+		std::mutex mDrainMutex;
+		std::mutex mRingsMutex;
+		std::vector< LogRing* > mRings;
+		uint64_t mRetiredDropped;
+
+		std::mutex mWaitMutex;
+		std::condition_variable mWaitCondition;
+		std::atomic< bool > mIdle;
+		bool mStopping;
+		std::thread mThread;
+};
+
+// Hands a thread's ring over to the formatter to retire once the thread exits.
+struct LogRingHolder {
+	LogRingHolder() :
+		mRing(NULL)
+	{};
+	~LogRingHolder() {
+		if(mRing != NULL) {
+			mRing->mAbandoned.store(true, std::memory_order_release);
+		}
+	};
+	LogRing* mRing;
+};
+
+thread_local LogRingHolder tRing;
+
+} // namespace
+
+std::atomic< int > TBLog::sLevel(LOG_LEVEL_TRACE);
+
+void TBLog::SetLevel(LogLevel level) {
+	sLevel.store(level, std::memory_order_relaxed);
+}
+
+LogLevel TBLog::GetLevel() {
+	return static_cast< LogLevel >(sLevel.load(std::memory_order_relaxed));
+}
+
+void TBLog::SetSink(LogSink sink) {
+	LogFormatter::Instance().SetSink(sink);
+}
+
+void TBLog::Flush() {
+	LogFormatter::Instance().DrainAll();
+}
+
+uint64_t TBLog::GetDroppedCount() {
+	return LogFormatter::Instance().GetDroppedCount();
+}
+
+LogRecord* TBLog::BeginRecord() {
+	if(tRing.mRing == NULL) {
+		tRing.mRing = LogFormatter::Instance().AddRing();
+	}
+
+	return tRing.mRing->Begin();
+}
+
+void TBLog::CommitRecord() {
+	tRing.mRing->Commit();
+	LogFormatter::Instance().WakeIfIdle();
+}
+
+void TBLog::CaptureArg(LogRecord& record, const char* value) {
+	LogRecord::Arg& arg = record.mArgs[record.mArgCount++];
+	arg.mType = LogRecord::Arg::STRING;
+	arg.mStringOffset = record.mStringLength;
+
+	// Strings are truncated to whatever room is left in the record
+	const size_t room = LogRecord::STRING_CAPACITY - record.mStringLength - 1;
+	const size_t length = value != NULL ? std::min(strlen(value), room) : 0;
+	if(length > 0) {
+		memcpy(record.mStrings + record.mStringLength, value, length);
+	}
+	record.mStrings[record.mStringLength + length] = '\0';
+	record.mStringLength = static_cast< uint16_t >(std::min< size_t >(record.mStringLength + length + 1, LogRecord::STRING_CAPACITY - 1));
+}
+
+} // namespace twobulls
@@ -0,0 +1,405 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#include "TBLoopbackBus.h"
+
+#include "TBLog.h"
+
+#define TBLOOPBACKBUSLOG(...) TBLOG(TBLOG_LEVEL_TRACE, "twobulls::TBLoopbackBus", __VA_ARGS__)
+
+namespace twobulls {
+
+TBLoopbackBus::TBLoopbackBus() :
+	mMutex()
+	,mConnections(0)
+	,mInterfaces()
+	,mObjects()
+	,mSessionPorts()
+	,mSignals()
+	,mAnnounced(false)
+	,mAnnouncedPort(0)
+	,mAnnouncement()
+	,mHandlers(std::make_shared< const Handlers >())
+	,mNextHandler(1)
+	,mNextSerial(1)
+{
+}
+
+TBLoopbackBus::~TBLoopbackBus() {
+}
+
+bool TBLoopbackBus::Connect(const std::string& applicationName) {
+	TBLOOPBACKBUSLOG("::Connect -> applicationName = %s", applicationName.c_str());
+
+	std::lock_guard< std::mutex > lock(mMutex);
+	++mConnections;
+
+	TBLOOPBACKBUSLOG("::Connect <- %d", true);
+
+	return true;
+}
+
+// The last object to disconnect takes everything it defined with it, other than the handlers, which belong to the
+//	consumers rather than to the objects.
+void TBLoopbackBus::Disconnect() {
+	TBLOOPBACKBUSLOG("::Disconnect -> ");
+
+	std::lock_guard< std::mutex > lock(mMutex);
+
+	if(mConnections > 0 && --mConnections == 0) {
+		mObjects.clear();
+		mInterfaces.clear();
+		mSessionPorts.clear();
+		mSignals.clear();
+		mAnnounced = false;
+	}
+
+	TBLOOPBACKBUSLOG("::Disconnect <-");
+}
+
+bool TBLoopbackBus::DefineInterface(const BusInterface& definition) {
+	TBLOOPBACKBUSLOG("::DefineInterface -> name = %s", definition.mName.c_str());
+
+	std::lock_guard< std::mutex > lock(mMutex);
+
+	bool result = mConnections > 0;
+	TBLOOPBACKBUSLOG("::DefineInterface -- mConnections <- %d", result);
+
+	if(result) {
+		mInterfaces.insert(std::make_pair(definition.mName, definition));
+	}
+
+	TBLOOPBACKBUSLOG("::DefineInterface <- %d", result);
+
+	return result;
+}
+
+bool TBLoopbackBus::RegisterObject(const std::string& path, const std::string& interfaceName, TBBusEndpoint& endpoint) {
+	TBLOOPBACKBUSLOG("::RegisterObject -> path = %s, interfaceName = %s", path.c_str(), interfaceName.c_str());
+
+	std::lock_guard< std::mutex > lock(mMutex);
+
+	std::map< std::string, BusInterface >::const_iterator definition = mInterfaces.find(interfaceName);
+	bool result = mConnections > 0 && definition != mInterfaces.end() && mObjects.find(path) == mObjects.end();
+	TBLOOPBACKBUSLOG("::RegisterObject -- mConnections && mInterfaces.find && !mObjects.find <- %d", result);
+
+	if(result) {
+		mObjects[path] = Object(&definition->second, &endpoint);
+	}
+
+	TBLOOPBACKBUSLOG("::RegisterObject <- %d", result);
+
+	return result;
+}
+
+void TBLoopbackBus::UnregisterObject(const std::string& path) {
+	TBLOOPBACKBUSLOG("::UnregisterObject -> path = %s", path.c_str());
+
+	std::lock_guard< std::mutex > lock(mMutex);
+
+	mObjects.erase(path);
+
+	// The handles of its Signals stay taken, so that they don't come to mean another object's
+	for(std::vector< std::shared_ptr< const SignalEntry > >::iterator signal = mSignals.begin(); signal != mSignals.end(); ++signal) {
+		if(*signal != NULL && (*signal)->mPath == path) {
+			signal->reset();
+		}
+	}
+
+	TBLOOPBACKBUSLOG("::UnregisterObject <-");
+}
+
+// Nobody can join a session on the loopback, so the port is only reserved.
+bool TBLoopbackBus::BindSessionPort(ajn::SessionPort port, bool multipoint, ajn::SessionPortListener& portListener, ajn::SessionListener& sessionListener) {
+	std::lock_guard< std::mutex > lock(mMutex);
+
+	return mConnections > 0 && mSessionPorts.insert(port).second;
+}
+
+void TBLoopbackBus::UnbindSessionPort(ajn::SessionPort port) {
+	std::lock_guard< std::mutex > lock(mMutex);
+
+	mSessionPorts.erase(port);
+}
+
+BusSignalHandle TBLoopbackBus::ResolveSignal(const std::string& path, const std::string& signalName) {
+	TBBusEndpoint* endpoint = NULL;
+
+	std::lock_guard< std::mutex > lock(mMutex);
+
+	if(FindMember(path, signalName, BUS_MEMBER_SIGNAL, endpoint) == NULL) {
+		return INVALID_BUS_SIGNAL;
+	}
+
+	mSignals.push_back(std::make_shared< const SignalEntry >(path, signalName));
+
+	return mSignals.size() - 1;
+}
+
+bool TBLoopbackBus::EmitSignal(BusSignalHandle signal, const ajn::MsgArg* args, size_t argCount, ajn::SessionId session, uint16_t timeToLive, uint32_t* serial) {
+	std::shared_ptr< const SignalEntry > entry;
+	{
+		std::lock_guard< std::mutex > lock(mMutex);
+		if(signal < mSignals.size()) {
+			entry = mSignals[signal];
+		}
+	}
+
+	bool result = entry != NULL;
+
+	if(result && serial != NULL) {
+		// Zero is taken to mean no Signal, so it is skipped when the serials wrap around
+		while((*serial = mNextSerial.fetch_add(1, std::memory_order_relaxed)) == 0) {
+		}
+	}
+
+	if(result) {
+		const std::shared_ptr< const Handlers > handlers = std::atomic_load(&mHandlers);
+		for(Handlers::const_iterator handler = handlers->begin(); handler != handlers->end(); ++handler) {
+			if(handler->mSignal) {
+				handler->mSignal(entry->mPath, entry->mName, args, argCount);
+			}
+		}
+	}
+
+	return result;
+}
+
+bool TBLoopbackBus::CancelSignal(BusSignalHandle signal, uint32_t serial) {
+	return true;
+}
+
+bool TBLoopbackBus::EmitPropertiesChanged(const std::string& path, const char** propertyNames, size_t propertyCount, ajn::SessionId session) {
+	bool result = false;
+	{
+		std::lock_guard< std::mutex > lock(mMutex);
+		result = mObjects.find(path) != mObjects.end();
+	}
+
+	if(result) {
+		const std::shared_ptr< const Handlers > handlers = std::atomic_load(&mHandlers);
+		for(Handlers::const_iterator handler = handlers->begin(); handler != handlers->end(); ++handler) {
+			if(handler->mProperties) {
+				handler->mProperties(path, propertyNames, propertyCount);
+			}
+		}
+	}
+
+	return result;
+}
+
+bool TBLoopbackBus::Announce(ajn::SessionPort port, const TBAboutDescription& about) {
+	TBLOOPBACKBUSLOG("::Announce -> port = %d", port);
+
+	std::lock_guard< std::mutex > lock(mMutex);
+
+	bool result = mConnections > 0;
+	TBLOOPBACKBUSLOG("::Announce -- mConnections <- %d", result);
+
+	if(result) {
+		mAnnounced = true;
+		mAnnouncedPort = port;
+		mAnnouncement = about;
+	}
+
+	TBLOOPBACKBUSLOG("::Announce <- %d", result);
+
+	return result;
+}
+
+// Calls on the loopback bus come without a Message, so are always replied to through their ActionReply.
+QStatus TBLoopbackBus::ReplyToCall(const std::string& path, const ajn::Message& message, const ajn::MsgArg* args, size_t argCount) {
+	return ER_NOT_IMPLEMENTED;
+}
+
+QStatus TBLoopbackBus::ReplyToCall(const std::string& path, const ajn::Message& message, const char* error, const char* errorMessage) {
+	return ER_NOT_IMPLEMENTED;
+}
+
+QStatus TBLoopbackBus::ReplyToCall(const std::string& path, const ajn::Message& message, QStatus status) {
+	return ER_NOT_IMPLEMENTED;
+}
+
+size_t TBLoopbackBus::AddSignalHandler(const LoopbackSignalHandler& handler) {
+	Handler entry;
+	entry.mSignal = handler;
+	return AddHandler(entry);
+}
+
+size_t TBLoopbackBus::AddPropertiesChangedHandler(const LoopbackPropertiesHandler& handler) {
+	Handler entry;
+	entry.mProperties = handler;
+	return AddHandler(entry);
+}
+
+size_t TBLoopbackBus::AddHandler(const Handler& handler) {
+	std::lock_guard< std::mutex > lock(mMutex);
+
+	std::shared_ptr< Handlers > handlers = std::make_shared< Handlers >(*std::atomic_load(&mHandlers));
+	handlers->push_back(handler);
+	handlers->back().mId = mNextHandler++;
+	std::atomic_store(&mHandlers, std::shared_ptr< const Handlers >(handlers));
+
+	return handlers->back().mId;
+}
+
+void TBLoopbackBus::RemoveHandler(size_t handler) {
+	std::lock_guard< std::mutex > lock(mMutex);
+
+	const std::shared_ptr< const Handlers > current = std::atomic_load(&mHandlers);
+	std::shared_ptr< Handlers > handlers = std::make_shared< Handlers >();
+	handlers->reserve(current->size());
+
+	for(Handlers::const_iterator entry = current->begin(); entry != current->end(); ++entry) {
+		if(entry->mId != handler) {
+			handlers->push_back(*entry);
+		}
+	}
+
+	std::atomic_store(&mHandlers, std::shared_ptr< const Handlers >(handlers));
+}
+
+QStatus TBLoopbackBus::CallMethod(const std::string& path, const std::string& methodName, const ajn::MsgArg* args, size_t argCount, std::vector< ajn::MsgArg >& replyArgs) {
+	TBLOOPBACKBUSLOG("::CallMethod -> path = %s, methodName = %s", path.c_str(), methodName.c_str());
+
+	TBBusEndpoint* endpoint = NULL;
+	std::string inputSignature;
+	QStatus status = ER_OK;
+	{
+		std::lock_guard< std::mutex > lock(mMutex);
+
+		const BusMember* member = FindMember(path, methodName, BUS_MEMBER_METHOD, endpoint);
+		if(endpoint == NULL) {
+			status = ER_BUS_NO_SUCH_OBJECT;
+		} else if(member == NULL) {
+			status = ER_BUS_INTERFACE_NO_SUCH_MEMBER;
+		} else {
+			inputSignature = member->mInputSignature;
+		}
+	}
+
+	if(status == ER_OK && inputSignature != ajn::MsgArg::Signature(args, argCount).c_str()) {
+		status = ER_BUS_BAD_SIGNATURE;
+	}
+
+	replyArgs.clear();
+
+	if(status == ER_OK) {
+		LoopbackReply reply(replyArgs);
+		status = endpoint->HandleCall(BusCall(methodName.c_str(), args, argCount), reply);
+	}
+
+	TBLOOPBACKBUSLOG("::CallMethod <- %d", status);
+
+	return status;
+}
+
+QStatus TBLoopbackBus::GetProperty(const std::string& path, const std::string& propertyName, ajn::MsgArg& value) {
+	TBBusEndpoint* endpoint = NULL;
+	const BusMember* member = NULL;
+	{
+		std::lock_guard< std::mutex > lock(mMutex);
+		member = FindMember(path, propertyName, BUS_MEMBER_PROPERTY, endpoint);
+	}
+
+	return member != NULL ? endpoint->GetPropertyValue(propertyName.c_str(), value) : ER_BUS_NO_SUCH_PROPERTY;
+}
+
+QStatus TBLoopbackBus::SetProperty(const std::string& path, const std::string& propertyName, const ajn::MsgArg& value) {
+	TBBusEndpoint* endpoint = NULL;
+	QStatus status = ER_OK;
+	{
+		std::lock_guard< std::mutex > lock(mMutex);
+
+		const BusMember* member = FindMember(path, propertyName, BUS_MEMBER_PROPERTY, endpoint);
+		if(member == NULL) {
+			status = ER_BUS_NO_SUCH_PROPERTY;
+		} else if(!member->mWritable) {
+			status = ER_BUS_PROPERTY_ACCESS_DENIED;
+		} else if(!value.HasSignature(member->mInputSignature.c_str())) {
+			status = ER_BUS_SET_WRONG_SIGNATURE;
+		}
+	}
+
+	if(status == ER_OK) {
+		ajn::MsgArg copy(value);
+		status = endpoint->SetPropertyValue(propertyName.c_str(), copy);
+	}
+
+	return status;
+}
+
+bool TBLoopbackBus::GetAnnouncement(ajn::SessionPort& port, TBAboutDescription& about) const {
+	std::lock_guard< std::mutex > lock(mMutex);
+
+	if(mAnnounced) {
+		port = mAnnouncedPort;
+		about = mAnnouncement;
+	}
+
+	return mAnnounced;
+}
+
+bool TBLoopbackBus::IsConnected() const {
+	std::lock_guard< std::mutex > lock(mMutex);
+	return mConnections > 0;
+}
+
+std::vector< std::string > TBLoopbackBus::GetObjectPaths() const {
+	std::lock_guard< std::mutex > lock(mMutex);
+
+	std::vector< std::string > result;
+	for(std::map< std::string, Object >::const_iterator object = mObjects.begin(); object != mObjects.end(); ++object) {
+		result.push_back(object->first);
+	}
+
+	return result;
+}
+
+// Called with mMutex held. 'endpoint' is set if the object exists, whether or not the member does.
+const BusMember* TBLoopbackBus::FindMember(const std::string& path, const std::string& name, BusMemberType type, TBBusEndpoint*& endpoint) const {
+	std::map< std::string, Object >::const_iterator object = mObjects.find(path);
+
+	if(object == mObjects.end()) {
+		endpoint = NULL;
+		return NULL;
+	}
+
+	endpoint = object->second.mEndpoint;
+
+	return object->second.mDefinition->FindMember(name, type);
+}
+
+TBLoopbackBus::LoopbackReply::LoopbackReply(std::vector< ajn::MsgArg >& replyArgs) :
+	mReplied(false)
+	,mReplyArgs(replyArgs)
+{
+}
+
+QStatus TBLoopbackBus::LoopbackReply::Reply(const ajn::MsgArg* args, size_t argCount) {
+	mReplied = true;
+	mReplyArgs.assign(args, args + argCount);
+
+	for(std::vector< ajn::MsgArg >::iterator arg = mReplyArgs.begin(); arg != mReplyArgs.end(); ++arg) {
+		arg->Stabilize();
+	}
+
+	return ER_OK;
+}
+
+} // namespace twobulls
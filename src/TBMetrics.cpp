@@ -0,0 +1,355 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#include "TBMetrics.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace twobulls {
+
+namespace {
+
+const double NANOSECONDS_PER_SECOND = 1e9;
+const int ACCEPT_POLL_MS = 200;
+
+// Spreads threads over the shards of every counter in the order they first count something.
+std::atomic< size_t > gNextShard(0);
+
+size_t ThreadShard() {
+	static thread_local const size_t shard = gNextShard.fetch_add(1, std::memory_order_relaxed);
+	return shard;
+}
+
+std::string FormatDouble(double value) {
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%.9g", value);
+	return buffer;
+}
+
+std::string FormatCount(uint64_t value) {
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%" PRIu64, value);
+	return buffer;
+}
+
+// Joins the labels of a metric with one more, into the braces that follow its name, if there are any.
+std::string Labels(const std::string& labels, const std::string& extra = std::string()) {
+	std::string result(labels);
+	if(!extra.empty()) {
+		result += (result.empty() ? "" : ",") + extra;
+	}
+	return result.empty() ? result : "{" + result + "}";
+}
+
+} // namespace
+
+TBCounter::TBCounter() {
+	for(size_t index = 0; index < SHARD_COUNT; ++index) {
+		mShards[index].mValue.store(0, std::memory_order_relaxed);
+	}
+}
+
+void TBCounter::Add(uint64_t count) {
+	mShards[ThreadShard() % SHARD_COUNT].mValue.fetch_add(count, std::memory_order_relaxed);
+}
+
+uint64_t TBCounter::Get() const {
+	uint64_t result = 0;
+	for(size_t index = 0; index < SHARD_COUNT; ++index) {
+		result += mShards[index].mValue.load(std::memory_order_relaxed);
+	}
+	return result;
+}
+
+TBLatencyHistogram::TBLatencyHistogram() :
+	mCount(0)
+	,mSum(0)
+	,mMax(0)
+{
+	for(size_t index = 0; index < BUCKET_COUNT; ++index) {
+		mBuckets[index].store(0, std::memory_order_relaxed);
+	}
+}
+
+size_t TBLatencyHistogram::BucketOf(uint64_t value) {
+	const uint64_t maxValue = (static_cast< uint64_t >(1) << MAX_VALUE_BITS) - 1;
+	if(value > maxValue) {
+		value = maxValue;
+	}
+	if(value < SUB_BUCKET_COUNT) {
+		return static_cast< size_t >(value);
+	}
+	unsigned int power = 0;
+	while((value >> (power + 1)) != 0) {
+		++power;
+	}
+	// The top SUB_BUCKET_BITS + 1 bits of the value pick the bucket within its power of two
+	const unsigned int shift = power - SUB_BUCKET_BITS;
+	return SUB_BUCKET_COUNT * shift + static_cast< size_t >(value >> shift);
+}
+
+uint64_t TBLatencyHistogram::BucketLimit(size_t bucket) {
+	if(bucket < 2 * SUB_BUCKET_COUNT) {
+		return bucket;
+	}
+	const unsigned int shift = static_cast< unsigned int >(bucket / SUB_BUCKET_COUNT - 1);
+	const uint64_t mantissa = bucket - SUB_BUCKET_COUNT * shift;
+	return ((mantissa + 1) << shift) - 1;
+}
+
+void TBLatencyHistogram::Record(uint64_t nanoseconds) {
+	mBuckets[BucketOf(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+	mCount.fetch_add(1, std::memory_order_relaxed);
+	mSum.fetch_add(nanoseconds, std::memory_order_relaxed);
+	uint64_t max = mMax.load(std::memory_order_relaxed);
+	while(nanoseconds > max && !mMax.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed)) {
+	}
+}
+
+uint64_t TBLatencyHistogram::GetCount() const {
+	return mCount.load(std::memory_order_relaxed);
+}
+
+uint64_t TBLatencyHistogram::GetSum() const {
+	return mSum.load(std::memory_order_relaxed);
+}
+
+uint64_t TBLatencyHistogram::GetMax() const {
+	return mMax.load(std::memory_order_relaxed);
+}
+
+uint64_t TBLatencyHistogram::GetPercentile(double percentile) const {
+	uint64_t total = 0;
+	for(size_t index = 0; index < BUCKET_COUNT; ++index) {
+		total += mBuckets[index].load(std::memory_order_relaxed);
+	}
+	if(total == 0) {
+		return 0;
+	}
+	const double clamped = percentile < 0 ? 0 : (percentile > 1 ? 1 : percentile);
+	uint64_t rank = static_cast< uint64_t >(clamped * total + 0.5);
+	if(rank == 0) {
+		rank = 1;
+	}
+	uint64_t seen = 0;
+	for(size_t index = 0; index < BUCKET_COUNT; ++index) {
+		seen += mBuckets[index].load(std::memory_order_relaxed);
+		if(seen >= rank) {
+			// No bucket reaches past the largest value recorded
+			const uint64_t limit = BucketLimit(index);
+			const uint64_t max = GetMax();
+			return limit < max ? limit : max;
+		}
+	}
+	return GetMax();
+}
+
+uint64_t TBLatencyHistogram::CountAtOrBelow(uint64_t nanoseconds) const {
+	const size_t last = BucketOf(nanoseconds);
+	uint64_t result = 0;
+	for(size_t index = 0; index <= last; ++index) {
+		result += mBuckets[index].load(std::memory_order_relaxed);
+	}
+	return result;
+}
+
+TBMetricsRegistry::TBMetricsRegistry() {
+}
+
+TBMetricsRegistry::~TBMetricsRegistry() {
+	for(std::vector< Metric >::iterator metric = mMetrics.begin(); metric != mMetrics.end(); ++metric) {
+		delete metric->mCounter;
+		delete metric->mHistogram;
+	}
+}
+
+TBCounter& TBMetricsRegistry::AddCounter(const std::string& name, const std::string& help, const std::string& labels) {
+	Metric metric = { name, help, labels, new TBCounter(), NULL };
+	mMetrics.push_back(metric);
+	return *metric.mCounter;
+}
+
+TBLatencyHistogram& TBMetricsRegistry::AddHistogram(const std::string& name, const std::string& help, const std::string& labels) {
+	Metric metric = { name, help, labels, NULL, new TBLatencyHistogram() };
+	mMetrics.push_back(metric);
+	return *metric.mHistogram;
+}
+
+std::string TBMetricsRegistry::ToPrometheus() const {
+	// 1, 2.5 and 5 of each decade from 1us to 10s
+	static const double BUCKET_STEPS[] = { 1, 2.5, 5 };
+	std::string result;
+	for(size_t index = 0; index < mMetrics.size(); ++index) {
+		const Metric& metric = mMetrics[index];
+		if(index == 0 || mMetrics[index - 1].mName != metric.mName) {
+			result += "# HELP " + metric.mName + " " + metric.mHelp + "\n";
+			result += "# TYPE " + metric.mName + (metric.mCounter != NULL ? " counter\n" : " histogram\n");
+		}
+		if(metric.mCounter != NULL) {
+			result += metric.mName + Labels(metric.mLabels) + " " + FormatCount(metric.mCounter->Get()) + "\n";
+			continue;
+		}
+		const TBLatencyHistogram& histogram = *metric.mHistogram;
+		// Read the count first, so that no bucket exceeds it
+		const uint64_t count = histogram.GetCount();
+		const uint64_t sum = histogram.GetSum();
+		for(double decade = 1e-6; decade < 11; decade *= 10) {
+			for(size_t step = 0; step < sizeof(BUCKET_STEPS) / sizeof(BUCKET_STEPS[0]) && decade * BUCKET_STEPS[step] < 11; ++step) {
+				const double seconds = decade * BUCKET_STEPS[step];
+				const uint64_t below = histogram.CountAtOrBelow(static_cast< uint64_t >(seconds * NANOSECONDS_PER_SECOND + 0.5));
+				result += metric.mName + "_bucket" + Labels(metric.mLabels, "le=\"" + FormatDouble(seconds) + "\"") + " "
+					+ FormatCount(below < count ? below : count) + "\n";
+			}
+		}
+		result += metric.mName + "_bucket" + Labels(metric.mLabels, "le=\"+Inf\"") + " " + FormatCount(count) + "\n";
+		result += metric.mName + "_sum" + Labels(metric.mLabels) + " " + FormatDouble(sum / NANOSECONDS_PER_SECOND) + "\n";
+		result += metric.mName + "_count" + Labels(metric.mLabels) + " " + FormatCount(count) + "\n";
+	}
+	return result;
+}
+
+std::vector< std::pair< std::string, double > > TBMetricsRegistry::GetValues() const {
+	std::vector< std::pair< std::string, double > > result;
+	for(std::vector< Metric >::const_iterator metric = mMetrics.begin(); metric != mMetrics.end(); ++metric) {
+		const std::string labels(Labels(metric->mLabels));
+		if(metric->mCounter != NULL) {
+			result.push_back(std::make_pair(metric->mName + labels, static_cast< double >(metric->mCounter->Get())));
+			continue;
+		}
+		const TBLatencyHistogram& histogram = *metric->mHistogram;
+		result.push_back(std::make_pair(metric->mName + "_count" + labels, static_cast< double >(histogram.GetCount())));
+		result.push_back(std::make_pair(metric->mName + "_sum" + labels, histogram.GetSum() / NANOSECONDS_PER_SECOND));
+		result.push_back(std::make_pair(metric->mName + "_p50" + labels, histogram.GetPercentile(0.5) / NANOSECONDS_PER_SECOND));
+		result.push_back(std::make_pair(metric->mName + "_p99" + labels, histogram.GetPercentile(0.99) / NANOSECONDS_PER_SECOND));
+		result.push_back(std::make_pair(metric->mName + "_max" + labels, histogram.GetMax() / NANOSECONDS_PER_SECOND));
+	}
+	return result;
+}
+
+bool TBMetricsRegistry::WritePrometheusFile(const std::string& path) const {
+	const std::string temporary(path + ".tmp");
+	const std::string text(ToPrometheus());
+	FILE* file = fopen(temporary.c_str(), "w");
+	bool result = file != NULL;
+	if(result) {
+		result = fwrite(text.data(), 1, text.size(), file) == text.size();
+		result = fclose(file) == 0 && result;
+	}
+	if(result) {
+		result = rename(temporary.c_str(), path.c_str()) == 0;
+	}
+	if(!result && file != NULL) {
+		unlink(temporary.c_str());
+	}
+	return result;
+}
+
+TBMetricsSocket::TBMetricsSocket(const TBMetricsRegistry& registry) :
+	mRegistry(registry)
+	,mListener(-1)
+	,mStopping(false)
+{
+}
+
+TBMetricsSocket::~TBMetricsSocket() {
+	Stop();
+}
+
+bool TBMetricsSocket::Start(const std::string& path) {
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	bool result = mListener < 0 && !path.empty() && path.size() < sizeof(address.sun_path);
+	if(result) {
+		strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+		mListener = socket(AF_UNIX, SOCK_STREAM, 0);
+		result = mListener >= 0;
+	}
+	if(result) {
+		unlink(path.c_str());
+		result = bind(mListener, reinterpret_cast< sockaddr* >(&address), sizeof(address)) == 0 && listen(mListener, 4) == 0;
+		if(!result) {
+			close(mListener);
+			mListener = -1;
+		}
+	}
+	if(result) {
+		mPath = path;
+		mStopping = false;
+		mThread = std::thread(&TBMetricsSocket::ServeLoop, this);
+	}
+	return result;
+}
+
+void TBMetricsSocket::Stop() {
+	if(mListener >= 0) {
+		mStopping = true;
+		if(mThread.joinable()) {
+			mThread.join();
+		}
+		close(mListener);
+		mListener = -1;
+		unlink(mPath.c_str());
+		mPath.clear();
+	}
+}
+
+void TBMetricsSocket::ServeLoop() {
+	while(!mStopping) {
+		// Poll rather than block in accept, so that Stop is noticed
+		pollfd listener = { mListener, POLLIN, 0 };
+		if(poll(&listener, 1, ACCEPT_POLL_MS) <= 0) {
+			continue;
+		}
+		const int connection = accept(mListener, NULL, NULL);
+		if(connection < 0) {
+			continue;
+		}
+#if defined(SO_NOSIGPIPE)
+		const int enabled = 1;
+		setsockopt(connection, SOL_SOCKET, SO_NOSIGPIPE, &enabled, sizeof(enabled));
+#endif
+#if defined(MSG_NOSIGNAL)
+		const int flags = MSG_NOSIGNAL;
+#else
+		const int flags = 0;
+#endif
+		const std::string text(mRegistry.ToPrometheus());
+		size_t sent = 0;
+		while(sent < text.size()) {
+			const ssize_t count = send(connection, text.data() + sent, text.size() - sent, flags);
+			if(count < 0 && errno == EINTR) {
+				continue;
+			}
+			if(count <= 0) {
+				break;
+			}
+			sent += static_cast< size_t >(count);
+		}
+		close(connection);
+	}
+}
+
+} // namespace twobulls
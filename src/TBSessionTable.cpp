@@ -0,0 +1,228 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#include "TBSessionTable.h"
+
+#include <string.h>
+
+#include "TBClock.h"
+
+namespace twobulls {
+
+static size_t Align(size_t offset, size_t alignment) {
+	return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+static size_t AlignmentOf(char typeCode) {
+	switch(typeCode) {
+		case ajn::ALLJOYN_INT16:
+		case ajn::ALLJOYN_UINT16:
+			return 2;
+		case ajn::ALLJOYN_BOOLEAN:
+		case ajn::ALLJOYN_INT32:
+		case ajn::ALLJOYN_UINT32:
+		case ajn::ALLJOYN_HANDLE:
+		case ajn::ALLJOYN_STRING:
+		case ajn::ALLJOYN_OBJECT_PATH:
+		case ajn::ALLJOYN_ARRAY:
+			return 4;
+		case ajn::ALLJOYN_INT64:
+		case ajn::ALLJOYN_UINT64:
+		case ajn::ALLJOYN_DOUBLE:
+		case ajn::ALLJOYN_STRUCT:
+		case ajn::ALLJOYN_DICT_ENTRY:
+		case '(':
+		case '{':
+			return 8;
+		default:
+			return 1;
+	}
+}
+
+// Returns the offset just past 'arg' when it is marshalled at 'offset', following the D-Bus alignment rules.
+static size_t MarshalledEnd(const ajn::MsgArg& arg, size_t offset) {
+	switch(arg.typeId) {
+		case ajn::ALLJOYN_BYTE:
+			return offset + 1;
+		case ajn::ALLJOYN_INT16:
+		case ajn::ALLJOYN_UINT16:
+			return Align(offset, 2) + 2;
+		case ajn::ALLJOYN_BOOLEAN:
+		case ajn::ALLJOYN_INT32:
+		case ajn::ALLJOYN_UINT32:
+		case ajn::ALLJOYN_HANDLE:
+			return Align(offset, 4) + 4;
+		case ajn::ALLJOYN_INT64:
+		case ajn::ALLJOYN_UINT64:
+		case ajn::ALLJOYN_DOUBLE:
+			return Align(offset, 8) + 8;
+		case ajn::ALLJOYN_STRING:
+			return Align(offset, 4) + 4 + arg.v_string.len + 1;
+		case ajn::ALLJOYN_OBJECT_PATH:
+			return Align(offset, 4) + 4 + arg.v_objPath.len + 1;
+		case ajn::ALLJOYN_SIGNATURE:
+			return offset + 1 + arg.v_signature.len + 1;
+		case ajn::ALLJOYN_VARIANT:
+			return MarshalledEnd(*arg.v_variant.val, offset + 1 + arg.v_variant.val->Signature().size() + 1);
+		case ajn::ALLJOYN_STRUCT:
+			offset = Align(offset, 8);
+			for(size_t index = 0; index < arg.v_struct.numMembers; ++index) {
+				offset = MarshalledEnd(arg.v_struct.members[index], offset);
+			}
+			return offset;
+		case ajn::ALLJOYN_DICT_ENTRY:
+			return MarshalledEnd(*arg.v_dictEntry.val, MarshalledEnd(*arg.v_dictEntry.key, Align(offset, 8)));
+		case ajn::ALLJOYN_ARRAY:
+			offset = Align(Align(offset, 4) + 4, AlignmentOf(arg.v_array.GetElemSig()[0]));
+			for(size_t index = 0; index < arg.v_array.GetNumElements(); ++index) {
+				offset = MarshalledEnd(arg.v_array.GetElements()[index], offset);
+			}
+			return offset;
+		default:
+			break;
+	}
+
+	// Arrays of scalars are typed by the element type code in the second byte, eg. ALLJOYN_BYTE_ARRAY
+	if((arg.typeId & 0xFF) == ajn::ALLJOYN_ARRAY) {
+		const char elementType = static_cast< char >(arg.typeId >> 8);
+		const size_t elementSize = elementType == ajn::ALLJOYN_BYTE ? 1 : AlignmentOf(elementType);
+		return Align(Align(offset, 4) + 4, elementSize) + arg.v_scalarArray.numElements * elementSize;
+	}
+
+	return offset;
+}
+
+size_t MarshalledSize(const ajn::MsgArg* args, size_t argCount) {
+	size_t result = 0;
+
+	for(size_t index = 0; index < argCount; ++index) {
+		result = MarshalledEnd(args[index], result);
+	}
+
+	return result;
+}
+
+TBSessionTable::TBSessionTable() :
+	mEntries(std::make_shared< const Entries >())
+	,mWriteMutex()
+{
+}
+
+void TBSessionTable::Add(ajn::SessionId id, const char* joiner) {
+	std::lock_guard< std::mutex > lock(mWriteMutex);
+
+	std::shared_ptr< Entries > entries = std::make_shared< Entries >(*std::atomic_load(&mEntries));
+	entries->push_back(std::make_shared< Entry >(id, joiner != NULL ? joiner : "", MonotonicNanoseconds()));
+	std::atomic_store(&mEntries, std::shared_ptr< const Entries >(entries));
+}
+
+void TBSessionTable::Remove(ajn::SessionId id, const char* name) {
+	std::lock_guard< std::mutex > lock(mWriteMutex);
+
+	const std::shared_ptr< const Entries > current = std::atomic_load(&mEntries);
+	std::shared_ptr< Entries > entries = std::make_shared< Entries >();
+	entries->reserve(current->size());
+
+	for(Entries::const_iterator entry = current->begin(); entry != current->end(); ++entry) {
+		if((*entry)->mId != id || (name != NULL && (*entry)->mJoiner != name)) {
+			entries->push_back(*entry);
+		}
+	}
+
+	std::atomic_store(&mEntries, std::shared_ptr< const Entries >(entries));
+}
+
+void TBSessionTable::Clear() {
+	std::lock_guard< std::mutex > lock(mWriteMutex);
+
+	std::atomic_store(&mEntries, std::make_shared< const Entries >());
+}
+
+void TBSessionTable::CountReceived(ajn::SessionId id, const char* sender, size_t bytes) {
+	const std::shared_ptr< const Entries > entries = std::atomic_load(&mEntries);
+
+	Entry* entry = Find(*entries, id, sender);
+	if(entry != NULL) {
+		entry->mMessagesReceived.fetch_add(1, std::memory_order_relaxed);
+		entry->mBytesReceived.fetch_add(bytes, std::memory_order_relaxed);
+	}
+}
+
+void TBSessionTable::CountSent(ajn::SessionId id, const char* destination, size_t bytes) {
+	const std::shared_ptr< const Entries > entries = std::atomic_load(&mEntries);
+
+	Entry* entry = Find(*entries, id, destination);
+	if(entry != NULL) {
+		entry->mMessagesSent.fetch_add(1, std::memory_order_relaxed);
+		entry->mBytesSent.fetch_add(bytes, std::memory_order_relaxed);
+	}
+}
+
+void TBSessionTable::CountSignal(ajn::SessionId id, size_t bytes) {
+	const std::shared_ptr< const Entries > entries = std::atomic_load(&mEntries);
+
+	for(Entries::const_iterator entry = entries->begin(); entry != entries->end(); ++entry) {
+		if((*entry)->mId == id) {
+			(*entry)->mMessagesSent.fetch_add(1, std::memory_order_relaxed);
+			(*entry)->mBytesSent.fetch_add(bytes, std::memory_order_relaxed);
+		}
+	}
+}
+
+std::vector< SessionInfo > TBSessionTable::GetSnapshot() const {
+	const std::shared_ptr< const Entries > entries = std::atomic_load(&mEntries);
+
+	std::vector< SessionInfo > result(entries->size());
+	for(size_t index = 0; index < entries->size(); ++index) {
+		const Entry& entry = *(*entries)[index];
+		SessionInfo& info = result[index];
+		info.mId = entry.mId;
+		info.mJoiner = entry.mJoiner;
+		info.mJoinedNs = entry.mJoinedNs;
+		info.mMessagesReceived = entry.mMessagesReceived.load(std::memory_order_relaxed);
+		info.mBytesReceived = entry.mBytesReceived.load(std::memory_order_relaxed);
+		info.mMessagesSent = entry.mMessagesSent.load(std::memory_order_relaxed);
+		info.mBytesSent = entry.mBytesSent.load(std::memory_order_relaxed);
+	}
+
+	return result;
+}
+
+size_t TBSessionTable::GetMemberCount() const {
+	return std::atomic_load(&mEntries)->size();
+}
+
+// Prefers the member with the given name, but falls back on any member of the session, as the sender of a message
+//	isn't necessarily the name it joined with.
+TBSessionTable::Entry* TBSessionTable::Find(const Entries& entries, ajn::SessionId id, const char* name) const {
+	Entry* result = NULL;
+
+	for(Entries::const_iterator entry = entries.begin(); entry != entries.end(); ++entry) {
+		if((*entry)->mId == id) {
+			if(name != NULL && (*entry)->mJoiner == name) {
+				return entry->get();
+			} else if(result == NULL) {
+				result = entry->get();
+			}
+		}
+	}
+
+	return result;
+}
+
+} // namespace twobulls
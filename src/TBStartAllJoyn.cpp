@@ -19,27 +19,25 @@
 #include "TBStartAllJoyn.h"
 
 #include <algorithm>
+#include <limits>
 
-#include "tinyxml2.h"
-
-#if defined(ALLJOYN_VERSION) && ALLJOYN_VERSION >= 1504
-#include <alljoyn/Init.h>
-#endif
+#include "TBAboutDescription.h"
+#include "TBAllJoynRuntime.h"
+#include "TBClock.h"
+#include "TBEventHistory.h"
+#include "TBLog.h"
+#include "TBStartAllJoynHost.h"
 
 #include <alljoyn/AboutObj.h>
 #include <alljoyn/BusAttachment.h>
 
-#if defined(ENABLE_TBSTARTALLJOYN_LOGGING)
-	#define TBSTARTALLJOYNLOG(...) printf("twobulls::TBStartAllJoyn"); printf(__VA_ARGS__); printf("\n");
-#else
-	#define TBSTARTALLJOYNLOG(...) do {} while(0);
-#endif
+#define TBSTARTALLJOYNLOG(...) TBLOG(TBLOG_LEVEL_TRACE, "twobulls::TBStartAllJoyn", __VA_ARGS__)
 
 namespace twobulls {
 
-TBStartAllJoyn::TBStartAllJoyn(const std::string& aboutXML, const std::string& pathName, const ajn::SessionPort port, const std::vector< EventDescriptor >& events, const std::vector< ActionDescriptor >& actions) :
+TBStartAllJoyn::TBStartAllJoyn(const std::string& aboutXML, const std::string& pathName, const ajn::SessionPort port, const std::vector< EventDescriptor >& events, const std::vector< ActionDescriptor >& actions, const std::vector< PropertyDescriptor >& properties) :
 	ajn::BusObject(pathName.c_str())
-	,mAboutXML(aboutXML)
+	,mAboutDescription()
 	,mBusAttachment(NULL)
 	,mAboutData(NULL)
 	,mAboutObject(NULL)
@@ -48,16 +46,60 @@ TBStartAllJoyn::TBStartAllJoyn(const std::string& aboutXML, const std::string& p
 	,mInterface(NULL)
 	,mApplicationName()
 	,mInterfaceName()
+	,mInterfaceOptions()
+	,mIntrospectionXml()
+	,mInterfaceParts()
 	,mLanguage()
 	,mSessionPort(port)
+	,mEventQueueOptions(0)
+	,mEventQueue(NULL)
+	,mEventStates(new EventState[events.size()])
+	,mActionStates(new ActionState[actions.size()])
+	,mActionPoolOptions(0)
+	,mActionPool(NULL)
+	,mEventHistoryOptions(0)
+	,mEventHistory(NULL)
+	,mEventDelivery(EVENT_DELIVERY_SESSIONLESS)
+	,mEventSession(0)
+	,mProperties(properties)
+	,mPropertyIndex()
+	,mPropertyStates(new PropertyState[properties.size()])
+	,mPropertiesChanged(false)
+	,mPropertyFlushForced(false)
+	,mPropertyFlushIntervalMs(100)
+	,mLastPropertyFlush(0)
+	,mHost(NULL)
+	,mRuntimeAcquired(false)
+	,mSuspended(false)
+	,mBackend(NULL)
+	,mBackendConnected(false)
+	,mBusSignals(events.size(), INVALID_BUS_SIGNAL)
+	,mActionNames()
+	,mMetrics()
+	,mInstruments(mMetrics)
+	,mMetricsProperty(false)
 {
 	TBSTARTALLJOYNLOG("::TBStartAllJoyn -> ");
 
+	for(size_t index = 0; index < mEvents.size(); ++index) {
+		if(mEvents[index].mPolicy.mMode == EmissionPolicy::EMIT_TRAILING) {
+			mTrailingEvents.push_back(index);
+		}
+
+		if(mEvents[index].mArgCount > 0) {
+			mEventStates[index].mArgs = new ajn::MsgArg[mEvents[index].mArgCount];
+		}
+	}
+
+	for(size_t index = 0; index < mProperties.size(); ++index) {
+		mPropertyIndex[mProperties[index].mName] = index;
+	}
+
 	bool result = DigestPathName(pathName);
 	TBSTARTALLJOYNLOG("::TBStartAllJoyn -- DigestPathName <- %d", result);
 
 	if(result) {
-		result = DigestAboutXML();
+		result = DigestAboutXML(aboutXML);
 		TBSTARTALLJOYNLOG("::TBStartAllJoyn -- DigestAboutXML <- %d", result);
 	}
 
@@ -69,55 +111,277 @@ TBStartAllJoyn::~TBStartAllJoyn() {
 
 	Stop();
 
+	if(mEventQueue != NULL) {
+		delete mEventQueue;
+		mEventQueue = NULL;
+	}
+
+	delete[] mEventStates;
+	mEventStates = NULL;
+
+	delete[] mActionStates;
+	mActionStates = NULL;
+
+	delete[] mPropertyStates;
+	mPropertyStates = NULL;
+
+	delete mEventHistory;
+	mEventHistory = NULL;
+
 	TBSTARTALLJOYNLOG("::~TBStartAllJoyn <-");
 }
 
 bool TBStartAllJoyn::Start() {
 	TBSTARTALLJOYNLOG("::Start -> ");
 
-	bool result = true; 
+	const uint64_t startedAt = MonotonicNanoseconds();
+	ClearLifecycleSteps();
 
-#if defined(ALLJOYN_VERSION) && ALLJOYN_VERSION >= 1504
-	result = AllJoynInit() == ER_OK;
-	TBSTARTALLJOYNLOG("::Start -- AllJoynInit <- %d", result);
-	
-#if defined(ALLJOYN_BUNDLED_ROUTER)
-	// An instance of AllJoyn Router (aka Daemon) needs to be running on a typical peer. This can
-	// be omitted if another process is responsible for running the Router. It can also be
-	// omitted if the peer is running as a Thin Client.
-	if(result) {
-		if(AllJoynRouterInit() != ER_OK) {
-			AllJoynShutdown();
-			result = false;
-		}
-		TBSTARTALLJOYNLOG("::Start -- AllJoynRouterInit <- %d", result);	
+	// An object on a TBBusBackend leaves the bus to the backend
+	if(mBackend != NULL) {
+		const bool backendResult = StartOnBackend();
+		RecordLifecycleStep(LIFECYCLE_START, startedAt, backendResult);
+		TBSTARTALLJOYNLOG("::Start <- StartOnBackend %d", backendResult);
+		return backendResult;
 	}
-#endif
 
-#endif
+	// The runtime is shared with any other objects in the process, and is only initialized by the first of them
+	if(!mRuntimeAcquired) {
+		const uint64_t stepStart = MonotonicNanoseconds();
+		mRuntimeAcquired = TBAllJoynRuntime::Acquire();
+		RecordLifecycleStep(LIFECYCLE_RUNTIME_ACQUIRE, stepStart, mRuntimeAcquired);
+		TBSTARTALLJOYNLOG("::Start -- TBAllJoynRuntime::Acquire <- %d", mRuntimeAcquired);
+	}
+
+	bool result = mRuntimeAcquired;
+
+	// The pool is ready before the BusAttachment is, as calls can come in as soon as it connects
+	if(result) {
+		const uint64_t stepStart = MonotonicNanoseconds();
+		result = StartActionPool();
+		RecordLifecycleStep(LIFECYCLE_ACTION_POOL_START, stepStart, result);
+		TBSTARTALLJOYNLOG("::Start -- StartActionPool <- %d", result);
+	}
 
 	if(result) {
+		const uint64_t stepStart = MonotonicNanoseconds();
 		result = SetupBusAttachment();
+		RecordLifecycleStep(LIFECYCLE_SETUP_BUS_ATTACHMENT, stepStart, result);
 		TBSTARTALLJOYNLOG("::Start -- SetupBusAttachment <- %d", result);
 	}
 
 	if(result) {
+		const uint64_t stepStart = MonotonicNanoseconds();
 		result = SetupAboutObject();
+		RecordLifecycleStep(LIFECYCLE_SETUP_ABOUT_OBJECT, stepStart, result);
 		TBSTARTALLJOYNLOG("::Start -- SetupAboutObject <- %d", result);
 	}
 
+	if(result) {
+		const uint64_t stepStart = MonotonicNanoseconds();
+		result = StartEmitter();
+		RecordLifecycleStep(LIFECYCLE_EMITTER_START, stepStart, result);
+		TBSTARTALLJOYNLOG("::Start -- StartEmitter <- %d", result);
+	}
+
+	RecordLifecycleStep(LIFECYCLE_START, startedAt, result);
+
 	TBSTARTALLJOYNLOG("::Start <- %d", result);
 
 	return result;
 }
 
+std::future< bool > TBStartAllJoyn::StartAsync(const StartCallback& callback) {
+	TBSTARTALLJOYNLOG("::StartAsync -> ");
+
+	std::future< bool > result = std::async(std::launch::async, &TBStartAllJoyn::RunStartAsync, this, callback);
+
+	TBSTARTALLJOYNLOG("::StartAsync <-");
+
+	return result;
+}
+
+// The same steps as Start, but the ones that don't need the router connection are done while Connect is in flight.
+bool TBStartAllJoyn::RunStartAsync(StartCallback callback) {
+	TBSTARTALLJOYNLOG("::RunStartAsync -> ");
+
+	const uint64_t startedAt = MonotonicNanoseconds();
+	ClearLifecycleSteps();
+
+	if(mBackend != NULL) {
+		const bool backendResult = StartOnBackend();
+		ReportStartPhase(callback, START_PHASE_COMPLETE, backendResult);
+		RecordLifecycleStep(LIFECYCLE_START, startedAt, backendResult);
+		TBSTARTALLJOYNLOG("::RunStartAsync <- StartOnBackend %d", backendResult);
+		return backendResult;
+	}
+
+	if(!mRuntimeAcquired) {
+		const uint64_t stepStart = MonotonicNanoseconds();
+		mRuntimeAcquired = TBAllJoynRuntime::Acquire();
+		RecordLifecycleStep(LIFECYCLE_RUNTIME_ACQUIRE, stepStart, mRuntimeAcquired);
+		TBSTARTALLJOYNLOG("::RunStartAsync -- TBAllJoynRuntime::Acquire <- %d", mRuntimeAcquired);
+	}
+
+	bool result = mRuntimeAcquired;
+	ReportStartPhase(callback, START_PHASE_RUNTIME, result);
+
+	if(result) {
+		const uint64_t stepStart = MonotonicNanoseconds();
+		result = StartActionPool();
+		RecordLifecycleStep(LIFECYCLE_ACTION_POOL_START, stepStart, result);
+		TBSTARTALLJOYNLOG("::RunStartAsync -- StartActionPool <- %d", result);
+	}
+
+	if(result) {
+		result = CreateBusAttachment();
+		TBSTARTALLJOYNLOG("::RunStartAsync -- CreateBusAttachment <- %d", result);
+		ReportStartPhase(callback, START_PHASE_BUS, result);
+	}
+
+	std::future< bool > connected;
+
+	if(result) {
+		connected = std::async(std::launch::async, [this]() {
+			const uint64_t stepStart = MonotonicNanoseconds();
+			const bool connectResult = mBusAttachment->Connect() == ER_OK;
+			RecordLifecycleStep(LIFECYCLE_CONNECT, stepStart, connectResult);
+			return connectResult;
+		});
+		TBSTARTALLJOYNLOG("::RunStartAsync -- mBusAttachment->Connect ->");
+	}
+
+	if(result) {
+		const uint64_t stepStart = MonotonicNanoseconds();
+		result = DefineInterface();
+		RecordLifecycleStep(LIFECYCLE_DEFINE_INTERFACE, stepStart, result);
+		TBSTARTALLJOYNLOG("::RunStartAsync -- DefineInterface <- %d", result);
+		ReportStartPhase(callback, START_PHASE_INTERFACE, result);
+	}
+
+	if(result) {
+		result = PrepareAboutData();
+		TBSTARTALLJOYNLOG("::RunStartAsync -- PrepareAboutData <- %d", result);
+		ReportStartPhase(callback, START_PHASE_ABOUT_DATA, result);
+	}
+
+	// Connect is waited on whatever happened above, so that it isn't left running against a BusAttachment being torn down
+	if(connected.valid()) {
+		const bool connectResult = connected.get();
+		TBSTARTALLJOYNLOG("::RunStartAsync -- mBusAttachment->Connect <- %d", connectResult);
+
+		if(result) {
+			result = connectResult;
+			ReportStartPhase(callback, START_PHASE_CONNECT, result);
+		}
+	}
+
+	if(result) {
+		const uint64_t stepStart = MonotonicNanoseconds();
+		result = AttachInterface();
+		RecordLifecycleStep(LIFECYCLE_ATTACH_INTERFACE, stepStart, result);
+		TBSTARTALLJOYNLOG("::RunStartAsync -- AttachInterface <- %d", result);
+		ReportStartPhase(callback, START_PHASE_OBJECT, result);
+	}
+
+	if(result) {
+		const uint64_t stepStart = MonotonicNanoseconds();
+		result = BindSessionPort();
+		RecordLifecycleStep(LIFECYCLE_BIND_SESSION_PORT, stepStart, result);
+		TBSTARTALLJOYNLOG("::RunStartAsync -- BindSessionPort <- %d", result);
+		ReportStartPhase(callback, START_PHASE_SESSION_PORT, result);
+	}
+
+	if(result) {
+		result = AnnounceAboutObject();
+		TBSTARTALLJOYNLOG("::RunStartAsync -- AnnounceAboutObject <- %d", result);
+		ReportStartPhase(callback, START_PHASE_ANNOUNCE, result);
+	}
+
+	if(result) {
+		const uint64_t stepStart = MonotonicNanoseconds();
+		result = StartEmitter();
+		RecordLifecycleStep(LIFECYCLE_EMITTER_START, stepStart, result);
+		TBSTARTALLJOYNLOG("::RunStartAsync -- StartEmitter <- %d", result);
+	}
+
+	ReportStartPhase(callback, START_PHASE_COMPLETE, result);
+
+	RecordLifecycleStep(LIFECYCLE_START, startedAt, result);
+
+	TBSTARTALLJOYNLOG("::RunStartAsync <- %d", result);
+
+	return result;
+}
+
+void TBStartAllJoyn::ReportStartPhase(const StartCallback& callback, StartPhase phase, bool result) {
+	if(callback) {
+		callback(phase, result);
+	}
+}
+
 void TBStartAllJoyn::Stop() {
 	TBSTARTALLJOYNLOG("::Stop -> ");
 
+	// A hosted object only leaves its host, the shared BusAttachment carries on
+	if(mHost != NULL) {
+		mHost->Unregister(*this);
+		TBSTARTALLJOYNLOG("::Stop <- mHost->Unregister");
+		return;
+	}
+
+	if(mBackendConnected) {
+		const uint64_t backendStoppedAt = MonotonicNanoseconds();
+		StopOnBackend();
+		RecordLifecycleStep(LIFECYCLE_STOP, backendStoppedAt, true);
+		TBSTARTALLJOYNLOG("::Stop <- StopOnBackend");
+		return;
+	}
+
+	const uint64_t stoppedAt = MonotonicNanoseconds();
+	uint64_t stepStart = stoppedAt;
+
+	// Only the steps that had something to stop are timed, so that a Stop of an object that never started, such as the
+	//	one in the destructor, doesn't water down the statistics
+	const bool emitterRunning = mEmitterThread.joinable();
+	const bool actionPoolRunning = mActionPool != NULL;
+	const bool running = mBusAttachment != NULL || mRuntimeAcquired || emitterRunning || actionPoolRunning;
+
+	// Queued Events are flushed while the BusAttachment is still around to Signal them
+	StopEmitter();
+	if(emitterRunning) {
+		RecordLifecycleStep(LIFECYCLE_EMITTER_STOP, stepStart, true);
+	}
+
 	if(mBusAttachment != NULL) {
+		stepStart = MonotonicNanoseconds();
 		mBusAttachment->Stop();
 		mBusAttachment->Join();	
+		RecordLifecycleStep(LIFECYCLE_BUS_STOP, stepStart, true);
+	}
+
+	// Handlers still running or queued may use the BusAttachment, so they are done with before it goes
+	stepStart = MonotonicNanoseconds();
+	StopActionPool();
+	if(actionPoolRunning) {
+		RecordLifecycleStep(LIFECYCLE_ACTION_POOL_STOP, stepStart, true);
+	}
+
+	if(mBusAttachment != NULL) {
+		stepStart = MonotonicNanoseconds();
 		mBusAttachment->UnregisterBusObject(*this);
+		RecordLifecycleStep(LIFECYCLE_UNREGISTER_OBJECT, stepStart, true);
+	}
+
+	mSessions.Clear();
+	mEventSession.store(0);
+	mSuspended.store(false);
+
+	// The resolved Event members belong to the BusAttachment's interface, so they go with it, as do the serials of the
+	//	Signals sent through it
+	mEventMembers.assign(mEventMembers.size(), NULL);
+	for(size_t index = 0; index < mEvents.size(); ++index) {
+		mEventStates[index].mLastSerial.store(0);
 	}
 
 	if(mAboutObject != NULL) {
@@ -126,268 +390,1596 @@ void TBStartAllJoyn::Stop() {
 	}
 
 	if(mBusAttachment != NULL) {
+		stepStart = MonotonicNanoseconds();
 		delete mBusAttachment;
 		mBusAttachment = NULL;
+		RecordLifecycleStep(LIFECYCLE_DELETE_BUS, stepStart, true);
 	}
 
-#if defined(ALLJOYN_VERSION) && ALLJOYN_VERSION >= 1504
+	if(mAboutData != NULL) {
+		delete mAboutData;
+		mAboutData = NULL;
+	}
 
-#if defined(ALLJOYN_BUNDLED_ROUTER)
-	AllJoynRouterShutdown();
-#endif
+	if(mRuntimeAcquired) {
+		stepStart = MonotonicNanoseconds();
+		TBAllJoynRuntime::Release();
+		mRuntimeAcquired = false;
+		RecordLifecycleStep(LIFECYCLE_RUNTIME_RELEASE, stepStart, true);
+	}
 
-	AllJoynShutdown();
-#endif
+	if(running) {
+		RecordLifecycleStep(LIFECYCLE_STOP, stoppedAt, true);
+	}
 
 	TBSTARTALLJOYNLOG("::Stop <-");
 }
 
-bool TBStartAllJoyn::TriggerEvent(const std::string& eventName) {
-	TBSTARTALLJOYNLOG("::TriggerEvent -> eventName = %s", eventName.c_str());
+bool TBStartAllJoyn::Suspend() {
+	TBSTARTALLJOYNLOG("::Suspend -> ");
 
-	bool result = true;
-	const ajn::InterfaceDescription::Member *eventSignal = mInterface->GetSignal(eventName.c_str());
-	result = eventSignal != NULL;
-	TBSTARTALLJOYNLOG("::TriggerEvent -- mInterface->GetSignal <- %d", result);
+	const uint64_t suspendedAt = MonotonicNanoseconds();
 
-	if(result) {
-		result = Signal(NULL, 0, *eventSignal, NULL, 0, 0, ajn::ALLJOYN_FLAG_SESSIONLESS) == ER_OK;
-		TBSTARTALLJOYNLOG("::TriggerEvent -- Signal <- %d", result);
+	bool result = mHost == NULL && mBusAttachment != NULL && mAboutObject != NULL && !mSuspended.load();
+	TBSTARTALLJOYNLOG("::Suspend -- !mHost && mBusAttachment && mAboutObject && !mSuspended <- %d", result);
+
+	// Events stop being sent from here on, rather than failing against the router one by one
+	const bool suspending = result;
+	if(suspending) {
+		mSuspended.store(true);
 	}
 
-	TBSTARTALLJOYNLOG("::TriggerEvent <- %d", result);
+	bool unannounced = false;
+	bool unbound = false;
 
-	return result;
-}
+	if(result) {
+		const uint64_t stepStart = MonotonicNanoseconds();
+		unannounced = mAboutObject->Unannounce() == ER_OK;
+		RecordLifecycleStep(LIFECYCLE_UNANNOUNCE, stepStart, unannounced);
+		TBSTARTALLJOYNLOG("::Suspend -- mAboutObject->Unannounce <- %d", unannounced);
+	}
 
-bool TBStartAllJoyn::DigestPathName(const std::string& pathName) {
-	TBSTARTALLJOYNLOG("::DigestPathName -> pathName = %s", pathName.c_str());
+	if(result) {
+		result = unbound = mBusAttachment->UnbindSessionPort(mSessionPort) == ER_OK;
+		TBSTARTALLJOYNLOG("::Suspend -- mBusAttachment->UnbindSessionPort <- %d", result);
+	}
 
-	mInterfaceName.clear();
+	if(result) {
+		const uint64_t stepStart = MonotonicNanoseconds();
+		result = mBusAttachment->Disconnect() == ER_OK;
+		RecordLifecycleStep(LIFECYCLE_DISCONNECT, stepStart, result);
+		TBSTARTALLJOYNLOG("::Suspend -- mBusAttachment->Disconnect <- %d", result);
+	}
 
-	bool result = pathName.length() > 0;
-	TBSTARTALLJOYNLOG("::DigestPathName -- pathName.length <- %d", result);
+	// Still connected, so the object carries on as it was, with only the steps that were taken undone
+	if(suspending && !result) {
+		if(unbound) {
+			BindSessionPort();
+		}
+		if(unannounced) {
+			mAboutObject->Announce(mSessionPort, *mAboutData);
+		}
+		mSuspended.store(false);
+	}
 
+	// The sessions, and the sessionless Signals held by the router, don't survive the disconnect
 	if(result) {
-		mInterfaceName = pathName.substr(1);
-		std::replace(mInterfaceName.begin(), mInterfaceName.end(), '/', '.');
-		result = mInterfaceName.length() > 0;
-		TBSTARTALLJOYNLOG("::DigestPathName -- std::replace %d", result);
+		mSessions.Clear();
+		mEventSession.store(0);
+		for(size_t index = 0; index < mEvents.size(); ++index) {
+			mEventStates[index].mLastSerial.store(0);
+		}
 	}
 
-	TBSTARTALLJOYNLOG("::DigestPathName <- %d", result);
+	RecordLifecycleStep(LIFECYCLE_SUSPEND, suspendedAt, result);
+
+	TBSTARTALLJOYNLOG("::Suspend <- %d", result);
 
 	return result;
 }
 
-bool TBStartAllJoyn::DigestAboutXML() {
-	TBSTARTALLJOYNLOG("::DigestAboutXML -> ");
+bool TBStartAllJoyn::Resume() {
+	TBSTARTALLJOYNLOG("::Resume -> ");
 
-	tinyxml2::XMLDocument xmlDoc;
+	const uint64_t resumedAt = MonotonicNanoseconds();
 
-	mApplicationName.clear();
-	mLanguage.clear();
+	bool result = mBusAttachment != NULL && mAboutObject != NULL && mAboutData != NULL && mSuspended.load();
+	TBSTARTALLJOYNLOG("::Resume -- mBusAttachment && mAboutObject && mAboutData && mSuspended <- %d", result);
 
-	bool result = xmlDoc.Parse(mAboutXML.c_str()) == tinyxml2::XML_SUCCESS;
-	TBSTARTALLJOYNLOG("::DigestAboutXML -- xmlDoc.Parse <- %d", result);
+	bool connected = false;
+	bool bound = false;
 
 	if(result) {
-		const tinyxml2::XMLElement* root = xmlDoc.RootElement();
-		result = root != NULL;
-		TBSTARTALLJOYNLOG("::DigestAboutXML -- xmlDoc.RootElement <- %d", result);
+		const uint64_t stepStart = MonotonicNanoseconds();
+		result = connected = mBusAttachment->Connect() == ER_OK;
+		RecordLifecycleStep(LIFECYCLE_CONNECT, stepStart, result);
+		TBSTARTALLJOYNLOG("::Resume -- mBusAttachment->Connect <- %d", result);
+	}
 
-		if(result) {
-			result = std::string(root->Name()) == "About";
-			TBSTARTALLJOYNLOG("::DigestAboutXML -- root->Name == 'About' <- %d", result);
-		}
+	if(result) {
+		const uint64_t stepStart = MonotonicNanoseconds();
+		result = bound = BindSessionPort();
+		RecordLifecycleStep(LIFECYCLE_BIND_SESSION_PORT, stepStart, result);
+		TBSTARTALLJOYNLOG("::Resume -- BindSessionPort <- %d", result);
+	}
 
-		if(result) {
-			for(const tinyxml2::XMLElement* child = root->FirstChildElement(); child != NULL; child = child->NextSiblingElement()) {
-				const std::string childName(child->Name());
-				if(childName == "AppName") {
-					mApplicationName = child->GetText();
-				} else if(childName == "DefaultLanguage") {
-					mLanguage = child->GetText();
-				}
-			}
-			result = mApplicationName.length() > 0 && mLanguage.length() > 0;
-			TBSTARTALLJOYNLOG("::DigestAboutXML -- mApplicationName.length && mLanguage.length <- %d", result);
+	if(result) {
+		const uint64_t stepStart = MonotonicNanoseconds();
+		result = mAboutObject->Announce(mSessionPort, *mAboutData) == ER_OK;
+		RecordLifecycleStep(LIFECYCLE_ANNOUNCE, stepStart, result);
+		TBSTARTALLJOYNLOG("::Resume -- mAboutObject->Announce <- %d", result);
+	}
+
+	// The Property changes held back while suspended go out straight away
+	if(result) {
+		mSuspended.store(false);
+		if(mEventQueue != NULL) {
+			mPropertyFlushForced.store(true);
+			mEventQueue->Wake();
+		}
+	} else {
+		// Back to where Suspend left it, so that Resume can be tried again
+		if(bound) {
+			mBusAttachment->UnbindSessionPort(mSessionPort);
+		}
+		if(connected) {
+			mBusAttachment->Disconnect();
 		}
 	}
-	
-	TBSTARTALLJOYNLOG("::DigestAboutXML <- %d", result);
+
+	RecordLifecycleStep(LIFECYCLE_RESUME, resumedAt, result);
+
+	TBSTARTALLJOYNLOG("::Resume <- %d", result);
 
 	return result;
 }
 
-bool TBStartAllJoyn::SetupBusAttachment() {
-	TBSTARTALLJOYNLOG("::SetupBusAttachment -> ");
+bool TBStartAllJoyn::IsSuspended() const {
+	return mSuspended.load();
+}
 
-	bool result = mApplicationName.length() > 0 && mBusAttachment == NULL;
-	TBSTARTALLJOYNLOG("::SetupBusAttachment -- mApplicationName.length && mBusAttachment <- %d", result);
+LifecycleStats TBStartAllJoyn::GetLifecycleStats() const {
+	std::lock_guard< std::mutex > lock(mLifecycleMutex);
+	return mLifecycleStats;
+}
+
+// The Connect of StartAsync is timed on a thread of its own, hence the lock.
+void TBStartAllJoyn::RecordLifecycleStep(LifecycleStep step, uint64_t startNs, bool result) {
+	if(mInstruments.mLifecycleLatency[step] != NULL) {
+		mInstruments.mLifecycleLatency[step]->Record(MonotonicNanoseconds() - startNs);
+	}
+
+	std::lock_guard< std::mutex > lock(mLifecycleMutex);
+	mLifecycleStats.Record(step, startNs, result);
+}
+
+void TBStartAllJoyn::ClearLifecycleSteps() {
+	std::lock_guard< std::mutex > lock(mLifecycleMutex);
+	mLifecycleStats.Clear();
+}
+
+bool TBStartAllJoyn::StartHosted(TBStartAllJoynHost& host) {
+	TBSTARTALLJOYNLOG("::StartHosted -> ");
+
+	bool result = mHost == NULL && mBusAttachment == NULL && mBackend == NULL && mApplicationName.length() > 0;
+	TBSTARTALLJOYNLOG("::StartHosted -- mHost && mBusAttachment && mBackend && mApplicationName.length <- %d", result);
 
 	if(result) {
-		result = (mBusAttachment = new ajn::BusAttachment(mApplicationName.c_str(), true)) != NULL;
-		TBSTARTALLJOYNLOG("::SetupBusAttachment -- new ajn::BusAttachment <- %d", result);
+		mHost = &host;
+		result = (mBusAttachment = host.GetBusAttachment()) != NULL;
+		TBSTARTALLJOYNLOG("::StartHosted -- host.GetBusAttachment <- %d", result);
 	}
 
 	if(result) {
-		result = mBusAttachment->Start() == ER_OK;
-		TBSTARTALLJOYNLOG("::SetupBusAttachment -- mBusAttachment->Start <- %d", result);
+		result = StartActionPool();
+		TBSTARTALLJOYNLOG("::StartHosted -- StartActionPool <- %d", result);
 	}
 
 	if(result) {
 		result = DefineInterface();
-		TBSTARTALLJOYNLOG("::SetupBusAttachment -- DefineInterface <- %d", result);
+		TBSTARTALLJOYNLOG("::StartHosted -- DefineInterface <- %d", result);
 	}
 
 	if(result) {
 		result = AttachInterface();
-		TBSTARTALLJOYNLOG("::SetupBusAttachment -- AttachInterface <- %d", result);
+		TBSTARTALLJOYNLOG("::StartHosted -- AttachInterface <- %d", result);
 	}
 
-	if(result) {
-		result = mBusAttachment->Connect() == ER_OK;
-		TBSTARTALLJOYNLOG("::SetupBusAttachment -- mBusAttachment->Connect <- %d", result);
+	// Consumers can reach the object through the host's session port, so only a different port is bound
+	if(result && mSessionPort != host.GetSessionPort()) {
+		ajn::SessionOpts opts(ajn::SessionOpts::TRAFFIC_MESSAGES, false, ajn::SessionOpts::PROXIMITY_ANY, ajn::TRANSPORT_ANY);
+
+		result = mBusAttachment->BindSessionPort(mSessionPort, opts, *this) == ER_OK;
+		TBSTARTALLJOYNLOG("::StartHosted -- mBusAttachment->BindSessionPort <- %d", result);
 	}
 
 	if(result) {
-		ajn::SessionOpts opts(ajn::SessionOpts::TRAFFIC_MESSAGES, false, ajn::SessionOpts::PROXIMITY_ANY, ajn::TRANSPORT_ANY);
+		result = StartEmitter();
+		TBSTARTALLJOYNLOG("::StartHosted -- StartEmitter <- %d", result);
+	}
 
-		result = mBusAttachment->BindSessionPort(mSessionPort, opts, *this) == ER_OK;
-		TBSTARTALLJOYNLOG("::SetupBusAttachment -- mBusAttachment->BindSessionPort <- %d", result);
+	if(!result && mHost != NULL) {
+		StopHosted();
 	}
 
-	TBSTARTALLJOYNLOG("::SetupBusAttachment <- %d", result);
+	TBSTARTALLJOYNLOG("::StartHosted <- %d", result);
 
 	return result;
 }
 
-bool TBStartAllJoyn::DefineInterface() {
-	TBSTARTALLJOYNLOG("::DefineInterface -> ");
-
-	bool result = mInterfaceName.length() > 0
-		&& mLanguage.length() > 0
-		&& mApplicationName.length() > 0;
-	TBSTARTALLJOYNLOG("::DefineInterface -- mInterfaceName.length && mLanguage.length && mApplicationName.length <- %d", result);
-
-	ajn::InterfaceDescription *interfaceDefinition = NULL;
-
-	if(result) {
-		result = mBusAttachment->CreateInterface(mInterfaceName.c_str(), interfaceDefinition) == ER_OK && interfaceDefinition != NULL;
-		TBSTARTALLJOYNLOG("::DefineInterface -- mBusAttachment->CreateInterface && interfaceDefinition <- %d", result);
-	}
+void TBStartAllJoyn::StopHosted() {
+	TBSTARTALLJOYNLOG("::StopHosted -> ");
 
-	if(result) {
-		interfaceDefinition->SetDescriptionLanguage(mLanguage.c_str());
-		TBSTARTALLJOYNLOG("::DefineInterface -- interfaceDefinition->SetDescriptionLanguage <-");
+	StopEmitter();
 
-		interfaceDefinition->SetDescription(mApplicationName.c_str());
-		TBSTARTALLJOYNLOG("::DefineInterface -- interfaceDefinition->SetDescription <-");
-	}
+	if(mBusAttachment != NULL) {
+		mBusAttachment->UnregisterBusObject(*this);
 
-	for(std::vector< EventDescriptor >::iterator event = mEvents.begin(); result && event != mEvents.end(); ++event) {
-		if(result) {
-			result = interfaceDefinition->AddSignal(event->mName.c_str(), "", "") == ER_OK;
-			TBSTARTALLJOYNLOG("::DefineInterface -- interfaceDefinition->AddSignal <- %d", result);
-		}
-		
-		if(result) {
-			result = interfaceDefinition->SetMemberDescription(event->mName.c_str(), event->mDescription.c_str(), true) == ER_OK;
-			TBSTARTALLJOYNLOG("::DefineInterface -- interfaceDefinition->SetMemberDescription <- %d", result);
+		if(mSessionPort != mHost->GetSessionPort()) {
+			mBusAttachment->UnbindSessionPort(mSessionPort);
 		}
 	}
 
-	for(std::vector< ActionDescriptor >::iterator action = mActions.begin(); result && action != mActions.end(); ++action) {
-		if(result) {
-			result = interfaceDefinition->AddMethod(action->mName.c_str(), "", "", "", ajn::MEMBER_ANNOTATE_NO_REPLY) == ER_OK;
-			TBSTARTALLJOYNLOG("::DefineInterface -- interfaceDefinition->AddMethod <- %d", result);
-		}
-
-		if(result) {
-			result = interfaceDefinition->SetMemberDescription(action->mName.c_str(), action->mDescription.c_str()) == ER_OK;
-			TBSTARTALLJOYNLOG("::DefineInterface -- interfaceDefinition->SetMemberDescription <- %d", result);
-		}
-	}
+	StopActionPool();
 
-	if(result) {
-		interfaceDefinition->Activate();
-		TBSTARTALLJOYNLOG("::DefineInterface -- interfaceDefinition->Activate <-");
+	// The interface stays defined on the shared BusAttachment, but this object no longer has a say in it
+	mEventMembers.assign(mEventMembers.size(), NULL);
+	for(size_t index = 0; index < mEvents.size(); ++index) {
+		mEventStates[index].mLastSerial.store(0);
 	}
+	mSessions.Clear();
+	mBusAttachment = NULL;
+	mHost = NULL;
 
-	TBSTARTALLJOYNLOG("::DefineInterface <- %d", result);
+	TBSTARTALLJOYNLOG("::StopHosted <-");
+}
 
-	return result;
+bool TBStartAllJoyn::IsStarted() const {
+	return mBusAttachment != NULL || mBackendConnected;
 }
 
-bool TBStartAllJoyn::AttachInterface() {
-	TBSTARTALLJOYNLOG("::AttachInterface -> ");
+bool TBStartAllJoyn::StartOnBackend() {
+	TBSTARTALLJOYNLOG("::StartOnBackend -> ");
 
-	bool result = mBusAttachment != NULL
-		&& mInterfaceName.length() > 0
-		&& (mInterface = mBusAttachment->GetInterface(mInterfaceName.c_str())) != NULL;
-	TBSTARTALLJOYNLOG("::AttachInterface -- mBusAttachment && mInterfaceName.length && mBusAttachment->GetInterface <- %d", result);
+	bool result = !mBackendConnected && mApplicationName.length() > 0;
+	TBSTARTALLJOYNLOG("::StartOnBackend -- !mBackendConnected && mApplicationName.length <- %d", result);
 
+	// As in Start, the pool is ready before calls can come in
 	if(result) {
-		result = AddInterface(*mInterface, ajn::BusObject::UNANNOUNCED) == ER_OK;
-		TBSTARTALLJOYNLOG("::AttachInterface -- AddInterface <- %d", result);
+		result = StartActionPool();
+		TBSTARTALLJOYNLOG("::StartOnBackend -- StartActionPool <- %d", result);
 	}
 
-	const ajn::InterfaceDescription::Member* method = NULL;
-	for(std::vector< ActionDescriptor >::iterator action = mActions.begin(); result && action != mActions.end(); ++action) {
-		if(result) {
-			result = (method = mInterface->GetMethod(action->mName.c_str())) != NULL;
-			TBSTARTALLJOYNLOG("::AttachInterface -- mInterface->GetMethod <- %d", result);
-		}
-
-		if(result) {
-			result = AddMethodHandler(method, action->mHandler) == ER_OK;
-			TBSTARTALLJOYNLOG("::AttachInterface -- AddMethodHandler <- %d", result);
-		}
+	if(result) {
+		result = mBackendConnected = mBackend->Connect(mApplicationName);
+		TBSTARTALLJOYNLOG("::StartOnBackend -- mBackend->Connect <- %d", result);
 	}
 
 	if(result) {
-		result = mBusAttachment->RegisterBusObject(*this, false) == ER_OK;
-		TBSTARTALLJOYNLOG("::AttachInterface -- mBusAttachment->RegisterBusObject <- %d", result);
+		result = mBackend->DefineInterface(DescribeInterface());
+		TBSTARTALLJOYNLOG("::StartOnBackend -- mBackend->DefineInterface <- %d", result);
 	}
 
-	TBSTARTALLJOYNLOG("::AttachInterface <- %d", result);
-
-	return result;
-}
+	if(result) {
+		result = mBackend->RegisterObject(GetPath(), mInterfaceName, *this);
+		TBSTARTALLJOYNLOG("::StartOnBackend -- mBackend->RegisterObject <- %d", result);
+	}
 
-bool TBStartAllJoyn::SetupAboutObject() {
-	TBSTARTALLJOYNLOG("::SetupAboutObject -> ");
+	// As with DefineInterface, each Event is resolved once so that TriggerEvent doesn't need to look it up by name
+	for(size_t index = 0; result && index < mEvents.size(); ++index) {
+		result = (mBusSignals[index] = mBackend->ResolveSignal(GetPath(), mEvents[index].mName)) != INVALID_BUS_SIGNAL;
+		TBSTARTALLJOYNLOG("::StartOnBackend -- mBackend->ResolveSignal <- %d", result);
+	}
 
-	bool result = mAboutObject == NULL;
-	TBSTARTALLJOYNLOG("::SetupAboutObject -- mAboutObject <- %d", result);
+	mActionNames.clear();
+	for(size_t index = 0; result && index < mActions.size(); ++index) {
+		mActionNames[mActions[index].mName] = index;
+	}
 
 	if(result) {
-		result = (mAboutData = new ajn::AboutData(mLanguage.c_str())) != NULL;
-		TBSTARTALLJOYNLOG("::SetupAboutObject -- new ajn::AboutData <- %d", result);
+		result = mBackend->BindSessionPort(mSessionPort, mEventDelivery != EVENT_DELIVERY_SESSIONLESS, *this, *this);
+		TBSTARTALLJOYNLOG("::StartOnBackend -- mBackend->BindSessionPort <- %d", result);
 	}
 
 	if(result) {
-		result = mAboutData->CreateFromXml(mAboutXML.c_str()) == ER_OK;
-		TBSTARTALLJOYNLOG("::SetupAboutObject -- mAboutData->CreateFromXml <- %d", result);
+		result = mBackend->Announce(mSessionPort, mAboutDescription);
+		TBSTARTALLJOYNLOG("::StartOnBackend -- mBackend->Announce <- %d", result);
 	}
 
 	if(result) {
-		result = mAboutData->IsValid(mLanguage.c_str()) == QCC_TRUE;
-		TBSTARTALLJOYNLOG("::SetupAboutObject -- mAboutData->IsValid <- %d", result);
+		result = StartEmitter();
+		TBSTARTALLJOYNLOG("::StartOnBackend -- StartEmitter <- %d", result);
 	}
 
-	if(result) {
-		result = (mAboutObject = new ajn::AboutObj(*mBusAttachment)) != NULL;
-		TBSTARTALLJOYNLOG("::SetupAboutObject -- new ajn::AboutObj <- %d", result);
+	if(!result && mBackendConnected) {
+		StopOnBackend();
+	} else if(!result) {
+		StopActionPool();
 	}
 
-	if(result) {
+	TBSTARTALLJOYNLOG("::StartOnBackend <- %d", result);
+
+	return result;
+}
+
+void TBStartAllJoyn::StopOnBackend() {
+	TBSTARTALLJOYNLOG("::StopOnBackend -> ");
+
+	StopEmitter();
+
+	mBackend->UnbindSessionPort(mSessionPort);
+
+	// Pooled handlers reply through the object registered with the backend, so they are done with before it goes
+	StopActionPool();
+	mBackend->UnregisterObject(GetPath());
+
+	mSessions.Clear();
+	mEventSession.store(0);
+
+	mBusSignals.assign(mEvents.size(), INVALID_BUS_SIGNAL);
+	for(size_t index = 0; index < mEvents.size(); ++index) {
+		mEventStates[index].mLastSerial.store(0);
+	}
+
+	mBackend->Disconnect();
+	mBackendConnected = false;
+
+	TBSTARTALLJOYNLOG("::StopOnBackend <-");
+}
+
+// The same interface as DefineInterface builds on a BusAttachment, for a TBBusBackend to define.
+BusInterface TBStartAllJoyn::DescribeInterface() const {
+	BusInterface definition(mInterfaceName, mApplicationName, mLanguage);
+
+	for(std::vector< EventDescriptor >::const_iterator event = mEvents.begin(); event != mEvents.end(); ++event) {
+		definition.mMembers.push_back(BusMember(BUS_MEMBER_SIGNAL, event->mName, event->mDescription, event->mSignature, std::string(), event->mArgNames));
+	}
+
+	for(std::vector< ActionDescriptor >::const_iterator action = mActions.begin(); action != mActions.end(); ++action) {
+		definition.mMembers.push_back(BusMember(BUS_MEMBER_METHOD, action->mName, action->mDescription, action->mInputSignature, action->mOutputSignature, action->mArgNames, action->mAnnotation));
+	}
+
+	for(std::vector< PropertyDescriptor >::const_iterator property = mProperties.begin(); property != mProperties.end(); ++property) {
+		definition.mMembers.push_back(BusMember(BUS_MEMBER_PROPERTY, property->mName, property->mDescription, property->mSignature, std::string(), std::string(), 0, property->mWritable));
+		definition.mMembers.back().mEmitsChanged = property->mEmitsChanged;
+	}
+
+	return definition;
+}
+
+bool TBStartAllJoyn::TriggerEvent(const std::string& eventName) {
+	TBSTARTALLJOYNLOG("::TriggerEvent -> eventName = %s", eventName.c_str());
+
+	bool result = TriggerEvent(GetEventHandle(eventName));
+
+	TBSTARTALLJOYNLOG("::TriggerEvent <- %d", result);
+
+	return result;
+}
+
+bool TBStartAllJoyn::TriggerEvent(EventHandle event) {
+	TBSTARTALLJOYNLOG("::TriggerEvent -> event = %u", static_cast< unsigned int >(event));
+
+	const uint64_t triggeredAt = MonotonicNanoseconds();
+	bool result = IsEventReady(event) && mEvents[event].mArgCount == 0;
+	TBSTARTALLJOYNLOG("::TriggerEvent -- IsEventReady && !mArgCount <- %d", result);
+
+	if(result && AdmitEvent(event)) {
+		result = EmitEvent(event);
+		TBSTARTALLJOYNLOG("::TriggerEvent -- EmitEvent <- %d", result);
+	}
+
+	CountTrigger(triggeredAt);
+
+	TBSTARTALLJOYNLOG("::TriggerEvent <- %d", result);
+
+	return result;
+}
+
+EventHandle TBStartAllJoyn::GetEventHandle(const std::string& eventName) const {
+	for(size_t index = 0; index < mEvents.size(); ++index) {
+		if(mEvents[index].mName == eventName) {
+			return index;
+		}
+	}
+
+	return INVALID_EVENT_HANDLE;
+}
+
+bool TBStartAllJoyn::TriggerEventAsync(const std::string& eventName) {
+	TBSTARTALLJOYNLOG("::TriggerEventAsync -> eventName = %s", eventName.c_str());
+
+	bool result = TriggerEventAsync(GetEventHandle(eventName));
+
+	TBSTARTALLJOYNLOG("::TriggerEventAsync <- %d", result);
+
+	return result;
+}
+
+bool TBStartAllJoyn::TriggerEventAsync(EventHandle event) {
+	TBSTARTALLJOYNLOG("::TriggerEventAsync -> event = %u", static_cast< unsigned int >(event));
+
+	const uint64_t triggeredAt = MonotonicNanoseconds();
+	bool result = event < mEvents.size() && mEvents[event].mArgCount == 0
+		&& mEventQueueOptions.mCapacity > 0 && mEventQueue != NULL && !mEventQueue->IsClosed();
+	TBSTARTALLJOYNLOG("::TriggerEventAsync -- event && !mArgCount && mEventQueue <- %d", result);
+
+	if(result && AdmitEvent(event)) {
+		result = mEventQueue->Push(event);
+		TBSTARTALLJOYNLOG("::TriggerEventAsync -- mEventQueue->Push <- %d", result);
+	}
+
+	CountTrigger(triggeredAt);
+
+	TBSTARTALLJOYNLOG("::TriggerEventAsync <- %d", result);
+
+	return result;
+}
+
+bool TBStartAllJoyn::SetEventQueueOptions(const EventQueueOptions& options) {
+	TBSTARTALLJOYNLOG("::SetEventQueueOptions -> capacity = %u, overflowPolicy = %d", static_cast< unsigned int >(options.mCapacity), options.mOverflowPolicy);
+
+	bool result = !IsStarted();
+	TBSTARTALLJOYNLOG("::SetEventQueueOptions -- !IsStarted <- %d", result);
+
+	if(result) {
+		delete mEventQueue;
+		mEventQueue = NULL;
+		mEventQueueOptions = options;
+	}
+
+	TBSTARTALLJOYNLOG("::SetEventQueueOptions <- %d", result);
+
+	return result;
+}
+
+EventQueueStats TBStartAllJoyn::GetEventQueueStats() const {
+	return mEventQueue != NULL ? mEventQueue->GetStats() : EventQueueStats();
+}
+
+bool TBStartAllJoyn::SetActionPoolOptions(const ActionPoolOptions& options) {
+	TBSTARTALLJOYNLOG("::SetActionPoolOptions -> threadCount = %u, poolByDefault = %d", static_cast< unsigned int >(options.mThreadCount), options.mPoolByDefault);
+
+	bool result = !IsStarted();
+	TBSTARTALLJOYNLOG("::SetActionPoolOptions -- !IsStarted <- %d", result);
+
+	if(result) {
+		mActionPoolOptions = options;
+	}
+
+	TBSTARTALLJOYNLOG("::SetActionPoolOptions <- %d", result);
+
+	return result;
+}
+
+bool TBStartAllJoyn::SetEventDelivery(EventDelivery delivery) {
+	TBSTARTALLJOYNLOG("::SetEventDelivery -> delivery = %d", delivery);
+
+	bool result = !IsStarted();
+	TBSTARTALLJOYNLOG("::SetEventDelivery -- !IsStarted <- %d", result);
+
+	if(result) {
+		mEventDelivery = delivery;
+	}
+
+	TBSTARTALLJOYNLOG("::SetEventDelivery <- %d", result);
+
+	return result;
+}
+
+bool TBStartAllJoyn::SetInterfaceOptions(const InterfaceOptions& options) {
+	TBSTARTALLJOYNLOG("::SetInterfaceOptions -> fromXml = %d, maxMembersPerInterface = %u", options.mFromXml, static_cast< unsigned int >(options.mMaxMembersPerInterface));
+
+	bool result = !IsStarted();
+	TBSTARTALLJOYNLOG("::SetInterfaceOptions -- !IsStarted <- %d", result);
+
+	if(result) {
+		mInterfaceOptions = options;
+		mIntrospectionXml.clear();
+		mInterfaceParts.clear();
+	}
+
+	TBSTARTALLJOYNLOG("::SetInterfaceOptions <- %d", result);
+
+	return result;
+}
+
+PropertyHandle TBStartAllJoyn::GetPropertyHandle(const std::string& propertyName) const {
+	std::map< std::string, PropertyHandle >::const_iterator property = mPropertyIndex.find(propertyName);
+
+	return property != mPropertyIndex.end() ? property->second : INVALID_PROPERTY_HANDLE;
+}
+
+bool TBStartAllJoyn::SetProperty(PropertyHandle property, const ajn::MsgArg& value) {
+	TBSTARTALLJOYNLOG("::SetProperty -> property = %u", static_cast< unsigned int >(property));
+
+	bool result = property < mProperties.size() && value.HasSignature(mProperties[property].mSignature.c_str());
+	TBSTARTALLJOYNLOG("::SetProperty -- property && value.HasSignature <- %d", result);
+
+	if(result) {
+		PropertyState& state = mPropertyStates[property];
+		{
+			std::lock_guard< std::mutex > lock(state.mMutex);
+			state.mValue = value;
+			state.mValue.Stabilize();
+			state.mHasValue = true;
+		}
+
+		// Only the first change since the last flush needs to let the emitter know
+		state.mChanged.store(true);
+		if(!mPropertiesChanged.exchange(true) && mEventQueue != NULL) {
+			mEventQueue->Wake();
+		}
+	}
+
+	TBSTARTALLJOYNLOG("::SetProperty <- %d", result);
+
+	return result;
+}
+
+bool TBStartAllJoyn::GetProperty(PropertyHandle property, ajn::MsgArg& value) const {
+	bool result = property < mProperties.size();
+
+	if(result) {
+		std::lock_guard< std::mutex > lock(mPropertyStates[property].mMutex);
+		result = mPropertyStates[property].mHasValue;
+
+		if(result) {
+			value = mPropertyStates[property].mValue;
+			value.Stabilize();
+		}
+	}
+
+	return result;
+}
+
+bool TBStartAllJoyn::SetPropertyFlushInterval(uint32_t intervalMs) {
+	TBSTARTALLJOYNLOG("::SetPropertyFlushInterval -> intervalMs = %u", intervalMs);
+
+	bool result = !IsStarted();
+	TBSTARTALLJOYNLOG("::SetPropertyFlushInterval -- !IsStarted <- %d", result);
+
+	if(result) {
+		mPropertyFlushIntervalMs = intervalMs;
+	}
+
+	TBSTARTALLJOYNLOG("::SetPropertyFlushInterval <- %d", result);
+
+	return result;
+}
+
+QStatus TBStartAllJoyn::Get(const char* ifcName, const char* propName, ajn::MsgArg& val) {
+	TBSTARTALLJOYNLOG("::Get -> ifcName = %s, propName = %s", ifcName, propName);
+
+	QStatus status = mInterfaceName == ifcName ? GetPropertyValue(propName, val) : ER_BUS_NO_SUCH_PROPERTY;
+
+	TBSTARTALLJOYNLOG("::Get <- %d", status);
+
+	return status;
+}
+
+QStatus TBStartAllJoyn::Set(const char* ifcName, const char* propName, ajn::MsgArg& val) {
+	TBSTARTALLJOYNLOG("::Set -> ifcName = %s, propName = %s", ifcName, propName);
+
+	QStatus status = mInterfaceName == ifcName ? SetPropertyValue(propName, val) : ER_BUS_NO_SUCH_PROPERTY;
+
+	TBSTARTALLJOYNLOG("::Set <- %d", status);
+
+	return status;
+}
+
+QStatus TBStartAllJoyn::GetPropertyValue(const char* propertyName, ajn::MsgArg& value) {
+	if(mMetricsProperty && strcmp(propertyName, METRICS_PROPERTY_NAME) == 0) {
+		return GetMetricsValue(value);
+	}
+
+	const PropertyHandle property = GetPropertyHandle(propertyName);
+
+	return property != INVALID_PROPERTY_HANDLE && GetProperty(property, value) ? ER_OK : ER_BUS_NO_SUCH_PROPERTY;
+}
+
+QStatus TBStartAllJoyn::SetPropertyValue(const char* propertyName, ajn::MsgArg& value) {
+	const PropertyHandle property = GetPropertyHandle(propertyName);
+	QStatus status = ER_OK;
+
+	if(property == INVALID_PROPERTY_HANDLE) {
+		status = ER_BUS_NO_SUCH_PROPERTY;
+	} else if(!mProperties[property].mWritable) {
+		status = ER_BUS_PROPERTY_ACCESS_DENIED;
+	} else if(!SetProperty(property, value)) {
+		status = ER_BUS_SET_WRONG_SIGNATURE;
+	}
+
+	return status;
+}
+
+bool TBStartAllJoyn::SetBusBackend(TBBusBackend* backend) {
+	TBSTARTALLJOYNLOG("::SetBusBackend -> backend = %p", static_cast< void* >(backend));
+
+	bool result = !IsStarted() && mHost == NULL;
+	TBSTARTALLJOYNLOG("::SetBusBackend -- !IsStarted && !mHost <- %d", result);
+
+	if(result) {
+		mBackend = backend;
+	}
+
+	TBSTARTALLJOYNLOG("::SetBusBackend <- %d", result);
+
+	return result;
+}
+
+bool TBStartAllJoyn::SetEventHistoryOptions(const EventHistoryOptions& options) {
+	TBSTARTALLJOYNLOG("::SetEventHistoryOptions -> capacity = %u, maxReplay = %u", static_cast< unsigned int >(options.mCapacity), static_cast< unsigned int >(options.mMaxReplay));
+
+	bool result = !IsStarted();
+	TBSTARTALLJOYNLOG("::SetEventHistoryOptions -- !IsStarted <- %d", result);
+
+	if(result) {
+		delete mEventHistory;
+		mEventHistory = NULL;
+		mEventHistoryOptions = options;
+
+		for(std::vector< ActionDescriptor >::iterator action = mActions.begin(); action != mActions.end(); ++action) {
+			if(action->mInvoker == &TBStartAllJoyn::ReplyEventsSince) {
+				mActions.erase(action);
+				break;
+			}
+		}
+
+		if(options.mCapacity > 0) {
+			mEventHistory = new TBEventHistory(options.mCapacity);
+
+			// The replay is an Action like any other, other than its handler being built in
+			ActionDescriptor replay(EVENT_HISTORY_ACTION_NAME, "Returns the Events emitted after a sequence number", NULL, ACTION_DISPATCH_INLINE);
+			replay.mInputSignature = "t";
+			replay.mOutputSignature = "a(tts)";
+			replay.mArgNames = "since,events";
+			replay.mAnnotation = 0;
+			replay.mInvoker = &TBStartAllJoyn::ReplyEventsSince;
+			mActions.push_back(replay);
+		}
+
+		// The Actions may have changed, so their counters go with them, as does any introspection XML made from them
+		delete[] mActionStates;
+		mActionStates = new ActionState[mActions.size()];
+		mIntrospectionXml.clear();
+		mInterfaceParts.clear();
+	}
+
+	TBSTARTALLJOYNLOG("::SetEventHistoryOptions <- %d", result);
+
+	return result;
+}
+
+std::vector< EventRecord > TBStartAllJoyn::GetEventsSince(uint64_t since) const {
+	std::vector< EventRecord > result;
+
+	if(mEventHistory != NULL) {
+		result.resize(std::min(mEventHistoryOptions.mMaxReplay, mEventHistory->GetCapacity()));
+		result.resize(mEventHistory->GetSince(since, result.empty() ? NULL : &result[0], result.size()));
+	}
+
+	return result;
+}
+
+QStatus TBStartAllJoyn::ReplyEventsSince(TBStartAllJoyn& object, const ActionDescriptor& action, const ajn::MsgArg* args, size_t argCount, ActionReply& reply) {
+	uint64_t since = 0;
+	if(argCount != 1 || !GetMsgArg(args[0], since)) {
+		return ER_BUS_BAD_SIGNATURE;
+	}
+
+	const std::vector< EventRecord > records = object.GetEventsSince(since);
+
+	std::vector< ajn::MsgArg > entries(records.size());
+	for(size_t index = 0; index < records.size(); ++index) {
+		const EventRecord& record = records[index];
+		entries[index].Set("(tts)", record.mSequence, record.mTimestampMs, object.mEvents[record.mEvent].mName.c_str());
+	}
+
+	ajn::MsgArg result;
+	QStatus status = result.Set("a(tts)", entries.size(), entries.empty() ? NULL : &entries[0]);
+
+	if(status == ER_OK) {
+		status = reply.Reply(&result, 1);
+	}
+
+	return status;
+}
+
+ActionStats TBStartAllJoyn::GetActionStats(const std::string& actionName) const {
+	ActionStats stats;
+
+	for(size_t index = 0; index < mActions.size(); ++index) {
+		if(mActions[index].mName == actionName) {
+			const ActionState& state = mActionStates[index];
+			stats.mQueueDepth = state.mQueued.load(std::memory_order_relaxed);
+			stats.mRunning = state.mRunning.load(std::memory_order_relaxed);
+			stats.mCompleted = state.mCompleted.load(std::memory_order_relaxed);
+			stats.mTotalWaitNs = state.mTotalWaitNs.load(std::memory_order_relaxed);
+			stats.mTotalLatencyNs = state.mTotalLatencyNs.load(std::memory_order_relaxed);
+			stats.mMaxLatencyNs = state.mMaxLatencyNs.load(std::memory_order_relaxed);
+			break;
+		}
+	}
+
+	return stats;
+}
+
+EventStats TBStartAllJoyn::GetEventStats(EventHandle event) const {
+	EventStats stats;
+
+	if(event < mEvents.size()) {
+		stats.mSuppressed = mEventStates[event].mSuppressed.load(std::memory_order_relaxed);
+		stats.mCoalesced = mEventStates[event].mCoalesced.load(std::memory_order_relaxed);
+	}
+
+	return stats;
+}
+
+TBStartAllJoyn::Instruments::Instruments(TBMetricsRegistry& registry) :
+	mEventsTriggered(registry.AddCounter("tbstartalljoyn_events_triggered_total", "Events Triggered, synchronously or not, whether they were emitted or not."))
+	,mEventsEmitted(registry.AddCounter("tbstartalljoyn_events_emitted_total", "Events whose Signals were sent."))
+	,mEventsFailed(registry.AddCounter("tbstartalljoyn_events_failed_total", "Events that were due to be emitted, but weren't, as the object was suspended or a Signal failed."))
+	,mEventsSuppressed(registry.AddCounter("tbstartalljoyn_events_suppressed_total", "Triggers dropped by the EmissionPolicy of their Event."))
+	,mEventsCoalesced(registry.AddCounter("tbstartalljoyn_events_coalesced_total", "Triggers folded into a trailing emission by the EmissionPolicy of their Event."))
+	,mActionsCompleted(registry.AddCounter("tbstartalljoyn_actions_completed_total", "Action calls whose handler has run."))
+	,mActionsFailed(registry.AddCounter("tbstartalljoyn_actions_failed_total", "Action calls whose handler returned an error."))
+	,mSessionsJoined(registry.AddCounter("tbstartalljoyn_sessions_joined_total", "Sessions joined to the object."))
+	,mSessionsLost(registry.AddCounter("tbstartalljoyn_sessions_lost_total", "Sessions lost by the object."))
+	,mTriggerLatency(registry.AddHistogram("tbstartalljoyn_trigger_event_seconds", "Time taken by TriggerEvent, or by TriggerEventAsync to queue the Event."))
+	,mActionLatency(registry.AddHistogram("tbstartalljoyn_action_seconds", "Time from an Action call being received to its handler finishing."))
+	,mSessionJoinLatency(registry.AddHistogram("tbstartalljoyn_session_join_seconds", "Time taken to set up a joined session."))
+{
+	for(size_t index = 0; index < LIFECYCLE_STEP_COUNT; ++index) {
+		mLifecycleLatency[index] = NULL;
+	}
+
+	const char* const help = "Time taken by the lifecycle calls of the object.";
+	mLifecycleLatency[LIFECYCLE_START] = &registry.AddHistogram("tbstartalljoyn_lifecycle_seconds", help, "call=\"start\"");
+	mLifecycleLatency[LIFECYCLE_STOP] = &registry.AddHistogram("tbstartalljoyn_lifecycle_seconds", help, "call=\"stop\"");
+	mLifecycleLatency[LIFECYCLE_SUSPEND] = &registry.AddHistogram("tbstartalljoyn_lifecycle_seconds", help, "call=\"suspend\"");
+	mLifecycleLatency[LIFECYCLE_RESUME] = &registry.AddHistogram("tbstartalljoyn_lifecycle_seconds", help, "call=\"resume\"");
+}
+
+const TBMetricsRegistry& TBStartAllJoyn::GetMetrics() const {
+	return mMetrics;
+}
+
+bool TBStartAllJoyn::SetMetricsProperty(bool enabled) {
+	TBSTARTALLJOYNLOG("::SetMetricsProperty -> enabled = %d", enabled);
+
+	bool result = !IsStarted();
+	TBSTARTALLJOYNLOG("::SetMetricsProperty -- !IsStarted <- %d", result);
+
+	if(result && enabled && !mMetricsProperty) {
+		result = GetPropertyHandle(METRICS_PROPERTY_NAME) == INVALID_PROPERTY_HANDLE;
+		TBSTARTALLJOYNLOG("::SetMetricsProperty -- !GetPropertyHandle <- %d", result);
+	}
+
+	if(result && enabled != mMetricsProperty) {
+		// The Property is served from the metrics rather than a cached value, but is described like any other. It is
+		//	always the last one, after those given to the constructor.
+		if(enabled) {
+			PropertyDescriptor metrics(METRICS_PROPERTY_NAME, "The counters and latencies in seconds of the object, by name", "a{sd}");
+			metrics.mEmitsChanged = false;
+			mProperties.push_back(metrics);
+		} else {
+			mProperties.pop_back();
+		}
+
+		// The Properties have changed, so the cached values of the others move over to a new set of states
+		const size_t keptCount = enabled ? mProperties.size() - 1 : mProperties.size();
+		PropertyState* previousStates = mPropertyStates;
+		mPropertyStates = new PropertyState[mProperties.size()];
+		mPropertyIndex.clear();
+		for(size_t index = 0; index < mProperties.size(); ++index) {
+			mPropertyIndex[mProperties[index].mName] = index;
+			if(index < keptCount) {
+				mPropertyStates[index].mValue = previousStates[index].mValue;
+				mPropertyStates[index].mValue.Stabilize();
+				mPropertyStates[index].mHasValue = previousStates[index].mHasValue;
+				mPropertyStates[index].mChanged.store(previousStates[index].mChanged.load());
+			}
+		}
+		delete[] previousStates;
+
+		// Nor does any introspection XML made from the Properties match them any more
+		mIntrospectionXml.clear();
+		mInterfaceParts.clear();
+
+		mMetricsProperty = enabled;
+	}
+
+	TBSTARTALLJOYNLOG("::SetMetricsProperty <- %d", result);
+
+	return result;
+}
+
+// The value of the Metrics Property is made up afresh on every read.
+QStatus TBStartAllJoyn::GetMetricsValue(ajn::MsgArg& value) const {
+	const std::vector< std::pair< std::string, double > > metrics(mMetrics.GetValues());
+	std::vector< ajn::MsgArg > entries(metrics.size());
+	QStatus status = ER_OK;
+
+	for(size_t index = 0; status == ER_OK && index < metrics.size(); ++index) {
+		status = entries[index].Set("{sd}", metrics[index].first.c_str(), metrics[index].second);
+	}
+
+	// The entries refer to the names in 'metrics', so the value takes a copy of them all before they go
+	if(status == ER_OK) {
+		status = value.Set("a{sd}", entries.size(), entries.empty() ? NULL : &entries[0]);
+	}
+
+	if(status == ER_OK) {
+		value.Stabilize();
+	}
+
+	return status;
+}
+
+bool TBStartAllJoyn::DigestPathName(const std::string& pathName) {
+	TBSTARTALLJOYNLOG("::DigestPathName -> pathName = %s", pathName.c_str());
+
+	mInterfaceName.clear();
+
+	bool result = pathName.length() > 0;
+	TBSTARTALLJOYNLOG("::DigestPathName -- pathName.length <- %d", result);
+
+	if(result) {
+		mInterfaceName = pathName.substr(1);
+		std::replace(mInterfaceName.begin(), mInterfaceName.end(), '/', '.');
+		result = mInterfaceName.length() > 0;
+		TBSTARTALLJOYNLOG("::DigestPathName -- std::replace %d", result);
+	}
+
+	TBSTARTALLJOYNLOG("::DigestPathName <- %d", result);
+
+	return result;
+}
+
+bool TBStartAllJoyn::DigestAboutXML(const std::string& aboutXML) {
+	TBSTARTALLJOYNLOG("::DigestAboutXML -> ");
+
+	// The XML is only parsed here; the AboutData is built from the parsed fields, and the text itself isn't kept
+	bool result = mAboutDescription.Parse(aboutXML.c_str());
+	TBSTARTALLJOYNLOG("::DigestAboutXML -- mAboutDescription.Parse <- %d", result);
+
+	mApplicationName = mAboutDescription.GetApplicationName();
+	mLanguage = mAboutDescription.GetLanguage();
+
+	TBSTARTALLJOYNLOG("::DigestAboutXML <- %d", result);
+
+	return result;
+}
+
+bool TBStartAllJoyn::SetupBusAttachment() {
+	TBSTARTALLJOYNLOG("::SetupBusAttachment -> ");
+
+	bool result = CreateBusAttachment();
+	TBSTARTALLJOYNLOG("::SetupBusAttachment -- CreateBusAttachment <- %d", result);
+
+	if(result) {
+		const uint64_t stepStart = MonotonicNanoseconds();
+		result = DefineInterface();
+		RecordLifecycleStep(LIFECYCLE_DEFINE_INTERFACE, stepStart, result);
+		TBSTARTALLJOYNLOG("::SetupBusAttachment -- DefineInterface <- %d", result);
+	}
+
+	if(result) {
+		const uint64_t stepStart = MonotonicNanoseconds();
+		result = AttachInterface();
+		RecordLifecycleStep(LIFECYCLE_ATTACH_INTERFACE, stepStart, result);
+		TBSTARTALLJOYNLOG("::SetupBusAttachment -- AttachInterface <- %d", result);
+	}
+
+	if(result) {
+		const uint64_t stepStart = MonotonicNanoseconds();
+		result = mBusAttachment->Connect() == ER_OK;
+		RecordLifecycleStep(LIFECYCLE_CONNECT, stepStart, result);
+		TBSTARTALLJOYNLOG("::SetupBusAttachment -- mBusAttachment->Connect <- %d", result);
+	}
+
+	if(result) {
+		const uint64_t stepStart = MonotonicNanoseconds();
+		result = BindSessionPort();
+		RecordLifecycleStep(LIFECYCLE_BIND_SESSION_PORT, stepStart, result);
+		TBSTARTALLJOYNLOG("::SetupBusAttachment -- BindSessionPort <- %d", result);
+	}
+
+	TBSTARTALLJOYNLOG("::SetupBusAttachment <- %d", result);
+
+	return result;
+}
+
+bool TBStartAllJoyn::CreateBusAttachment() {
+	TBSTARTALLJOYNLOG("::CreateBusAttachment -> ");
+
+	bool result = mApplicationName.length() > 0 && mBusAttachment == NULL;
+	TBSTARTALLJOYNLOG("::CreateBusAttachment -- mApplicationName.length && mBusAttachment <- %d", result);
+
+	if(result) {
+		const uint64_t stepStart = MonotonicNanoseconds();
+		result = (mBusAttachment = new ajn::BusAttachment(mApplicationName.c_str(), true)) != NULL;
+		RecordLifecycleStep(LIFECYCLE_BUS_CREATE, stepStart, result);
+		TBSTARTALLJOYNLOG("::CreateBusAttachment -- new ajn::BusAttachment <- %d", result);
+	}
+
+	if(result) {
+		const uint64_t stepStart = MonotonicNanoseconds();
+		result = mBusAttachment->Start() == ER_OK;
+		RecordLifecycleStep(LIFECYCLE_BUS_START, stepStart, result);
+		TBSTARTALLJOYNLOG("::CreateBusAttachment -- mBusAttachment->Start <- %d", result);
+	}
+
+	TBSTARTALLJOYNLOG("::CreateBusAttachment <- %d", result);
+
+	return result;
+}
+
+bool TBStartAllJoyn::BindSessionPort() {
+	TBSTARTALLJOYNLOG("::BindSessionPort -> ");
+
+	// Session delivery of Events needs every joiner in the one session
+	const bool multipoint = mEventDelivery != EVENT_DELIVERY_SESSIONLESS;
+	ajn::SessionOpts opts(ajn::SessionOpts::TRAFFIC_MESSAGES, multipoint, ajn::SessionOpts::PROXIMITY_ANY, ajn::TRANSPORT_ANY);
+
+	bool result = mBusAttachment->BindSessionPort(mSessionPort, opts, *this) == ER_OK;
+	TBSTARTALLJOYNLOG("::BindSessionPort -- mBusAttachment->BindSessionPort <- %d", result);
+
+	TBSTARTALLJOYNLOG("::BindSessionPort <- %d", result);
+
+	return result;
+}
+
+bool TBStartAllJoyn::DefineInterface() {
+	TBSTARTALLJOYNLOG("::DefineInterface -> ");
+
+	if(mInterfaceOptions.mFromXml) {
+		const bool xmlResult = DefineInterfacesFromXml();
+		TBSTARTALLJOYNLOG("::DefineInterface <- DefineInterfacesFromXml %d", xmlResult);
+		return xmlResult;
+	}
+
+	bool result = mInterfaceName.length() > 0
+		&& mLanguage.length() > 0
+		&& mApplicationName.length() > 0;
+	TBSTARTALLJOYNLOG("::DefineInterface -- mInterfaceName.length && mLanguage.length && mApplicationName.length <- %d", result);
+
+	ajn::InterfaceDescription *interfaceDefinition = NULL;
+
+	// An object that is registered again with a TBStartAllJoynHost finds its interface already defined on the shared
+	//	BusAttachment, and as interfaces can't be changed once activated, it is used as is
+	const ajn::InterfaceDescription* existingDefinition = NULL;
+	if(result) {
+		existingDefinition = mBusAttachment->GetInterface(mInterfaceName.c_str());
+		TBSTARTALLJOYNLOG("::DefineInterface -- mBusAttachment->GetInterface <- %d", existingDefinition != NULL);
+	}
+
+	if(result && existingDefinition == NULL) {
+		result = mBusAttachment->CreateInterface(mInterfaceName.c_str(), interfaceDefinition) == ER_OK && interfaceDefinition != NULL;
+		TBSTARTALLJOYNLOG("::DefineInterface -- mBusAttachment->CreateInterface && interfaceDefinition <- %d", result);
+	}
+
+	if(result && existingDefinition == NULL) {
+		interfaceDefinition->SetDescriptionLanguage(mLanguage.c_str());
+		TBSTARTALLJOYNLOG("::DefineInterface -- interfaceDefinition->SetDescriptionLanguage <-");
+
+		interfaceDefinition->SetDescription(mApplicationName.c_str());
+		TBSTARTALLJOYNLOG("::DefineInterface -- interfaceDefinition->SetDescription <-");
+	}
+
+	for(std::vector< EventDescriptor >::iterator event = mEvents.begin(); result && existingDefinition == NULL && event != mEvents.end(); ++event) {
+		if(result) {
+			result = interfaceDefinition->AddSignal(event->mName.c_str(), event->mSignature.c_str(), event->mArgNames.c_str()) == ER_OK;
+			TBSTARTALLJOYNLOG("::DefineInterface -- interfaceDefinition->AddSignal <- %d", result);
+		}
+		
+		if(result) {
+			result = interfaceDefinition->SetMemberDescription(event->mName.c_str(), event->mDescription.c_str(), true) == ER_OK;
+			TBSTARTALLJOYNLOG("::DefineInterface -- interfaceDefinition->SetMemberDescription <- %d", result);
+		}
+	}
+
+	for(std::vector< ActionDescriptor >::iterator action = mActions.begin(); result && existingDefinition == NULL && action != mActions.end(); ++action) {
+		if(result) {
+			result = interfaceDefinition->AddMethod(action->mName.c_str(), action->mInputSignature.c_str(), action->mOutputSignature.c_str(), action->mArgNames.c_str(), action->mAnnotation) == ER_OK;
+			TBSTARTALLJOYNLOG("::DefineInterface -- interfaceDefinition->AddMethod <- %d", result);
+		}
+
+		if(result) {
+			result = interfaceDefinition->SetMemberDescription(action->mName.c_str(), action->mDescription.c_str()) == ER_OK;
+			TBSTARTALLJOYNLOG("::DefineInterface -- interfaceDefinition->SetMemberDescription <- %d", result);
+		}
+	}
+
+	for(std::vector< PropertyDescriptor >::iterator property = mProperties.begin(); result && existingDefinition == NULL && property != mProperties.end(); ++property) {
+		if(result) {
+			result = interfaceDefinition->AddProperty(property->mName.c_str(), property->mSignature.c_str(), property->mWritable ? ajn::PROP_ACCESS_RW : ajn::PROP_ACCESS_READ) == ER_OK;
+			TBSTARTALLJOYNLOG("::DefineInterface -- interfaceDefinition->AddProperty <- %d", result);
+		}
+
+		if(result) {
+			result = interfaceDefinition->AddPropertyAnnotation(property->mName.c_str(), "org.freedesktop.DBus.Property.EmitsChangedSignal", property->mEmitsChanged ? "true" : "false") == ER_OK;
+			TBSTARTALLJOYNLOG("::DefineInterface -- interfaceDefinition->AddPropertyAnnotation <- %d", result);
+		}
+
+		if(result) {
+			result = interfaceDefinition->SetPropertyDescription(property->mName.c_str(), property->mDescription.c_str()) == ER_OK;
+			TBSTARTALLJOYNLOG("::DefineInterface -- interfaceDefinition->SetPropertyDescription <- %d", result);
+		}
+	}
+
+	if(result && existingDefinition == NULL) {
+		interfaceDefinition->Activate();
+		TBSTARTALLJOYNLOG("::DefineInterface -- interfaceDefinition->Activate <-");
+	}
+
+	// Resolve each Event to its Signal member once, so that TriggerEvent doesn't need to look it up by name
+	const ajn::InterfaceDescription* definition = existingDefinition != NULL ? existingDefinition : interfaceDefinition;
+	mEventMembers.assign(mEvents.size(), NULL);
+	for(size_t index = 0; result && index < mEvents.size(); ++index) {
+		result = (mEventMembers[index] = definition->GetSignal(mEvents[index].mName.c_str())) != NULL;
+		TBSTARTALLJOYNLOG("::DefineInterface -- definition->GetSignal <- %d", result);
+	}
+
+	TBSTARTALLJOYNLOG("::DefineInterface <- %d", result);
+
+	return result;
+}
+
+bool TBStartAllJoyn::AttachInterface() {
+	TBSTARTALLJOYNLOG("::AttachInterface -> ");
+
+	if(mInterfaceOptions.mFromXml) {
+		const bool xmlResult = AttachInterfacesFromXml();
+		TBSTARTALLJOYNLOG("::AttachInterface <- AttachInterfacesFromXml %d", xmlResult);
+		return xmlResult;
+	}
+
+	bool result = mBusAttachment != NULL
+		&& mInterfaceName.length() > 0
+		&& (mInterface = mBusAttachment->GetInterface(mInterfaceName.c_str())) != NULL;
+	TBSTARTALLJOYNLOG("::AttachInterface -- mBusAttachment && mInterfaceName.length && mBusAttachment->GetInterface <- %d", result);
+
+	// A hosted object is listed in its host's announcement, a standalone one only announces the About interface
+	if(result) {
+		QStatus status = AddInterface(*mInterface, mHost != NULL ? ajn::BusObject::ANNOUNCED : ajn::BusObject::UNANNOUNCED);
+		result = status == ER_OK || (mHost != NULL && status == ER_BUS_IFACE_ALREADY_EXISTS);
+		TBSTARTALLJOYNLOG("::AttachInterface -- AddInterface <- %d", result);
+	}
+
+	const ajn::InterfaceDescription::Member* method = NULL;
+	mActionIndex.clear();
+	for(std::vector< ActionDescriptor >::iterator action = mActions.begin(); result && action != mActions.end(); ++action) {
+		if(result) {
+			result = (method = mInterface->GetMethod(action->mName.c_str())) != NULL;
+			TBSTARTALLJOYNLOG("::AttachInterface -- mInterface->GetMethod <- %d", result);
+		}
+
+		if(result) {
+			mActionIndex[method] = action - mActions.begin();
+			result = AddMethodHandler(method, static_cast< ajn::MessageReceiver::MethodHandler >(&TBStartAllJoyn::DispatchAction)) == ER_OK;
+			TBSTARTALLJOYNLOG("::AttachInterface -- AddMethodHandler <- %d", result);
+		}
+	}
+
+	if(result) {
+		result = mBusAttachment->RegisterBusObject(*this, false) == ER_OK;
+		TBSTARTALLJOYNLOG("::AttachInterface -- mBusAttachment->RegisterBusObject <- %d", result);
+	}
+
+	TBSTARTALLJOYNLOG("::AttachInterface <- %d", result);
+
+	return result;
+}
+
+// The same as DefineInterface, but with the interfaces created from introspection XML in one call, rather than a call
+//	or two for every member, and the Actions resolved to their members here so that AttachInterfacesFromXml doesn't need
+//	to look them up.
+bool TBStartAllJoyn::DefineInterfacesFromXml() {
+	TBSTARTALLJOYNLOG("::DefineInterfacesFromXml -> ");
+
+	bool result = mInterfaceName.length() > 0
+		&& mLanguage.length() > 0
+		&& mApplicationName.length() > 0;
+	TBSTARTALLJOYNLOG("::DefineInterfacesFromXml -- mInterfaceName.length && mLanguage.length && mApplicationName.length <- %d", result);
+
+	// The XML only depends on the descriptors, so it is generated on the first start and kept for the rest
+	if(result && mIntrospectionXml.empty()) {
+		const std::vector< BusInterface > parts = SplitInterface(DescribeInterface(), mInterfaceOptions.mMaxMembersPerInterface);
+		mIntrospectionXml = IntrospectionXml(parts);
+		mInterfaceParts.clear();
+		for(size_t index = 0; index < parts.size(); ++index) {
+			mInterfaceParts.push_back(parts[index].mName);
+		}
+		TBSTARTALLJOYNLOG("::DefineInterfacesFromXml -- IntrospectionXml parts = %u, length = %u", static_cast< unsigned int >(parts.size()),
+			static_cast< unsigned int >(mIntrospectionXml.length()));
+	}
+
+	// As in DefineInterface, an object registered again with a TBStartAllJoynHost finds its interfaces already defined
+	if(result && mBusAttachment->GetInterface(mInterfaceParts.front().c_str()) == NULL) {
+		result = mBusAttachment->CreateInterfacesFromXml(mIntrospectionXml.c_str()) == ER_OK;
+		TBSTARTALLJOYNLOG("::DefineInterfacesFromXml -- mBusAttachment->CreateInterfacesFromXml <- %d", result);
+	}
+
+	std::map< std::string, size_t > events;
+	for(size_t index = 0; index < mEvents.size(); ++index) {
+		events[mEvents[index].mName] = index;
+	}
+
+	std::map< std::string, size_t > actions;
+	for(size_t index = 0; index < mActions.size(); ++index) {
+		actions[mActions[index].mName] = index;
+	}
+
+	mEventMembers.assign(mEvents.size(), NULL);
+	mActionIndex.clear();
+
+	size_t resolved = 0;
+	std::vector< const ajn::InterfaceDescription::Member* > members;
+	for(size_t part = 0; result && part < mInterfaceParts.size(); ++part) {
+		const ajn::InterfaceDescription* definition = mBusAttachment->GetInterface(mInterfaceParts[part].c_str());
+		result = definition != NULL;
+		TBSTARTALLJOYNLOG("::DefineInterfacesFromXml -- mBusAttachment->GetInterface %s <- %d", mInterfaceParts[part].c_str(), result);
+
+		if(result) {
+			members.resize(definition->GetMembers());
+			const size_t count = members.empty() ? 0 : definition->GetMembers(&members[0], members.size());
+
+			for(size_t index = 0; index < count; ++index) {
+				const ajn::InterfaceDescription::Member* member = members[index];
+				std::map< std::string, size_t >::const_iterator found;
+
+				if(member->memberType == ajn::MESSAGE_SIGNAL && (found = events.find(member->name.c_str())) != events.end()) {
+					mEventMembers[found->second] = member;
+					++resolved;
+				} else if(member->memberType == ajn::MESSAGE_METHOD_CALL && (found = actions.find(member->name.c_str())) != actions.end()) {
+					mActionIndex[member] = found->second;
+					++resolved;
+				}
+			}
+		}
+	}
+
+	if(result) {
+		result = resolved == mEvents.size() + mActions.size();
+		TBSTARTALLJOYNLOG("::DefineInterfacesFromXml -- resolved %u members <- %d", static_cast< unsigned int >(resolved), result);
+	}
+
+	TBSTARTALLJOYNLOG("::DefineInterfacesFromXml <- %d", result);
+
+	return result;
+}
+
+bool TBStartAllJoyn::AttachInterfacesFromXml() {
+	TBSTARTALLJOYNLOG("::AttachInterfacesFromXml -> ");
+
+	bool result = mBusAttachment != NULL && !mInterfaceParts.empty();
+	TBSTARTALLJOYNLOG("::AttachInterfacesFromXml -- mBusAttachment && mInterfaceParts <- %d", result);
+
+	for(size_t part = 0; result && part < mInterfaceParts.size(); ++part) {
+		const ajn::InterfaceDescription* definition = mBusAttachment->GetInterface(mInterfaceParts[part].c_str());
+		result = definition != NULL;
+		TBSTARTALLJOYNLOG("::AttachInterfacesFromXml -- mBusAttachment->GetInterface %s <- %d", mInterfaceParts[part].c_str(), result);
+
+		if(result) {
+			if(part == 0) {
+				mInterface = definition;
+			}
+
+			QStatus status = AddInterface(*definition, mHost != NULL ? ajn::BusObject::ANNOUNCED : ajn::BusObject::UNANNOUNCED);
+			result = status == ER_OK || (mHost != NULL && status == ER_BUS_IFACE_ALREADY_EXISTS);
+			TBSTARTALLJOYNLOG("::AttachInterfacesFromXml -- AddInterface <- %d", result);
+		}
+	}
+
+	if(result && !mActionIndex.empty()) {
+		std::vector< ajn::BusObject::MethodEntry > entries;
+		entries.reserve(mActionIndex.size());
+		for(std::map< const ajn::InterfaceDescription::Member*, size_t >::const_iterator action = mActionIndex.begin(); action != mActionIndex.end(); ++action) {
+			const ajn::BusObject::MethodEntry entry = { action->first, static_cast< ajn::MessageReceiver::MethodHandler >(&TBStartAllJoyn::DispatchAction) };
+			entries.push_back(entry);
+		}
+
+		result = AddMethodHandlers(&entries[0], entries.size()) == ER_OK;
+		TBSTARTALLJOYNLOG("::AttachInterfacesFromXml -- AddMethodHandlers <- %d", result);
+	}
+
+	if(result) {
+		result = mBusAttachment->RegisterBusObject(*this, false) == ER_OK;
+		TBSTARTALLJOYNLOG("::AttachInterfacesFromXml -- mBusAttachment->RegisterBusObject <- %d", result);
+	}
+
+	TBSTARTALLJOYNLOG("::AttachInterfacesFromXml <- %d", result);
+
+	return result;
+}
+
+bool TBStartAllJoyn::SetupAboutObject() {
+	TBSTARTALLJOYNLOG("::SetupAboutObject -> ");
+
+	bool result = PrepareAboutData();
+	TBSTARTALLJOYNLOG("::SetupAboutObject -- PrepareAboutData <- %d", result);
+
+	if(result) {
+		result = AnnounceAboutObject();
+		TBSTARTALLJOYNLOG("::SetupAboutObject -- AnnounceAboutObject <- %d", result);
+	}
+
+	TBSTARTALLJOYNLOG("::SetupAboutObject <- %d", result);
+
+	return result;
+}
+
+bool TBStartAllJoyn::PrepareAboutData() {
+	TBSTARTALLJOYNLOG("::PrepareAboutData -> ");
+
+	bool result = mAboutData == NULL;
+	TBSTARTALLJOYNLOG("::PrepareAboutData -- mAboutData <- %d", result);
+
+	if(result) {
+		result = (mAboutData = new ajn::AboutData(mLanguage.c_str())) != NULL;
+		TBSTARTALLJOYNLOG("::PrepareAboutData -- new ajn::AboutData <- %d", result);
+	}
+
+	if(result) {
+		const uint64_t stepStart = MonotonicNanoseconds();
+		result = mAboutDescription.Apply(*mAboutData);
+		RecordLifecycleStep(LIFECYCLE_ABOUT_DATA_CREATE, stepStart, result);
+		TBSTARTALLJOYNLOG("::PrepareAboutData -- mAboutDescription.Apply <- %d", result);
+	}
+
+	if(result) {
+		const uint64_t stepStart = MonotonicNanoseconds();
+		result = mAboutData->IsValid(mLanguage.c_str()) == QCC_TRUE;
+		RecordLifecycleStep(LIFECYCLE_ABOUT_DATA_VALIDATE, stepStart, result);
+		TBSTARTALLJOYNLOG("::PrepareAboutData -- mAboutData->IsValid <- %d", result);
+	}
+
+	TBSTARTALLJOYNLOG("::PrepareAboutData <- %d", result);
+
+	return result;
+}
+
+bool TBStartAllJoyn::AnnounceAboutObject() {
+	TBSTARTALLJOYNLOG("::AnnounceAboutObject -> ");
+
+	bool result = mAboutObject == NULL && mAboutData != NULL && mBusAttachment != NULL;
+	TBSTARTALLJOYNLOG("::AnnounceAboutObject -- mAboutObject && mAboutData && mBusAttachment <- %d", result);
+
+	if(result) {
+		result = (mAboutObject = new ajn::AboutObj(*mBusAttachment)) != NULL;
+		TBSTARTALLJOYNLOG("::AnnounceAboutObject -- new ajn::AboutObj <- %d", result);
+	}
+
+	if(result) {
+		const uint64_t stepStart = MonotonicNanoseconds();
 		result = mAboutObject->Announce(mSessionPort, *mAboutData) == ER_OK;
-		TBSTARTALLJOYNLOG("::SetupAboutObject -- mAboutObject->Announce <- %d", result);
+		RecordLifecycleStep(LIFECYCLE_ANNOUNCE, stepStart, result);
+		TBSTARTALLJOYNLOG("::AnnounceAboutObject -- mAboutObject->Announce <- %d", result);
+	}
+
+	TBSTARTALLJOYNLOG("::AnnounceAboutObject <- %d", result);
+
+	return result;
+}
+
+bool TBStartAllJoyn::StartEmitter() {
+	TBSTARTALLJOYNLOG("::StartEmitter -> ");
+
+	bool result = !mEmitterThread.joinable();
+	TBSTARTALLJOYNLOG("::StartEmitter -- !mEmitterThread.joinable <- %d", result);
+
+	// Trailing edge emissions and PropertiesChanged are made by the emitter thread, so it runs even if
+	//	TriggerEventAsync isn't used
+	if(result && (mEventQueueOptions.mCapacity > 0 || !mTrailingEvents.empty() || !mProperties.empty())) {
+		if(mEventQueue == NULL) {
+			result = (mEventQueue = new TBEventQueue(mEventQueueOptions)) != NULL;
+			TBSTARTALLJOYNLOG("::StartEmitter -- new TBEventQueue <- %d", result);
+		}
+
+		// Consumers read the values set before Start when they first discover the object, they aren't changes to them
+		for(size_t index = 0; index < mProperties.size(); ++index) {
+			mPropertyStates[index].mChanged.store(false);
+		}
+		mPropertiesChanged.store(false);
+
+		if(result) {
+			mEventQueue->Open();
+			mEmitterThread = std::thread(&TBStartAllJoyn::EmitterLoop, this);
+			TBSTARTALLJOYNLOG("::StartEmitter -- std::thread <-");
+		}
+	}
+
+	TBSTARTALLJOYNLOG("::StartEmitter <- %d", result);
+
+	return result;
+}
+
+void TBStartAllJoyn::StopEmitter() {
+	TBSTARTALLJOYNLOG("::StopEmitter -> ");
+
+	if(mEmitterThread.joinable()) {
+		mEventQueue->Close();
+		mEmitterThread.join();
+	}
+
+	TBSTARTALLJOYNLOG("::StopEmitter <-");
+}
+
+void TBStartAllJoyn::EmitterLoop() {
+	TBSTARTALLJOYNLOG("::EmitterLoop -> ");
+
+	EventHandle event = INVALID_EVENT_HANDLE;
+
+	// The closed state is sampled before draining, so that everything queued before Close is still emitted
+	for(bool closed = false; !closed; ) {
+		closed = mEventQueue->IsClosed();
+
+		while(mEventQueue->Pop(event)) {
+			mEventQueue->CountEmitted(EmitEvent(event));
+		}
+
+		const uint64_t untilTrailing = FlushTrailingEvents(closed);
+		const uint64_t untilProperties = FlushProperties(closed || mPropertyFlushForced.exchange(false));
+
+		if(!closed) {
+			mEventQueue->Wait(std::chrono::nanoseconds(std::min< uint64_t >(std::min(untilTrailing, untilProperties), 100000000)));
+		}
+	}
+
+	TBSTARTALLJOYNLOG("::EmitterLoop <-");
+}
+
+bool TBStartAllJoyn::AdmitEvent(EventHandle event) {
+	const EmissionPolicy& policy = mEvents[event].mPolicy;
+
+	if(policy.mMode == EmissionPolicy::EMIT_ALWAYS) {
+		return true;
+	}
+
+	EventState& state = mEventStates[event];
+	const uint64_t now = MonotonicNanoseconds();
+	const uint64_t interval = policy.mIntervalMs * 1000000ULL;
+	bool result = true;
+
+	if(policy.mMode == EmissionPolicy::EMIT_MIN_INTERVAL || policy.mMode == EmissionPolicy::EMIT_TRAILING) {
+		// Whoever moves mLastEmitted forward gets to emit, everyone else within the interval is held back
+		uint64_t last = state.mLastEmitted.load();
+		result = now - last >= interval && state.mLastEmitted.compare_exchange_strong(last, now);
+
+		if(!result && policy.mMode == EmissionPolicy::EMIT_TRAILING) {
+			state.mCoalesced.fetch_add(1, std::memory_order_relaxed);
+			mInstruments.mEventsCoalesced.Add();
+
+			// Only the first coalesced Trigger of an interval needs to let the emitter know about the new deadline
+			if(!state.mPending.exchange(true) && mEventQueue != NULL) {
+				mEventQueue->Wake();
+			}
+
+			return false;
+		}
+	} else if(policy.mMode == EmissionPolicy::EMIT_MAX_PER_WINDOW) {
+		// Starting a new window and counting the Trigger in it is a single step, so racing Triggers can't both reset
+		//	the count. The milliseconds wrap, but only their difference matters.
+		const uint32_t nowMs = static_cast< uint32_t >(now / 1000000ULL);
+		uint64_t window = state.mWindow.load();
+		uint64_t next = 0;
+
+		do {
+			const uint32_t start = static_cast< uint32_t >(window >> 32);
+			const bool expired = static_cast< uint32_t >(nowMs - start) >= policy.mIntervalMs;
+			const uint32_t count = expired ? 0 : static_cast< uint32_t >(window);
+
+			result = count < policy.mMaxCount;
+			next = (static_cast< uint64_t >(expired ? nowMs : start) << 32) | (count + 1);
+		} while(result && !state.mWindow.compare_exchange_weak(window, next));
+	}
+
+	if(!result) {
+		state.mSuppressed.fetch_add(1, std::memory_order_relaxed);
+		mInstruments.mEventsSuppressed.Add();
+	}
+
+	return result;
+}
+
+bool TBStartAllJoyn::EmitEvent(EventHandle event, const ajn::MsgArg* args, size_t argCount) {
+	TBSTARTALLJOYNLOG("::EmitEvent -> event = %u, argCount = %u", static_cast< unsigned int >(event), static_cast< unsigned int >(argCount));
+
+	bool result = IsEventReady(event);
+	TBSTARTALLJOYNLOG("::EmitEvent -- IsEventReady <- %d", result);
+
+	const ajn::SessionId session = mEventDelivery != EVENT_DELIVERY_SESSIONLESS ? mEventSession.load() : 0;
+
+	if(result && session != 0) {
+		result = SignalEvent(event, args, argCount, session, NULL);
+		TBSTARTALLJOYNLOG("::EmitEvent -- SignalEvent session = %u <- %d", session, result);
 	}
 
-	TBSTARTALLJOYNLOG("::SetupAboutObject <- %d", result);
+	// Sessionless Signals still reach consumers that have only discovered the object, unless everyone is in session
+	if(result && (mEventDelivery != EVENT_DELIVERY_SESSION || session == 0)) {
+		result = EmitSessionlessEvent(event, args, argCount);
+		TBSTARTALLJOYNLOG("::EmitEvent -- EmitSessionlessEvent <- %d", result);
+	}
+
+	if(result && mEventHistory != NULL) {
+		mEventHistory->Record(event);
+	}
+
+	if(result) {
+		mInstruments.mEventsEmitted.Add();
+	} else {
+		mInstruments.mEventsFailed.Add();
+	}
+
+	TBSTARTALLJOYNLOG("::EmitEvent <- %d", result);
+
+	return result;
+}
+
+bool TBStartAllJoyn::EmitSessionlessEvent(EventHandle event, const ajn::MsgArg* args, size_t argCount) {
+	bool result = false;
+
+	if(!mEvents[event].mSupersede) {
+		result = SignalEvent(event, args, argCount, 0, NULL);
+		TBSTARTALLJOYNLOG("::EmitSessionlessEvent -- SignalEvent <- %d", result);
+	} else {
+		uint32_t serial = 0;
+		result = SignalEvent(event, args, argCount, 0, &serial);
+		TBSTARTALLJOYNLOG("::EmitSessionlessEvent -- SignalEvent <- %d", result);
+
+		// The previous Signal is only cancelled once the new one is out, so that there is always one for new consumers
+		if(result) {
+			const uint32_t previous = mEventStates[event].mLastSerial.exchange(serial);
+			if(previous != 0) {
+				const bool cancelled = CancelEventSignal(event, previous);
+				TBSTARTALLJOYNLOG("::EmitSessionlessEvent -- CancelEventSignal <- %d", cancelled);
+			}
+		}
+	}
+
+	return result;
+}
+
+bool TBStartAllJoyn::IsEventReady(EventHandle event) const {
+	if(mSuspended.load()) {
+		return false;
+	}
+
+	if(mBackend != NULL) {
+		return event < mBusSignals.size() && mBusSignals[event] != INVALID_BUS_SIGNAL;
+	}
+
+	return event < mEventMembers.size() && mEventMembers[event] != NULL;
+}
+
+// Counts a Trigger of an Event, which started at 'triggeredAt' MonotonicNanoseconds, whether it was emitted or not.
+void TBStartAllJoyn::CountTrigger(uint64_t triggeredAt) {
+	mInstruments.mEventsTriggered.Add();
+	mInstruments.mTriggerLatency.Record(MonotonicNanoseconds() - triggeredAt);
+}
+
+// Sends the Signal of an Event to 'session', or sessionless when it is zero, in which case 'serial' if not NULL is set
+//	to the serial number of the Signal. A Signal to a session is counted against each of its members.
+bool TBStartAllJoyn::SignalEvent(EventHandle event, const ajn::MsgArg* args, size_t argCount, ajn::SessionId session, uint32_t* serial) {
+	const uint16_t timeToLive = session == 0 ? mEvents[event].mTimeToLive : 0;
+
+	if(mBackend != NULL) {
+		const bool result = mBackend->EmitSignal(mBusSignals[event], args, argCount, session, timeToLive, serial);
+		if(result && session != 0) {
+			mSessions.CountSignal(session, MarshalledSize(args, argCount));
+		}
+		return result;
+	}
+
+	if(session != 0) {
+		const bool result = Signal(NULL, session, *mEventMembers[event], args, argCount) == ER_OK;
+		if(result) {
+			mSessions.CountSignal(session, MarshalledSize(args, argCount));
+		}
+		return result;
+	}
+
+	if(serial == NULL) {
+		return Signal(NULL, 0, *mEventMembers[event], args, argCount, timeToLive, ajn::ALLJOYN_FLAG_SESSIONLESS) == ER_OK;
+	}
+
+	ajn::Message message(*mBusAttachment);
+	const bool result = Signal(NULL, 0, *mEventMembers[event], args, argCount, timeToLive, ajn::ALLJOYN_FLAG_SESSIONLESS, &message) == ER_OK;
+
+	if(result) {
+		*serial = message->GetCallSerial();
+	}
+
+	return result;
+}
+
+bool TBStartAllJoyn::CancelEventSignal(EventHandle event, uint32_t serial) {
+	if(mBackend != NULL) {
+		return mBackend->CancelSignal(mBusSignals[event], serial);
+	}
+
+	return CancelSessionlessMessage(serial) == ER_OK;
+}
+
+// Notifies consumers of the Properties changed since the last flush, once the flush interval is up or right away when
+//	'force' is set. Returns the nanoseconds until the next flush is due. While suspended there is no one to notify, so
+//	the changes are held until Resume forces a flush.
+uint64_t TBStartAllJoyn::FlushProperties(bool force) {
+	if(!mPropertiesChanged.load() || mSuspended.load()) {
+		return std::numeric_limits< uint64_t >::max();
+	}
+
+	const uint64_t now = MonotonicNanoseconds();
+	const uint64_t due = mLastPropertyFlush + mPropertyFlushIntervalMs * 1000000ULL;
+
+	if(!force && now < due) {
+		return due - now;
+	}
+
+	mPropertiesChanged.store(false);
+	mLastPropertyFlush = now;
+
+	std::vector< const char* > propertyNames;
+	for(size_t index = 0; index < mProperties.size(); ++index) {
+		if(mPropertyStates[index].mChanged.exchange(false)) {
+			propertyNames.push_back(mProperties[index].mName.c_str());
+		}
+	}
+
+	if(!propertyNames.empty()) {
+		EmitPropertiesChanged(&propertyNames[0], propertyNames.size());
+	}
+
+	return std::numeric_limits< uint64_t >::max();
+}
+
+// The new values are read back through Get, so a change made since the flush started is sent now rather than later.
+void TBStartAllJoyn::EmitPropertiesChanged(const char** propertyNames, size_t propertyCount) {
+	TBSTARTALLJOYNLOG("::EmitPropertiesChanged -> propertyCount = %u", static_cast< unsigned int >(propertyCount));
+
+	const ajn::SessionId session = mEventDelivery != EVENT_DELIVERY_SESSIONLESS ? mEventSession.load() : 0;
+
+	if(session != 0 && mBackend != NULL) {
+		mBackend->EmitPropertiesChanged(GetPath(), propertyNames, propertyCount, session);
+	} else if(session != 0) {
+		EmitPropChanged(mInterfaceName.c_str(), propertyNames, propertyCount, session);
+	}
+
+	if(mEventDelivery != EVENT_DELIVERY_SESSION || session == 0) {
+		if(mBackend != NULL) {
+			mBackend->EmitPropertiesChanged(GetPath(), propertyNames, propertyCount, 0);
+		} else {
+			EmitPropChanged(mInterfaceName.c_str(), propertyNames, propertyCount, 0, ajn::ALLJOYN_FLAG_SESSIONLESS);
+		}
+	}
+
+	TBSTARTALLJOYNLOG("::EmitPropertiesChanged <-");
+}
+
+// Emits the coalesced Triggers of EMIT_TRAILING Events whose interval is up, or all of them when 'force' is set.
+//	Returns the nanoseconds until the next one is due.
+uint64_t TBStartAllJoyn::FlushTrailingEvents(bool force) {
+	const uint64_t now = MonotonicNanoseconds();
+	uint64_t result = std::numeric_limits< uint64_t >::max();
+
+	for(std::vector< EventHandle >::const_iterator event = mTrailingEvents.begin(); event != mTrailingEvents.end(); ++event) {
+		EventState& state = mEventStates[*event];
+
+		if(state.mPending.load()) {
+			const uint64_t due = state.mLastEmitted.load() + mEvents[*event].mPolicy.mIntervalMs * 1000000ULL;
+
+			if(force || now >= due) {
+				std::lock_guard< std::mutex > lock(state.mArgsMutex);
+				state.mLastEmitted.store(now);
+				state.mPending.store(false);
+				EmitEvent(*event, state.mArgs, mEvents[*event].mArgCount);
+			} else {
+				result = std::min(result, due - now);
+			}
+		}
+	}
 
 	return result;
 }
@@ -397,7 +1989,7 @@ bool TBStartAllJoyn::AcceptSessionJoiner(ajn::SessionPort sessionPort, const cha
 {
 	TBSTARTALLJOYNLOG("::AcceptSessionJoiner -> sessionPort = %d, joiner = %s, opts = %s", sessionPort, joiner, opts.ToString().c_str());
 
-	bool result = sessionPort == mSessionPort;
+	bool result = mAdmission.Admit(sessionPort == mSessionPort, joiner, opts, mSessions.GetMemberCount());
 
 	TBSTARTALLJOYNLOG("::AcceptSessionJoiner <- %d", result);
 
@@ -407,7 +1999,445 @@ bool TBStartAllJoyn::AcceptSessionJoiner(ajn::SessionPort sessionPort, const cha
 void TBStartAllJoyn::SessionJoined(ajn::SessionPort sessionPort, ajn::SessionId id, const char* joiner)
 {
 	TBSTARTALLJOYNLOG("::SessionJoined -> sessionPort = %d, id = %d, joiner = %s", sessionPort, id, joiner);
-	TBSTARTALLJOYNLOG("::SessionJoined <-");
+
+	const uint64_t joinedAt = MonotonicNanoseconds();
+	mSessions.Add(id, joiner);
+
+	// Every joiner of a multipoint session is in the same one, which is where session delivered Events go
+	if(mEventDelivery != EVENT_DELIVERY_SESSIONLESS) {
+		mEventSession.store(id);
+	}
+
+	// A TBBusBackend sets the session listener itself
+	bool result = mBusAttachment == NULL || mBusAttachment->SetSessionListener(id, this) == ER_OK;
+	TBSTARTALLJOYNLOG("::SessionJoined -- mBusAttachment->SetSessionListener <- %d", result);
+
+	mInstruments.mSessionsJoined.Add();
+	mInstruments.mSessionJoinLatency.Record(MonotonicNanoseconds() - joinedAt);
+
+	TBSTARTALLJOYNLOG("::SessionJoined <- %d", result);
+}
+
+void TBStartAllJoyn::SessionLost(ajn::SessionId sessionId, ajn::SessionListener::SessionLostReason reason) {
+	TBSTARTALLJOYNLOG("::SessionLost -> sessionId = %u, reason = %d", sessionId, reason);
+
+	mSessions.Remove(sessionId);
+
+	ajn::SessionId lost = sessionId;
+	mEventSession.compare_exchange_strong(lost, 0);
+
+	mInstruments.mSessionsLost.Add();
+
+	TBSTARTALLJOYNLOG("::SessionLost <-");
+}
+
+void TBStartAllJoyn::SessionMemberRemoved(ajn::SessionId sessionId, const char* uniqueName) {
+	TBSTARTALLJOYNLOG("::SessionMemberRemoved -> sessionId = %u, uniqueName = %s", sessionId, uniqueName);
+
+	mSessions.Remove(sessionId, uniqueName);
+
+	TBSTARTALLJOYNLOG("::SessionMemberRemoved <-");
+}
+
+void TBStartAllJoyn::SetAdmissionOptions(const AdmissionOptions& options) {
+	TBSTARTALLJOYNLOG("::SetAdmissionOptions -> maxMembers = %u", static_cast< unsigned int >(options.mMaxMembers));
+
+	mAdmission.SetOptions(options);
+
+	TBSTARTALLJOYNLOG("::SetAdmissionOptions <-");
+}
+
+AdmissionStats TBStartAllJoyn::GetAdmissionStats() const {
+	return mAdmission.GetStats();
+}
+
+bool TBStartAllJoyn::UpdateAbout(const std::string& aboutXML) {
+	TBSTARTALLJOYNLOG("::UpdateAbout -> ");
+
+	TBAboutDescription parsed;
+	bool result = parsed.Parse(aboutXML.c_str());
+	TBSTARTALLJOYNLOG("::UpdateAbout -- parsed.Parse <- %d", result);
+
+	if(result) {
+		// Fields left out of the XML can't be taken off the AboutData, so they keep their values
+		TBAboutDescription updated(mAboutDescription);
+		for(size_t index = 0; index < parsed.GetFields().size(); ++index) {
+			updated.SetField(parsed.GetFields()[index]);
+		}
+		result = ApplyAboutUpdate(updated);
+		TBSTARTALLJOYNLOG("::UpdateAbout -- ApplyAboutUpdate <- %d", result);
+	}
+
+	TBSTARTALLJOYNLOG("::UpdateAbout <- %d", result);
+
+	return result;
+}
+
+bool TBStartAllJoyn::UpdateAbout(const std::map< std::string, std::string >& fields) {
+	TBSTARTALLJOYNLOG("::UpdateAbout -> fields = %u", static_cast< unsigned int >(fields.size()));
+
+	TBAboutDescription updated(mAboutDescription);
+	for(std::map< std::string, std::string >::const_iterator field = fields.begin(); field != fields.end(); ++field) {
+		updated.SetField(AboutField(field->first, std::string(), field->second));
+	}
+
+	const bool result = ApplyAboutUpdate(updated);
+
+	TBSTARTALLJOYNLOG("::UpdateAbout <- %d", result);
+
+	return result;
+}
+
+bool TBStartAllJoyn::ApplyAboutUpdate(const TBAboutDescription& updated) {
+	TBSTARTALLJOYNLOG("::ApplyAboutUpdate -> ");
+
+	// The AboutData is constructed with the default language, so that can't change underneath it
+	bool result = updated.GetLanguage() == mLanguage && updated.GetApplicationName().length() > 0;
+	TBSTARTALLJOYNLOG("::ApplyAboutUpdate -- updated.GetLanguage == mLanguage && updated.GetApplicationName.length <- %d", result);
+
+	if(result) {
+		result = mHost == NULL;
+		TBSTARTALLJOYNLOG("::ApplyAboutUpdate -- mHost <- %d", result);
+	}
+
+	const std::vector< AboutField > changed = updated.Diff(mAboutDescription);
+	if(result && changed.empty()) {
+		TBSTARTALLJOYNLOG("::ApplyAboutUpdate <- unchanged");
+		return true;
+	}
+
+	if(result && mAboutData != NULL && mAboutObject != NULL) {
+		result = updated.Apply(*mAboutData, changed) && mAboutData->IsValid(mLanguage.c_str()) == QCC_TRUE;
+		TBSTARTALLJOYNLOG("::ApplyAboutUpdate -- updated.Apply && mAboutData->IsValid <- %d", result);
+
+		if(result) {
+			const uint64_t stepStart = MonotonicNanoseconds();
+			result = mAboutObject->Announce(mSessionPort, *mAboutData) == ER_OK;
+			RecordLifecycleStep(LIFECYCLE_ANNOUNCE, stepStart, result);
+			TBSTARTALLJOYNLOG("::ApplyAboutUpdate -- mAboutObject->Announce <- %d", result);
+		}
+
+		// A field that failed may have left the AboutData half updated, so it is rebuilt as it was; the AboutObj serves
+		//	the AboutData it was last Announced with, so it is Announced again with the rebuilt one
+		if(!result) {
+			ajn::AboutData* restored = new ajn::AboutData(mLanguage.c_str());
+			const bool reapplied = mAboutDescription.Apply(*restored);
+			TBSTARTALLJOYNLOG("::ApplyAboutUpdate -- mAboutDescription.Apply <- %d", reapplied);
+
+			const bool reannounced = reapplied && mAboutObject->Announce(mSessionPort, *restored) == ER_OK;
+			TBSTARTALLJOYNLOG("::ApplyAboutUpdate -- mAboutObject->Announce restored <- %d", reannounced);
+
+			// Consumers are left with the failed update's announcement, so this is reported whatever the trace level
+			if(!reannounced) {
+				TBLOG(TBLOG_LEVEL_WARNING, "twobulls::TBStartAllJoyn", "::ApplyAboutUpdate -- rollback failed, Apply <- %d, Announce <- %d", reapplied, reannounced);
+			}
+
+			delete mAboutData;
+			mAboutData = restored;
+		}
+	} else if(result && mBackendConnected) {
+		// A backend builds its About data from the whole description
+		result = mBackend->Announce(mSessionPort, updated);
+		TBSTARTALLJOYNLOG("::ApplyAboutUpdate -- mBackend->Announce <- %d", result);
+	}
+
+	if(result) {
+		// The AppName is the description of the interface, so the introspection of the next Start is generated again
+		if(mAboutDescription.GetApplicationName() != updated.GetApplicationName()) {
+			mIntrospectionXml.clear();
+			mInterfaceParts.clear();
+		}
+
+		mAboutDescription = updated;
+		mApplicationName = mAboutDescription.GetApplicationName();
+	}
+
+	TBSTARTALLJOYNLOG("::ApplyAboutUpdate <- %d", result);
+
+	return result;
+}
+
+std::vector< SessionInfo > TBStartAllJoyn::GetSessions() const {
+	return mSessions.GetSnapshot();
+}
+
+void TBStartAllJoyn::DispatchAction(const ajn::InterfaceDescription::Member* member, ajn::Message& message) {
+	TBSTARTALLJOYNLOG("::DispatchAction -> member = %s", member->name.c_str());
+
+	const uint64_t received = MonotonicNanoseconds();
+
+	mSessions.CountReceived(message->GetSessionId(), message->GetSender(), message->GetBufferSize());
+
+	std::map< const ajn::InterfaceDescription::Member*, size_t >::const_iterator entry = mActionIndex.find(member);
+	bool result = entry != mActionIndex.end();
+	TBSTARTALLJOYNLOG("::DispatchAction -- mActionIndex.find <- %d", result);
+
+	if(result) {
+		DispatchCall(entry->second, member, message, received);
+	} else {
+		MethodReply(message, ER_BUS_NO_SUCH_INTERFACE);
+	}
+
+	TBSTARTALLJOYNLOG("::DispatchAction <- %d", result);
+}
+
+void TBStartAllJoyn::DispatchCall(size_t action, const ajn::InterfaceDescription::Member* member, ajn::Message& message, uint64_t received) {
+	if(UsesActionPool(mActions[action])) {
+		const bool result = QueueAction(action, member, message, received);
+		TBSTARTALLJOYNLOG("::DispatchCall -- QueueAction <- %d", result);
+	} else {
+		RunAction(action, member, message, received);
+	}
+}
+
+// Hands the invocation to the worker pool, or parks it if the Action is already at its concurrency limit.
+bool TBStartAllJoyn::QueueAction(size_t action, const ajn::InterfaceDescription::Member* member, ajn::Message& message, uint64_t received) {
+	ActionState& state = mActionStates[action];
+	bool submit = true;
+
+	state.mQueued.fetch_add(1, std::memory_order_relaxed);
+
+	if(mActions[action].mMaxConcurrency > 0) {
+		std::lock_guard< std::mutex > lock(state.mPendingMutex);
+		if(state.mInFlight < mActions[action].mMaxConcurrency) {
+			++state.mInFlight;
+		} else {
+			state.mPending.push_back(PendingAction(member, message, received));
+			submit = false;
+		}
+	}
+
+	bool result = !submit || mActionPool->Submit(std::bind(&TBStartAllJoyn::RunPooledAction, this, action, member, message, received));
+
+	// The pool only refuses work while shutting down, at which point the handler may as well run here
+	if(!result) {
+		RunPooledAction(action, member, message, received);
+	}
+
+	return result;
+}
+
+void TBStartAllJoyn::RunPooledAction(size_t action, const ajn::InterfaceDescription::Member* member, ajn::Message& message, uint64_t received) {
+	ActionState& state = mActionStates[action];
+
+	state.mQueued.fetch_sub(1, std::memory_order_relaxed);
+	RunAction(action, member, message, received);
+
+	// A finished invocation hands its slot straight to the next one waiting on the concurrency limit
+	if(mActions[action].mMaxConcurrency > 0) {
+		PendingAction next(member, message, received);
+		bool handOver = false;
+		{
+			std::lock_guard< std::mutex > lock(state.mPendingMutex);
+			handOver = !state.mPending.empty();
+			if(handOver) {
+				next = state.mPending.front();
+				state.mPending.pop_front();
+			} else {
+				--state.mInFlight;
+			}
+		}
+
+		// The pool only refuses work while shutting down, and StopActionPool answers whatever is left waiting after it
+		if(handOver && !mActionPool->Submit(std::bind(&TBStartAllJoyn::RunPooledAction, this, action, next.mMember, next.mMessage, next.mReceived))) {
+			{
+				std::lock_guard< std::mutex > lock(state.mPendingMutex);
+				--state.mInFlight;
+			}
+			state.mQueued.fetch_sub(1, std::memory_order_relaxed);
+			MethodReply(next.mMessage, ER_BUS_STOPPING);
+		}
+	}
+}
+
+void TBStartAllJoyn::RunAction(size_t action, const ajn::InterfaceDescription::Member* member, ajn::Message& message, uint64_t received) {
+	TBSTARTALLJOYNLOG("::RunAction -> action = %s", mActions[action].mName.c_str());
+
+	const ActionDescriptor& descriptor = mActions[action];
+	ActionState& state = mActionStates[action];
+	const uint64_t started = MonotonicNanoseconds();
+	bool result = true;
+
+	state.mRunning.fetch_add(1, std::memory_order_relaxed);
+
+	if(descriptor.mInvoker != NULL) {
+		size_t argCount = 0;
+		const ajn::MsgArg* args = NULL;
+		message->GetArgs(argCount, args);
+
+		MessageActionReply reply(*this, message);
+		QStatus status = descriptor.mInvoker(*this, descriptor, args, argCount, reply);
+		result = status == ER_OK;
+		TBSTARTALLJOYNLOG("::RunAction -- descriptor.mInvoker <- %d", result);
+
+		if(!result && !reply.mReplied) {
+			MethodReply(message, status);
+		}
+	} else {
+		(this->*descriptor.mHandler)(member, message);
+		TBSTARTALLJOYNLOG("::RunAction -- descriptor.mHandler <-");
+	}
+
+	CompleteAction(action, received, started, result);
+
+	TBSTARTALLJOYNLOG("::RunAction <- %d", result);
+}
+
+// Counts a finished run of an Action's handler, which was 'received' and 'started' at those MonotonicNanoseconds.
+void TBStartAllJoyn::CompleteAction(size_t action, uint64_t received, uint64_t started, bool result) {
+	ActionState& state = mActionStates[action];
+	const uint64_t latency = MonotonicNanoseconds() - started;
+
+	mInstruments.mActionsCompleted.Add();
+	mInstruments.mActionLatency.Record(latency + (started - received));
+	if(!result) {
+		mInstruments.mActionsFailed.Add();
+	}
+
+	state.mRunning.fetch_sub(1, std::memory_order_relaxed);
+	state.mCompleted.fetch_add(1, std::memory_order_relaxed);
+	state.mTotalWaitNs.fetch_add(started - received, std::memory_order_relaxed);
+	state.mTotalLatencyNs.fetch_add(latency, std::memory_order_relaxed);
+	for(uint64_t max = state.mMaxLatencyNs.load(std::memory_order_relaxed); latency > max && !state.mMaxLatencyNs.compare_exchange_weak(max, latency); ) {
+	}
+}
+
+// Calls that a TBBusBackend passes on with their Message are dispatched as those on the object's own BusAttachment are,
+//	and replied to through the backend. The others, from a TBLoopbackBus, run on its calling thread and reply through
+//	its ActionReply, which only typed Actions can do.
+QStatus TBStartAllJoyn::HandleCall(const BusCall& call, ActionReply& reply) {
+	TBSTARTALLJOYNLOG("::HandleCall -> methodName = %s", call.mMethodName);
+
+	const uint64_t received = MonotonicNanoseconds();
+
+	mSessions.CountReceived(call.mSession, call.mSender, call.mBytes);
+
+	std::map< std::string, size_t >::const_iterator entry = mActionNames.find(call.mMethodName);
+	QStatus status = entry != mActionNames.end() ? ER_OK : ER_BUS_INTERFACE_NO_SUCH_MEMBER;
+	TBSTARTALLJOYNLOG("::HandleCall -- mActionNames.find <- %d", status);
+
+	if(status == ER_OK && call.mMessage != NULL) {
+		DispatchCall(entry->second, call.mMember, *call.mMessage, received);
+	} else if(status == ER_OK) {
+		const ActionDescriptor& descriptor = mActions[entry->second];
+		const uint64_t started = MonotonicNanoseconds();
+		CountingActionReply countingReply(reply);
+
+		mActionStates[entry->second].mRunning.fetch_add(1, std::memory_order_relaxed);
+
+		if(descriptor.mInvoker != NULL) {
+			status = descriptor.mInvoker(*this, descriptor, call.mArgs, call.mArgCount, countingReply);
+			TBSTARTALLJOYNLOG("::HandleCall -- descriptor.mInvoker <- %d", status);
+		} else {
+			// A plain MethodHandler needs a Message to reply to
+			status = ER_NOT_IMPLEMENTED;
+		}
+
+		CompleteAction(entry->second, received, started, status == ER_OK);
+		if(status == ER_OK) {
+			mSessions.CountSent(call.mSession, call.mSender, countingReply.mBytes);
+		}
+	}
+
+	// The error the backend replies with instead
+	if(status != ER_OK) {
+		mSessions.CountSent(call.mSession, call.mSender, 0);
+	}
+
+	TBSTARTALLJOYNLOG("::HandleCall <- %d", status);
+
+	return status;
+}
+
+QStatus TBStartAllJoyn::MethodReply(const ajn::Message& message, const ajn::MsgArg* args, size_t argCount) {
+	mSessions.CountSent(message->GetSessionId(), message->GetSender(), MarshalledSize(args, argCount));
+
+	return mBackend != NULL ? mBackend->ReplyToCall(GetPath(), message, args, argCount) : ajn::BusObject::MethodReply(message, args, argCount);
+}
+
+QStatus TBStartAllJoyn::MethodReply(const ajn::Message& message, const char* error, const char* errorMessage) {
+	const ajn::MsgArg errorArg("s", errorMessage != NULL ? errorMessage : "");
+	mSessions.CountSent(message->GetSessionId(), message->GetSender(), MarshalledSize(&errorArg, 1));
+
+	return mBackend != NULL ? mBackend->ReplyToCall(GetPath(), message, error, errorMessage) : ajn::BusObject::MethodReply(message, error, errorMessage);
+}
+
+QStatus TBStartAllJoyn::MethodReply(const ajn::Message& message, QStatus status) {
+	// An error status goes out as the text and the code of the status
+	const ajn::MsgArg errorArgs[2] = { ajn::MsgArg("s", QCC_StatusText(status)), ajn::MsgArg("q", static_cast< uint16_t >(status)) };
+	mSessions.CountSent(message->GetSessionId(), message->GetSender(), status != ER_OK ? MarshalledSize(errorArgs, 2) : 0);
+
+	return mBackend != NULL ? mBackend->ReplyToCall(GetPath(), message, status) : ajn::BusObject::MethodReply(message, status);
+}
+
+bool TBStartAllJoyn::UsesActionPool(const ActionDescriptor& action) const {
+	return mActionPool != NULL
+		&& (action.mDispatch == ACTION_DISPATCH_POOL || (action.mDispatch == ACTION_DISPATCH_DEFAULT && mActionPoolOptions.mPoolByDefault));
+}
+
+bool TBStartAllJoyn::StartActionPool() {
+	TBSTARTALLJOYNLOG("::StartActionPool -> ");
+
+	bool result = true;
+
+	if(mActionPool == NULL && mActionPoolOptions.mThreadCount > 0) {
+		result = (mActionPool = new TBWorkerPool(mActionPoolOptions.mThreadCount)) != NULL;
+		TBSTARTALLJOYNLOG("::StartActionPool -- new TBWorkerPool <- %d", result);
+	}
+
+	TBSTARTALLJOYNLOG("::StartActionPool <- %d", result);
+
+	return result;
+}
+
+void TBStartAllJoyn::StopActionPool() {
+	TBSTARTALLJOYNLOG("::StopActionPool -> ");
+
+	if(mActionPool != NULL) {
+		mActionPool->Shutdown();
+		delete mActionPool;
+		mActionPool = NULL;
+	}
+
+	// Anything still held back by a concurrency limit won't be run, so its caller is told rather than left to time out
+	for(size_t index = 0; index < mActions.size(); ++index) {
+		std::deque< PendingAction > dropped;
+		{
+			std::lock_guard< std::mutex > lock(mActionStates[index].mPendingMutex);
+			dropped.swap(mActionStates[index].mPending);
+			mActionStates[index].mInFlight = 0;
+		}
+
+		mActionStates[index].mQueued.fetch_sub(dropped.size(), std::memory_order_relaxed);
+		for(std::deque< PendingAction >::iterator pending = dropped.begin(); pending != dropped.end(); ++pending) {
+			MethodReply(pending->mMessage, ER_BUS_STOPPING);
+		}
+	}
+
+	TBSTARTALLJOYNLOG("::StopActionPool <-");
+}
+
+TBStartAllJoyn::MessageActionReply::MessageActionReply(TBStartAllJoyn& object, ajn::Message& message) :
+	mReplied(false)
+	,mObject(object)
+	,mMessage(message)
+{
+}
+
+QStatus TBStartAllJoyn::MessageActionReply::Reply(const ajn::MsgArg* args, size_t argCount) {
+	mReplied = true;
+	return mObject.MethodReply(mMessage, args, argCount);
+}
+
+TBStartAllJoyn::CountingActionReply::CountingActionReply(ActionReply& reply) :
+	mBytes(0)
+	,mReply(reply)
+{
+}
+
+QStatus TBStartAllJoyn::CountingActionReply::Reply(const ajn::MsgArg* args, size_t argCount) {
+	mBytes = MarshalledSize(args, argCount);
+	return mReply.Reply(args, argCount);
 }
 
 } // namespace twobulls
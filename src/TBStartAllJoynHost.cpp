@@ -0,0 +1,338 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#include "TBStartAllJoynHost.h"
+
+#include <algorithm>
+
+#include "TBAllJoynRuntime.h"
+#include "TBLog.h"
+#include "TBStartAllJoyn.h"
+
+#include <alljoyn/AboutObj.h>
+#include <alljoyn/BusAttachment.h>
+
+#define TBSTARTALLJOYNHOSTLOG(...) TBLOG(TBLOG_LEVEL_TRACE, "twobulls::TBStartAllJoynHost", __VA_ARGS__)
+
+namespace twobulls {
+
+TBStartAllJoynHost::TBStartAllJoynHost(const std::string& aboutXML, const ajn::SessionPort port) :
+	mAboutDescription()
+	,mAboutDescriptionValid(false)
+	,mBusAttachment(NULL)
+	,mAboutData(NULL)
+	,mAboutObject(NULL)
+	,mSessionPort(port)
+	,mRuntimeAcquired(false)
+	,mAdmission()
+	,mSessionCount(0)
+	,mMutex()
+	,mObjects()
+{
+	TBSTARTALLJOYNHOSTLOG("::TBStartAllJoynHost -> ");
+
+	mAboutDescriptionValid = mAboutDescription.Parse(aboutXML.c_str());
+	TBSTARTALLJOYNHOSTLOG("::TBStartAllJoynHost -- mAboutDescription.Parse <- %d", mAboutDescriptionValid);
+
+	TBSTARTALLJOYNHOSTLOG("::TBStartAllJoynHost <-");
+}
+
+TBStartAllJoynHost::~TBStartAllJoynHost() {
+	TBSTARTALLJOYNHOSTLOG("::~TBStartAllJoynHost -> ");
+
+	// StopHosted clears each object's mHost, so an object destroyed after the host doesn't call back into it
+	Stop();
+
+	TBSTARTALLJOYNHOSTLOG("::~TBStartAllJoynHost <-");
+}
+
+bool TBStartAllJoynHost::Start() {
+	TBSTARTALLJOYNHOSTLOG("::Start -> ");
+
+	bool result = mBusAttachment == NULL;
+	TBSTARTALLJOYNHOSTLOG("::Start -- mBusAttachment <- %d", result);
+
+	if(result) {
+		result = mRuntimeAcquired = TBAllJoynRuntime::Acquire();
+		TBSTARTALLJOYNHOSTLOG("::Start -- TBAllJoynRuntime::Acquire <- %d", result);
+	}
+
+	// The About data is built first, as the BusAttachment is named after its AppName
+	if(result) {
+		result = mAboutDescriptionValid;
+		TBSTARTALLJOYNHOSTLOG("::Start -- mAboutDescriptionValid <- %d", result);
+	}
+
+	if(result) {
+		result = (mAboutData = new ajn::AboutData(mAboutDescription.GetLanguage().c_str())) != NULL;
+		TBSTARTALLJOYNHOSTLOG("::Start -- new ajn::AboutData <- %d", result);
+	}
+
+	if(result) {
+		result = mAboutDescription.Apply(*mAboutData);
+		TBSTARTALLJOYNHOSTLOG("::Start -- mAboutDescription.Apply <- %d", result);
+	}
+
+	if(result) {
+		result = mAboutData->IsValid(mAboutDescription.GetLanguage().c_str()) == QCC_TRUE;
+		TBSTARTALLJOYNHOSTLOG("::Start -- mAboutData->IsValid <- %d", result);
+	}
+
+	if(result) {
+		result = (mBusAttachment = new ajn::BusAttachment(mAboutDescription.GetApplicationName().c_str(), true)) != NULL;
+		TBSTARTALLJOYNHOSTLOG("::Start -- new ajn::BusAttachment <- %d", result);
+	}
+
+	if(result) {
+		result = mBusAttachment->Start() == ER_OK;
+		TBSTARTALLJOYNHOSTLOG("::Start -- mBusAttachment->Start <- %d", result);
+	}
+
+	if(result) {
+		result = mBusAttachment->Connect() == ER_OK;
+		TBSTARTALLJOYNHOSTLOG("::Start -- mBusAttachment->Connect <- %d", result);
+	}
+
+	if(result) {
+		ajn::SessionOpts opts(ajn::SessionOpts::TRAFFIC_MESSAGES, false, ajn::SessionOpts::PROXIMITY_ANY, ajn::TRANSPORT_ANY);
+
+		result = mBusAttachment->BindSessionPort(mSessionPort, opts, *this) == ER_OK;
+		TBSTARTALLJOYNHOSTLOG("::Start -- mBusAttachment->BindSessionPort <- %d", result);
+	}
+
+	if(result) {
+		result = (mAboutObject = new ajn::AboutObj(*mBusAttachment)) != NULL;
+		TBSTARTALLJOYNHOSTLOG("::Start -- new ajn::AboutObj <- %d", result);
+	}
+
+	if(result) {
+		result = Announce();
+		TBSTARTALLJOYNHOSTLOG("::Start -- Announce <- %d", result);
+	}
+
+	TBSTARTALLJOYNHOSTLOG("::Start <- %d", result);
+
+	return result;
+}
+
+void TBStartAllJoynHost::Stop() {
+	TBSTARTALLJOYNHOSTLOG("::Stop -> ");
+
+	std::vector< TBStartAllJoyn* > objects;
+	{
+		std::lock_guard< std::mutex > lock(mMutex);
+		objects.swap(mObjects);
+	}
+
+	for(std::vector< TBStartAllJoyn* >::iterator object = objects.begin(); object != objects.end(); ++object) {
+		(*object)->StopHosted();
+	}
+
+	if(mBusAttachment != NULL) {
+		mBusAttachment->Stop();
+		mBusAttachment->Join();
+	}
+
+	if(mAboutObject != NULL) {
+		delete mAboutObject;
+		mAboutObject = NULL;
+	}
+
+	if(mBusAttachment != NULL) {
+		delete mBusAttachment;
+		mBusAttachment = NULL;
+	}
+
+	if(mRuntimeAcquired) {
+		TBAllJoynRuntime::Release();
+		mRuntimeAcquired = false;
+	}
+
+	if(mAboutData != NULL) {
+		delete mAboutData;
+		mAboutData = NULL;
+	}
+
+	mSessionCount.store(0);
+
+	TBSTARTALLJOYNHOSTLOG("::Stop <-");
+}
+
+bool TBStartAllJoynHost::Register(TBStartAllJoyn& object, bool announce) {
+	TBSTARTALLJOYNHOSTLOG("::Register -> announce = %d", announce);
+
+	bool result = mBusAttachment != NULL;
+	TBSTARTALLJOYNHOSTLOG("::Register -- mBusAttachment <- %d", result);
+
+	// The object is listed before it starts, so that it can't be registered twice meanwhile
+	if(result) {
+		std::lock_guard< std::mutex > lock(mMutex);
+		result = std::find(mObjects.begin(), mObjects.end(), &object) == mObjects.end();
+		TBSTARTALLJOYNHOSTLOG("::Register -- std::find <- %d", result);
+
+		if(result) {
+			mObjects.push_back(&object);
+		}
+	}
+
+	// As in Unregister, the object starts outside the lock, as a failed start stops it again
+	if(result) {
+		result = object.StartHosted(*this);
+		TBSTARTALLJOYNHOSTLOG("::Register -- object.StartHosted <- %d", result);
+
+		if(!result) {
+			std::lock_guard< std::mutex > lock(mMutex);
+			std::vector< TBStartAllJoyn* >::iterator entry = std::find(mObjects.begin(), mObjects.end(), &object);
+			if(entry != mObjects.end()) {
+				mObjects.erase(entry);
+			}
+		}
+	}
+
+	if(result && announce) {
+		result = Announce();
+		TBSTARTALLJOYNHOSTLOG("::Register -- Announce <- %d", result);
+	}
+
+	TBSTARTALLJOYNHOSTLOG("::Register <- %d", result);
+
+	return result;
+}
+
+void TBStartAllJoynHost::Unregister(TBStartAllJoyn& object, bool announce) {
+	TBSTARTALLJOYNHOSTLOG("::Unregister -> announce = %d", announce);
+
+	bool result = false;
+	{
+		std::lock_guard< std::mutex > lock(mMutex);
+		std::vector< TBStartAllJoyn* >::iterator entry = std::find(mObjects.begin(), mObjects.end(), &object);
+		result = entry != mObjects.end();
+		TBSTARTALLJOYNHOSTLOG("::Unregister -- std::find <- %d", result);
+
+		if(result) {
+			mObjects.erase(entry);
+		}
+	}
+
+	// As in Stop, the object waits on its handlers outside the lock, as they or the session callbacks may need it
+	if(result) {
+		object.StopHosted();
+	}
+
+	if(result && announce) {
+		result = Announce();
+		TBSTARTALLJOYNHOSTLOG("::Unregister -- Announce <- %d", result);
+	}
+
+	TBSTARTALLJOYNHOSTLOG("::Unregister <-");
+}
+
+// The announcement lists the announced interfaces of every BusObject on the BusAttachment, so announcing again is all
+//	it takes to publish the objects registered or unregistered since.
+bool TBStartAllJoynHost::Announce() {
+	TBSTARTALLJOYNHOSTLOG("::Announce -> ");
+
+	bool result = mAboutObject != NULL && mAboutData != NULL;
+	TBSTARTALLJOYNHOSTLOG("::Announce -- mAboutObject && mAboutData <- %d", result);
+
+	if(result) {
+		result = mAboutObject->Announce(mSessionPort, *mAboutData) == ER_OK;
+		TBSTARTALLJOYNHOSTLOG("::Announce -- mAboutObject->Announce <- %d", result);
+	}
+
+	TBSTARTALLJOYNHOSTLOG("::Announce <- %d", result);
+
+	return result;
+}
+
+ajn::BusAttachment* TBStartAllJoynHost::GetBusAttachment() const {
+	return mBusAttachment;
+}
+
+ajn::SessionPort TBStartAllJoynHost::GetSessionPort() const {
+	return mSessionPort;
+}
+
+size_t TBStartAllJoynHost::GetObjectCount() const {
+	std::lock_guard< std::mutex > lock(mMutex);
+	return mObjects.size();
+}
+
+void TBStartAllJoynHost::SetAdmissionOptions(const AdmissionOptions& options) {
+	mAdmission.SetOptions(options);
+}
+
+AdmissionStats TBStartAllJoynHost::GetAdmissionStats() const {
+	return mAdmission.GetStats();
+}
+
+// From SessionPortListener
+bool TBStartAllJoynHost::AcceptSessionJoiner(ajn::SessionPort sessionPort, const char* joiner, const ajn::SessionOpts& opts) {
+	TBSTARTALLJOYNHOSTLOG("::AcceptSessionJoiner -> sessionPort = %d, joiner = %s, opts = %s", sessionPort, joiner, opts.ToString().c_str());
+
+	bool result = mAdmission.Admit(sessionPort == mSessionPort, joiner, opts, mSessionCount.load());
+
+	TBSTARTALLJOYNHOSTLOG("::AcceptSessionJoiner <- %d", result);
+
+	return result;
+}
+
+void TBStartAllJoynHost::SessionJoined(ajn::SessionPort sessionPort, ajn::SessionId id, const char* joiner) {
+	TBSTARTALLJOYNHOSTLOG("::SessionJoined -> sessionPort = %d, id = %d, joiner = %s", sessionPort, id, joiner);
+
+	// The session reaches every hosted object, so each of them tracks it
+	{
+		std::lock_guard< std::mutex > lock(mMutex);
+		for(std::vector< TBStartAllJoyn* >::iterator object = mObjects.begin(); object != mObjects.end(); ++object) {
+			(*object)->mSessions.Add(id, joiner);
+		}
+	}
+
+	mSessionCount.fetch_add(1);
+
+	bool result = mBusAttachment->SetSessionListener(id, this) == ER_OK;
+	TBSTARTALLJOYNHOSTLOG("::SessionJoined -- mBusAttachment->SetSessionListener <- %d", result);
+
+	TBSTARTALLJOYNHOSTLOG("::SessionJoined <- %d", result);
+}
+
+void TBStartAllJoynHost::SessionLost(ajn::SessionId sessionId, ajn::SessionListener::SessionLostReason reason) {
+	TBSTARTALLJOYNHOSTLOG("::SessionLost -> sessionId = %u, reason = %d", sessionId, reason);
+
+	mSessionCount.fetch_sub(1);
+
+	std::lock_guard< std::mutex > lock(mMutex);
+	for(std::vector< TBStartAllJoyn* >::iterator object = mObjects.begin(); object != mObjects.end(); ++object) {
+		(*object)->mSessions.Remove(sessionId);
+	}
+
+	TBSTARTALLJOYNHOSTLOG("::SessionLost <-");
+}
+
+void TBStartAllJoynHost::SessionMemberRemoved(ajn::SessionId sessionId, const char* uniqueName) {
+	TBSTARTALLJOYNHOSTLOG("::SessionMemberRemoved -> sessionId = %u, uniqueName = %s", sessionId, uniqueName);
+
+	std::lock_guard< std::mutex > lock(mMutex);
+	for(std::vector< TBStartAllJoyn* >::iterator object = mObjects.begin(); object != mObjects.end(); ++object) {
+		(*object)->mSessions.Remove(sessionId, uniqueName);
+	}
+
+	TBSTARTALLJOYNHOSTLOG("::SessionMemberRemoved <-");
+}
+
+} // namespace twobulls
@@ -0,0 +1,145 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+#include "TBWorkerPool.h"
+
+namespace twobulls {
+
+TBWorkerPool::TBWorkerPool(size_t threadCount) :
+	mWorkers()
+	,mNextWorker(0)
+	,mQueueDepth(0)
+	,mSubmitting(0)
+	,mShuttingDown(false)
+	,mSleeping(0)
+{
+	for(size_t index = 0; index < threadCount; ++index) {
+		mWorkers.push_back(new Worker());
+	}
+
+	// The threads are started once every Worker exists, as they steal from each other
+	for(size_t index = 0; index < mWorkers.size(); ++index) {
+		mWorkers[index]->mThread = std::thread(&TBWorkerPool::WorkerLoop, this, index);
+	}
+}
+
+TBWorkerPool::~TBWorkerPool() {
+	Shutdown();
+
+	for(std::vector< Worker* >::iterator worker = mWorkers.begin(); worker != mWorkers.end(); ++worker) {
+		delete *worker;
+	}
+	mWorkers.clear();
+}
+
+bool TBWorkerPool::Submit(const Task& task) {
+	// Announced before the shutting down flag is looked at, and the workers only leave once nobody is submitting, so a
+	//	task is either refused or counted before any worker can decide there is nothing left to run
+	mSubmitting.fetch_add(1);
+	bool result = !mShuttingDown.load() && !mWorkers.empty();
+
+	if(result) {
+		Worker* worker = mWorkers[mNextWorker.fetch_add(1, std::memory_order_relaxed) % mWorkers.size()];
+
+		// Counted before it is visible, so that a worker taking it straight away can't take the depth below zero
+		mQueueDepth.fetch_add(1);
+		std::lock_guard< std::mutex > workerLock(worker->mMutex);
+		worker->mTasks.push_back(task);
+	}
+	mSubmitting.fetch_sub(1);
+
+	// The lock is only taken to wake a worker, so that the notification can't slip in between its check and its wait
+	if(result && mSleeping.load() > 0) {
+		std::lock_guard< std::mutex > lock(mMutex);
+		mCondition.notify_one();
+	}
+
+	return result;
+}
+
+void TBWorkerPool::Shutdown() {
+	{
+		std::lock_guard< std::mutex > lock(mMutex);
+		mShuttingDown.store(true);
+		mCondition.notify_all();
+	}
+
+	for(std::vector< Worker* >::iterator worker = mWorkers.begin(); worker != mWorkers.end(); ++worker) {
+		if((*worker)->mThread.joinable()) {
+			(*worker)->mThread.join();
+		}
+	}
+
+	// The workers only leave once the queues are empty, but whatever is left is run here rather than lost
+	Task task;
+	while(TakeTask(0, task)) {
+		task();
+		task = Task();
+	}
+}
+
+size_t TBWorkerPool::GetQueueDepth() const {
+	return mQueueDepth.load(std::memory_order_relaxed);
+}
+
+size_t TBWorkerPool::GetThreadCount() const {
+	return mWorkers.size();
+}
+
+void TBWorkerPool::WorkerLoop(size_t index) {
+	Task task;
+
+	for(;;) {
+		if(TakeTask(index, task)) {
+			task();
+			task = Task();
+			continue;
+		}
+
+		std::unique_lock< std::mutex > lock(mMutex);
+		if(mShuttingDown.load() && mSubmitting.load() == 0 && mQueueDepth.load() == 0) {
+			break;
+		}
+
+		// Submit only notifies when someone is asleep, so the depth is checked again once counted as sleeping
+		mSleeping.fetch_add(1);
+		if(mQueueDepth.load() == 0 && !mShuttingDown.load()) {
+			mCondition.wait_for(lock, std::chrono::milliseconds(100));
+		}
+		mSleeping.fetch_sub(1);
+	}
+}
+
+// Takes the oldest task of the worker's own queue, or failing that the oldest task of another worker's queue.
+bool TBWorkerPool::TakeTask(size_t index, Task& task) {
+	for(size_t offset = 0; offset < mWorkers.size(); ++offset) {
+		Worker* worker = mWorkers[(index + offset) % mWorkers.size()];
+		std::lock_guard< std::mutex > lock(worker->mMutex);
+
+		if(!worker->mTasks.empty()) {
+			task.swap(worker->mTasks.front());
+			worker->mTasks.pop_front();
+			mQueueDepth.fetch_sub(1);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+} // namespace twobulls
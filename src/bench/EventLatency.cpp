@@ -0,0 +1,206 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+// A comparison of the time from TriggerEvent to the Signal arriving at a consumer, for sessionless and session
+//	delivered Events. The producer and consumer are in the same process, on BusAttachments of their own, so the
+//	figures include the trip through the router but not the network.
+//
+// Usage: EventLatency [count [intervalMs]]
+
+#include "TBClock.h"
+#include "TBStartAllJoyn.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+#include <alljoyn/BusAttachment.h>
+
+namespace {
+
+const char* const PATH_NAME = "/com/twobulls/bench/latency";
+const char* const INTERFACE_NAME = "com.twobulls.bench.latency";
+const ajn::SessionPort SESSION_PORT = 1338;
+
+const char* const ABOUT_XML =
+	"<About>"
+	"<DefaultLanguage>en</DefaultLanguage>"
+	"<AppId>7d1c0a52-3b4e-4f21-9a7e-3c2f55e0b1a4</AppId>"
+	"<DeviceId>00000000-0000-0000-0000-000000000001</DeviceId>"
+	"<AppName>EventLatency</AppName>"
+	"<Manufacturer>Two Bulls</Manufacturer>"
+	"<ModelNumber>001</ModelNumber>"
+	"<Description>Event latency benchmark</Description>"
+	"<SoftwareVersion>0.0.1</SoftwareVersion>"
+	"<DeviceName>EventLatency</DeviceName>"
+	"</About>";
+
+// Exposes the unique name of the producer's BusAttachment, for the consumer to join its session.
+class LatencyProducer :
+	public twobulls::TBStartAllJoyn
+{
+	public:
+		LatencyProducer(const std::vector< twobulls::EventDescriptor >& events) :
+			twobulls::TBStartAllJoyn(ABOUT_XML, PATH_NAME, SESSION_PORT, events)
+		{};
+
+		std::string GetUniqueName() const {
+			return mBusAttachment != NULL ? mBusAttachment->GetUniqueName().c_str() : "";
+		};
+};
+
+// Receives the Tick Signals, each carrying the MonotonicNanoseconds at which it was Triggered.
+class LatencyConsumer :
+	public ajn::MessageReceiver
+{
+	public:
+		LatencyConsumer() :
+			mBusAttachment("EventLatencyConsumer", true)
+			,mReceived(0)
+		{};
+
+		~LatencyConsumer() {
+			mBusAttachment.Stop();
+			mBusAttachment.Join();
+		};
+
+		bool Setup(twobulls::EventDelivery delivery, const std::string& producerName) {
+			bool result = mBusAttachment.Start() == ER_OK && mBusAttachment.Connect() == ER_OK;
+
+			ajn::InterfaceDescription* definition = NULL;
+			if(result) {
+				result = mBusAttachment.CreateInterface(INTERFACE_NAME, definition) == ER_OK && definition->AddSignal("Tick", "t", "sent") == ER_OK;
+			}
+
+			if(result) {
+				definition->Activate();
+				result = mBusAttachment.RegisterSignalHandler(this, static_cast< ajn::MessageReceiver::SignalHandler >(&LatencyConsumer::HandleTick),
+					definition->GetSignal("Tick"), PATH_NAME) == ER_OK;
+			}
+
+			if(result && delivery == twobulls::EVENT_DELIVERY_SESSIONLESS) {
+				result = mBusAttachment.AddMatch("type='signal',interface='com.twobulls.bench.latency',member='Tick',sessionless='t'") == ER_OK;
+			} else if(result) {
+				ajn::SessionOpts opts(ajn::SessionOpts::TRAFFIC_MESSAGES, true, ajn::SessionOpts::PROXIMITY_ANY, ajn::TRANSPORT_ANY);
+				ajn::SessionId id = 0;
+				result = mBusAttachment.JoinSession(producerName.c_str(), SESSION_PORT, NULL, id, opts) == ER_OK;
+			}
+
+			return result;
+		};
+
+		// Waits for the Tick after 'received' have arrived. Returns false if it didn't turn up in time.
+		bool WaitFor(size_t received, std::chrono::milliseconds timeout) {
+			std::unique_lock< std::mutex > lock(mMutex);
+			return mCondition.wait_for(lock, timeout, [this, received]() { return mReceived > received; });
+		};
+
+		std::vector< uint64_t > TakeLatencies() {
+			std::lock_guard< std::mutex > lock(mMutex);
+			std::vector< uint64_t > result;
+			result.swap(mLatencies);
+			mReceived = 0;
+			return result;
+		};
+
+	private:
+		void HandleTick(const ajn::InterfaceDescription::Member* member, const char* srcPath, ajn::Message& message) {
+			const uint64_t now = twobulls::MonotonicNanoseconds();
+			uint64_t sent = 0;
+			if(twobulls::GetMsgArg(*message->GetArg(0), sent)) {
+				std::lock_guard< std::mutex > lock(mMutex);
+				mLatencies.push_back(now - sent);
+				++mReceived;
+				mCondition.notify_all();
+			}
+		};
+
+		ajn::BusAttachment mBusAttachment;
+		std::mutex mMutex;
+		std::condition_variable mCondition;
+		std::vector< uint64_t > mLatencies;
+		size_t mReceived;
+};
+
+double Percentile(const std::vector< uint64_t >& sorted, double percentile) {
+	return sorted.empty() ? 0 : sorted[std::min(sorted.size() - 1, static_cast< size_t >(percentile * sorted.size()))] / 1000.0;
+}
+
+bool Run(twobulls::EventDelivery delivery, const char* label, size_t count, unsigned int intervalMs) {
+	std::vector< twobulls::EventDescriptor > events;
+	events.push_back(twobulls::TypedEventDescriptor< uint64_t >("Tick", "Latency probe", "sent"));
+
+	LatencyProducer producer(events);
+	producer.SetEventDelivery(delivery);
+
+	twobulls::TypedEventHandle< uint64_t > tick;
+	bool result = producer.Start() && producer.GetEventHandle("Tick", tick);
+
+	LatencyConsumer consumer;
+	if(result) {
+		result = consumer.Setup(delivery, producer.GetUniqueName());
+	}
+
+	if(!result) {
+		fprintf(stderr, "%s: setup failed\n", label);
+		return false;
+	}
+
+	// Give the match rule or session time to settle before measuring
+	std::this_thread::sleep_for(std::chrono::seconds(1));
+	consumer.TakeLatencies();
+
+	size_t lost = 0;
+	for(size_t index = 0, received = 0; index < count; ++index) {
+		producer.TriggerEvent(tick, twobulls::MonotonicNanoseconds());
+		if(consumer.WaitFor(received, std::chrono::milliseconds(1000))) {
+			++received;
+		} else {
+			++lost;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+	}
+
+	std::vector< uint64_t > latencies = consumer.TakeLatencies();
+	std::sort(latencies.begin(), latencies.end());
+
+	printf("%-12s received %6u lost %4u  p50 %9.1fus  p90 %9.1fus  p99 %9.1fus  max %9.1fus\n", label,
+		static_cast< unsigned int >(latencies.size()), static_cast< unsigned int >(lost),
+		Percentile(latencies, 0.5), Percentile(latencies, 0.9), Percentile(latencies, 0.99), Percentile(latencies, 1.0));
+
+	producer.Stop();
+
+	return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	const size_t count = argc > 1 ? static_cast< size_t >(atoi(argv[1])) : 200;
+	const unsigned int intervalMs = argc > 2 ? static_cast< unsigned int >(atoi(argv[2])) : 20;
+
+	bool result = Run(twobulls::EVENT_DELIVERY_SESSIONLESS, "sessionless", count, intervalMs);
+	result = Run(twobulls::EVENT_DELIVERY_SESSION, "session", count, intervalMs) && result;
+
+	return result ? 0 : 1;
+}
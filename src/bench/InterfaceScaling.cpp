@@ -0,0 +1,127 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+// How the time to Start an object grows with the number of members on its interface, defining the interface a member
+//	at a time, from introspection XML, and from introspection XML split over several interfaces. Each object is started
+//	twice, as the XML is generated on the first Start and kept for the next. The DefineInterface and AttachInterface
+//	steps are reported on their own, as the rest of Start is dominated by connecting to the router.
+//
+// Usage: InterfaceScaling [maxMembersPerInterface [memberCount ...]]
+
+#include "TBLifecycleStats.h"
+#include "TBStartAllJoyn.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* const PATH_NAME = "/com/twobulls/bench/scaling";
+const ajn::SessionPort SESSION_PORT = 1339;
+
+const char* const ABOUT_XML =
+	"<About>"
+	"<DefaultLanguage>en</DefaultLanguage>"
+	"<AppId>2f9c6d10-8b3a-4e57-a1d4-5c7e9b0f2a63</AppId>"
+	"<DeviceId>00000000-0000-0000-0000-000000000003</DeviceId>"
+	"<AppName>InterfaceScaling</AppName>"
+	"<Manufacturer>Two Bulls</Manufacturer>"
+	"<ModelNumber>001</ModelNumber>"
+	"<Description>Interface scaling benchmark</Description>"
+	"<SoftwareVersion>0.0.1</SoftwareVersion>"
+	"<DeviceName>InterfaceScaling</DeviceName>"
+	"</About>";
+
+// An object with 'memberCount' members, one in ten of them an Action and the rest Events, as on a gateway.
+class ScalingObject :
+	public twobulls::TBStartAllJoyn
+{
+	public:
+		ScalingObject(size_t memberCount) :
+			twobulls::TBStartAllJoyn(ABOUT_XML, PATH_NAME, SESSION_PORT, Events(memberCount), Actions(memberCount))
+		{};
+
+	private:
+		static std::vector< twobulls::EventDescriptor > Events(size_t memberCount) {
+			std::vector< twobulls::EventDescriptor > events;
+			for(size_t index = 0; index < memberCount - memberCount / 10; ++index) {
+				events.push_back(twobulls::TypedEventDescriptor< uint32_t >("Event" + std::to_string(index), "A numbered Event", "value"));
+			}
+			return events;
+		};
+
+		static std::vector< twobulls::ActionDescriptor > Actions(size_t memberCount) {
+			std::vector< twobulls::ActionDescriptor > actions;
+			for(size_t index = 0; index < memberCount / 10; ++index) {
+				actions.push_back(twobulls::TypedActionDescriptor< uint32_t(uint32_t) >("Action" + std::to_string(index), "A numbered Action",
+					&ScalingObject::HandleAction, "value,result"));
+			}
+			return actions;
+		};
+
+		uint32_t HandleAction(uint32_t value) {
+			return value;
+		};
+};
+
+double Milliseconds(const twobulls::LifecycleStats& stats, twobulls::LifecycleStep step) {
+	return stats.GetTiming(step).mDurationNs / 1000000.0;
+}
+
+bool Run(const char* label, size_t memberCount, const twobulls::InterfaceOptions& options) {
+	ScalingObject object(memberCount);
+	bool result = object.SetInterfaceOptions(options);
+
+	for(int pass = 0; result && pass < 2; ++pass) {
+		result = object.Start();
+		const twobulls::LifecycleStats stats = object.GetLifecycleStats();
+		object.Stop();
+
+		printf("%-10s members %5u  %-6s  define %8.2fms  attach %8.2fms  start %8.2fms%s\n", label, static_cast< unsigned int >(memberCount),
+			pass == 0 ? "first" : "again", Milliseconds(stats, twobulls::LIFECYCLE_DEFINE_INTERFACE), Milliseconds(stats, twobulls::LIFECYCLE_ATTACH_INTERFACE),
+			Milliseconds(stats, twobulls::LIFECYCLE_START), result ? "" : "  FAILED");
+	}
+
+	return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	const size_t maxMembersPerInterface = argc > 1 ? static_cast< size_t >(atoi(argv[1])) : 100;
+
+	std::vector< size_t > memberCounts;
+	for(int index = 2; index < argc; ++index) {
+		memberCounts.push_back(static_cast< size_t >(atoi(argv[index])));
+	}
+	if(memberCounts.empty()) {
+		const size_t defaults[] = { 10, 50, 100, 250, 500, 1000 };
+		memberCounts.assign(defaults, defaults + sizeof(defaults) / sizeof(defaults[0]));
+	}
+
+	bool result = true;
+	for(size_t index = 0; index < memberCounts.size(); ++index) {
+		result = Run("members", memberCounts[index], twobulls::InterfaceOptions()) && result;
+		result = Run("xml", memberCounts[index], twobulls::InterfaceOptions(true)) && result;
+		result = Run("xml-split", memberCounts[index], twobulls::InterfaceOptions(true, maxMembersPerInterface)) && result;
+	}
+
+	return result ? 0 : 1;
+}
@@ -0,0 +1,479 @@
+// Copyright 2015 Two Bulls Holding Pty Ltd
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TBStartAllJoyn
+//
+// http://higgns.com/tbstartalljoyn
+
+// A regression suite for the costs of the library itself: TriggerEvent throughput and latency on one and several
+//	threads, the round trip of an Action, a Start/Stop cycle, parsing the About XML and the memory taken by an instance.
+//	It runs on the in-process TBLoopbackBus by default, which measures the library without a router, or on a local
+//	AllJoyn router through TBAllJoynBackend. With --json the results are written as a single JSON document, so that
+//	runs can be compared from one build or SDK to the next.
+//
+// Usage: Suite [--bus loopback|alljoyn] [--iterations N] [--threads N] [--json]
+
+#include "TBAboutDescription.h"
+#include "TBAllJoynBackend.h"
+#include "TBClock.h"
+#include "TBLoopbackBus.h"
+#include "TBStartAllJoyn.h"
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <alljoyn/BusAttachment.h>
+#include <alljoyn/ProxyBusObject.h>
+
+namespace {
+
+// The number of bytes currently allocated through operator new, for measuring the memory per instance.
+std::atomic< int64_t > gAllocatedBytes(0);
+
+// Each allocation is prefixed with its size, padded to keep the block suitably aligned.
+const size_t ALLOCATION_HEADER = 16;
+
+void* Allocate(size_t size) {
+	void* block = malloc(size + ALLOCATION_HEADER);
+	if(block == NULL) {
+		return NULL;
+	}
+	*static_cast< size_t* >(block) = size;
+	gAllocatedBytes.fetch_add(static_cast< int64_t >(size), std::memory_order_relaxed);
+	return static_cast< char* >(block) + ALLOCATION_HEADER;
+}
+
+void Deallocate(void* pointer) {
+	if(pointer != NULL) {
+		void* block = static_cast< char* >(pointer) - ALLOCATION_HEADER;
+		gAllocatedBytes.fetch_sub(static_cast< int64_t >(*static_cast< size_t* >(block)), std::memory_order_relaxed);
+		free(block);
+	}
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+	void* pointer = Allocate(size);
+	if(pointer == NULL) {
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+	return Allocate(size);
+}
+
+void operator delete(void* pointer) noexcept {
+	Deallocate(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+	Deallocate(pointer);
+}
+
+namespace {
+
+const char* const PATH_NAME = "/com/twobulls/bench/suite";
+const char* const INTERFACE_NAME = "com.twobulls.bench.suite";
+const ajn::SessionPort SESSION_PORT = 1340;
+
+const char* const ABOUT_XML =
+	"<About>"
+	"<DefaultLanguage>en</DefaultLanguage>"
+	"<AppId>4b8e2f61-0c3d-4a7e-b512-6e9d0f3a8c27</AppId>"
+	"<DeviceId>00000000-0000-0000-0000-000000000002</DeviceId>"
+	"<AppName>Suite</AppName>"
+	"<Manufacturer>Two Bulls</Manufacturer>"
+	"<ModelNumber>001</ModelNumber>"
+	"<Description>Benchmark suite</Description>"
+	"<SoftwareVersion>0.0.1</SoftwareVersion>"
+	"<DeviceName>Suite</DeviceName>"
+	"</About>";
+
+struct SuiteOptions {
+	SuiteOptions() :
+		mAllJoyn(false)
+		,mIterations(10000)
+		,mThreads(4)
+		,mJson(false)
+	{};
+	bool mAllJoyn;
+	size_t mIterations;
+	size_t mThreads;
+	bool mJson;
+};
+
+// The named figures measured by one benchmark, in the order they were added.
+struct BenchResult {
+	BenchResult(const std::string& name) :
+		mName(name)
+		,mPassed(true)
+		,mMetrics()
+	{};
+	void Add(const std::string& metric, double value) { mMetrics.push_back(std::make_pair(metric, value)); };
+	std::string mName;
+	bool mPassed;
+	std::vector< std::pair< std::string, double > > mMetrics;
+};
+
+// An object with a single typed Event and a typed Action that echoes its argument.
+class BenchObject :
+	public twobulls::TBStartAllJoyn
+{
+	public:
+		BenchObject(const std::string& pathName, ajn::SessionPort port) :
+			twobulls::TBStartAllJoyn(ABOUT_XML, pathName, port, Events(), Actions())
+		{};
+
+	private:
+		static std::vector< twobulls::EventDescriptor > Events() {
+			std::vector< twobulls::EventDescriptor > events;
+			events.push_back(twobulls::TypedEventDescriptor< uint64_t >("Tick", "Throughput probe", "sent"));
+			return events;
+		};
+
+		static std::vector< twobulls::ActionDescriptor > Actions() {
+			std::vector< twobulls::ActionDescriptor > actions;
+			actions.push_back(twobulls::TypedActionDescriptor< uint32_t(uint32_t) >("Echo", "Replies with its argument", &BenchObject::HandleEcho, "value,result"));
+			return actions;
+		};
+
+		uint32_t HandleEcho(uint32_t value) {
+			return value;
+		};
+};
+
+double Percentile(const std::vector< uint64_t >& sorted, double percentile) {
+	return sorted.empty() ? 0 : sorted[std::min(sorted.size() - 1, static_cast< size_t >(percentile * sorted.size()))] / 1000.0;
+}
+
+// Adds the latency distribution of 'samples', in microseconds.
+void AddLatencies(BenchResult& result, std::vector< uint64_t >& samples) {
+	std::sort(samples.begin(), samples.end());
+	uint64_t total = 0;
+	for(size_t index = 0; index < samples.size(); ++index) {
+		total += samples[index];
+	}
+	result.Add("samples", static_cast< double >(samples.size()));
+	result.Add("mean_us", samples.empty() ? 0 : total / 1000.0 / samples.size());
+	result.Add("p50_us", Percentile(samples, 0.5));
+	result.Add("p99_us", Percentile(samples, 0.99));
+	result.Add("max_us", Percentile(samples, 1.0));
+}
+
+void AddThroughput(BenchResult& result, size_t operations, uint64_t elapsedNs) {
+	result.Add("ops_per_sec", elapsedNs > 0 ? operations * 1e9 / elapsedNs : 0);
+}
+
+// Each thread Triggers its share of the iterations as fast as it can, timing every call.
+BenchResult RunTriggerEvent(const char* name, twobulls::TBBusBackend& backend, twobulls::TBLoopbackBus* loopback, size_t iterations, size_t threadCount) {
+	BenchResult result(name);
+
+	std::atomic< uint64_t > delivered(0);
+	size_t handler = 0;
+	if(loopback != NULL) {
+		handler = loopback->AddSignalHandler([&delivered](const std::string&, const std::string&, const ajn::MsgArg*, size_t) {
+			delivered.fetch_add(1, std::memory_order_relaxed);
+		});
+	}
+
+	BenchObject object(PATH_NAME, SESSION_PORT);
+	object.SetBusBackend(&backend);
+
+	twobulls::TypedEventHandle< uint64_t > tick;
+	result.mPassed = object.Start() && object.GetEventHandle("Tick", tick);
+
+	std::vector< std::vector< uint64_t > > samples(threadCount);
+	std::atomic< size_t > failed(0);
+	std::atomic< bool > go(false);
+	std::vector< std::thread > threads;
+	for(size_t index = 0; result.mPassed && index < threadCount; ++index) {
+		std::vector< uint64_t >& threadSamples = samples[index];
+		const size_t count = iterations / threadCount + (index < iterations % threadCount ? 1 : 0);
+		threads.push_back(std::thread([&object, &tick, &go, &failed, &threadSamples, count]() {
+			threadSamples.reserve(count);
+			while(!go.load(std::memory_order_acquire)) {
+				std::this_thread::yield();
+			}
+			for(size_t iteration = 0; iteration < count; ++iteration) {
+				const uint64_t start = twobulls::MonotonicNanoseconds();
+				if(!object.TriggerEvent(tick, start)) {
+					failed.fetch_add(1, std::memory_order_relaxed);
+				}
+				threadSamples.push_back(twobulls::MonotonicNanoseconds() - start);
+			}
+		}));
+	}
+
+	const uint64_t start = twobulls::MonotonicNanoseconds();
+	go.store(true, std::memory_order_release);
+	for(size_t index = 0; index < threads.size(); ++index) {
+		threads[index].join();
+	}
+	const uint64_t elapsed = twobulls::MonotonicNanoseconds() - start;
+
+	std::vector< uint64_t > merged;
+	for(size_t index = 0; index < samples.size(); ++index) {
+		merged.insert(merged.end(), samples[index].begin(), samples[index].end());
+	}
+
+	result.Add("threads", static_cast< double >(threadCount));
+	AddThroughput(result, merged.size(), elapsed);
+	AddLatencies(result, merged);
+	result.Add("failed", static_cast< double >(failed.load()));
+	if(loopback != NULL) {
+		result.Add("delivered", static_cast< double >(delivered.load()));
+		loopback->RemoveHandler(handler);
+	}
+	result.mPassed = result.mPassed && failed.load() == 0;
+
+	object.Stop();
+	return result;
+}
+
+// Calls Echo through the loopback bus, straight into the object's dispatch.
+bool CallEchoLoopback(twobulls::TBLoopbackBus& bus, size_t iterations, std::vector< uint64_t >& samples) {
+	std::vector< ajn::MsgArg > reply;
+	bool result = true;
+	for(uint32_t index = 0; result && index < iterations; ++index) {
+		ajn::MsgArg arg;
+		twobulls::SetMsgArg(arg, index);
+		const uint64_t start = twobulls::MonotonicNanoseconds();
+		uint32_t echoed = 0;
+		result = bus.CallMethod(PATH_NAME, "Echo", &arg, 1, reply) == ER_OK && reply.size() == 1 && twobulls::GetMsgArg(reply[0], echoed) && echoed == index;
+		samples.push_back(twobulls::MonotonicNanoseconds() - start);
+	}
+	return result;
+}
+
+// Calls Echo from a BusAttachment of its own, joined to the object's session, so the figures include the router.
+bool CallEchoAllJoyn(const std::string& serviceName, size_t iterations, std::vector< uint64_t >& samples) {
+	ajn::BusAttachment bus("SuiteConsumer", true);
+	bool result = bus.Start() == ER_OK && bus.Connect() == ER_OK;
+
+	ajn::SessionId id = 0;
+	if(result) {
+		ajn::SessionOpts opts(ajn::SessionOpts::TRAFFIC_MESSAGES, true, ajn::SessionOpts::PROXIMITY_ANY, ajn::TRANSPORT_ANY);
+		result = bus.JoinSession(serviceName.c_str(), SESSION_PORT, NULL, id, opts) == ER_OK;
+	}
+
+	ajn::ProxyBusObject proxy(bus, serviceName.c_str(), PATH_NAME, id);
+	if(result) {
+		result = proxy.IntrospectRemoteObject() == ER_OK;
+	}
+
+	for(uint32_t index = 0; result && index < iterations; ++index) {
+		ajn::MsgArg arg;
+		twobulls::SetMsgArg(arg, index);
+		ajn::Message reply(bus);
+		const uint64_t start = twobulls::MonotonicNanoseconds();
+		uint32_t echoed = 0;
+		result = proxy.MethodCall(INTERFACE_NAME, "Echo", &arg, 1, reply) == ER_OK && twobulls::GetMsgArg(*reply->GetArg(0), echoed) && echoed == index;
+		samples.push_back(twobulls::MonotonicNanoseconds() - start);
+	}
+
+	bus.Stop();
+	bus.Join();
+	return result;
+}
+
+BenchResult RunActionRoundTrip(twobulls::TBBusBackend& backend, twobulls::TBLoopbackBus* loopback, size_t iterations) {
+	BenchResult result("action_roundtrip");
+
+	BenchObject object(PATH_NAME, SESSION_PORT);
+	object.SetBusBackend(&backend);
+
+	std::vector< uint64_t > samples;
+	samples.reserve(iterations);
+	const uint64_t start = twobulls::MonotonicNanoseconds();
+	result.mPassed = object.Start();
+	if(result.mPassed && loopback != NULL) {
+		result.mPassed = CallEchoLoopback(*loopback, iterations, samples);
+	} else if(result.mPassed) {
+		ajn::BusAttachment* bus = static_cast< twobulls::TBAllJoynBackend& >(backend).GetBusAttachment();
+		result.mPassed = bus != NULL && CallEchoAllJoyn(bus->GetUniqueName().c_str(), iterations, samples);
+	}
+	const uint64_t elapsed = twobulls::MonotonicNanoseconds() - start;
+
+	AddThroughput(result, samples.size(), elapsed);
+	AddLatencies(result, samples);
+
+	object.Stop();
+	return result;
+}
+
+BenchResult RunStartStop(twobulls::TBBusBackend& backend, size_t cycles) {
+	BenchResult result("start_stop");
+
+	BenchObject object(PATH_NAME, SESSION_PORT);
+	object.SetBusBackend(&backend);
+
+	std::vector< uint64_t > samples;
+	for(size_t index = 0; result.mPassed && index < cycles; ++index) {
+		const uint64_t start = twobulls::MonotonicNanoseconds();
+		result.mPassed = object.Start();
+		object.Stop();
+		samples.push_back(twobulls::MonotonicNanoseconds() - start);
+	}
+
+	AddLatencies(result, samples);
+	return result;
+}
+
+// Times the parse of the About XML that the constructor of TBStartAllJoyn does, each into a fresh description.
+BenchResult RunAboutParse(size_t iterations) {
+	BenchResult result("about_parse");
+
+	std::vector< uint64_t > samples;
+	samples.reserve(iterations);
+	for(size_t index = 0; result.mPassed && index < iterations; ++index) {
+		const uint64_t start = twobulls::MonotonicNanoseconds();
+		twobulls::TBAboutDescription description;
+		result.mPassed = description.Parse(ABOUT_XML);
+		samples.push_back(twobulls::MonotonicNanoseconds() - start);
+	}
+
+	AddLatencies(result, samples);
+	return result;
+}
+
+// The heap taken by each of 'count' objects, once constructed and again once Started, on paths and ports of their own.
+BenchResult RunMemoryPerInstance(twobulls::TBBusBackend& backend, size_t count) {
+	BenchResult result("memory_per_instance");
+
+	std::vector< std::string > paths;
+	for(size_t index = 0; index < count; ++index) {
+		paths.push_back(std::string(PATH_NAME) + "/instance" + std::to_string(index));
+	}
+
+	std::vector< BenchObject* > objects;
+	objects.reserve(count);
+
+	const int64_t baseline = gAllocatedBytes.load();
+	for(size_t index = 0; index < count; ++index) {
+		objects.push_back(new BenchObject(paths[index], static_cast< ajn::SessionPort >(SESSION_PORT + 1 + index)));
+		objects.back()->SetBusBackend(&backend);
+	}
+	const int64_t constructed = gAllocatedBytes.load();
+	for(size_t index = 0; result.mPassed && index < count; ++index) {
+		result.mPassed = objects[index]->Start();
+	}
+	const int64_t started = gAllocatedBytes.load();
+
+	for(size_t index = 0; index < count; ++index) {
+		objects[index]->Stop();
+		delete objects[index];
+	}
+
+	result.Add("instances", static_cast< double >(count));
+	result.Add("constructed_bytes", count > 0 ? static_cast< double >(constructed - baseline) / count : 0);
+	result.Add("started_bytes", count > 0 ? static_cast< double >(started - baseline) / count : 0);
+	return result;
+}
+
+void PrintText(const std::vector< BenchResult >& results) {
+	for(size_t index = 0; index < results.size(); ++index) {
+		const BenchResult& result = results[index];
+		printf("%-22s %-4s", result.mName.c_str(), result.mPassed ? "ok" : "FAIL");
+		for(size_t metric = 0; metric < result.mMetrics.size(); ++metric) {
+			printf("  %s %.1f", result.mMetrics[metric].first.c_str(), result.mMetrics[metric].second);
+		}
+		printf("\n");
+	}
+}
+
+void PrintJson(const SuiteOptions& options, const std::vector< BenchResult >& results) {
+	printf("{\"suite\":\"TBStartAllJoyn\",\"bus\":\"%s\",\"iterations\":%u,\"threads\":%u,\"results\":[",
+		options.mAllJoyn ? "alljoyn" : "loopback", static_cast< unsigned int >(options.mIterations), static_cast< unsigned int >(options.mThreads));
+	for(size_t index = 0; index < results.size(); ++index) {
+		const BenchResult& result = results[index];
+		printf("%s{\"name\":\"%s\",\"passed\":%s,\"metrics\":{", index > 0 ? "," : "", result.mName.c_str(), result.mPassed ? "true" : "false");
+		for(size_t metric = 0; metric < result.mMetrics.size(); ++metric) {
+			printf("%s\"%s\":%.3f", metric > 0 ? "," : "", result.mMetrics[metric].first.c_str(), result.mMetrics[metric].second);
+		}
+		printf("}}");
+	}
+	printf("]}\n");
+}
+
+bool ParseOptions(int argc, char** argv, SuiteOptions& options) {
+	for(int index = 1; index < argc; ++index) {
+		const bool hasValue = index + 1 < argc;
+		if(strcmp(argv[index], "--bus") == 0 && hasValue) {
+			const char* bus = argv[++index];
+			if(strcmp(bus, "alljoyn") != 0 && strcmp(bus, "loopback") != 0) {
+				return false;
+			}
+			options.mAllJoyn = strcmp(bus, "alljoyn") == 0;
+		} else if(strcmp(argv[index], "--iterations") == 0 && hasValue) {
+			options.mIterations = static_cast< size_t >(atoi(argv[++index]));
+		} else if(strcmp(argv[index], "--threads") == 0 && hasValue) {
+			options.mThreads = static_cast< size_t >(atoi(argv[++index]));
+		} else if(strcmp(argv[index], "--json") == 0) {
+			options.mJson = true;
+		} else {
+			return false;
+		}
+	}
+	return options.mIterations > 0 && options.mThreads > 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	SuiteOptions options;
+	if(!ParseOptions(argc, argv, options)) {
+		fprintf(stderr, "Usage: %s [--bus loopback|alljoyn] [--iterations N] [--threads N] [--json]\n", argv[0]);
+		return 2;
+	}
+
+	twobulls::TBLoopbackBus* loopback = options.mAllJoyn ? NULL : new twobulls::TBLoopbackBus();
+	twobulls::TBBusBackend* backend = loopback != NULL ? static_cast< twobulls::TBBusBackend* >(loopback) : new twobulls::TBAllJoynBackend();
+
+	// Start/Stop and the router round trips are orders of magnitude slower than the rest, so they run fewer times
+	const size_t cycles = std::max< size_t >(1, options.mIterations / (options.mAllJoyn ? 1000 : 100));
+	const size_t calls = options.mAllJoyn ? std::max< size_t >(1, options.mIterations / 10) : options.mIterations;
+
+	std::vector< BenchResult > results;
+	results.push_back(RunTriggerEvent("trigger_event_single", *backend, loopback, options.mIterations, 1));
+	results.push_back(RunTriggerEvent("trigger_event_multi", *backend, loopback, options.mIterations, options.mThreads));
+	results.push_back(RunActionRoundTrip(*backend, loopback, calls));
+	results.push_back(RunStartStop(*backend, cycles));
+	results.push_back(RunAboutParse(options.mIterations));
+	results.push_back(RunMemoryPerInstance(*backend, std::min< size_t >(cycles, 16)));
+
+	delete backend;
+
+	if(options.mJson) {
+		PrintJson(options, results);
+	} else {
+		PrintText(results);
+	}
+
+	bool passed = true;
+	for(size_t index = 0; index < results.size(); ++index) {
+		passed = passed && results[index].mPassed;
+	}
+	return passed ? 0 : 1;
+}
@@ -25,30 +25,6 @@
 #include <iostream>
 #include <sstream>
 
-// Here we inherit from TBStartAllJoyn because we specifically want to implement an Action handler for our "Press" Action.
-//	If we didn't have any Actions to handle, then we could instead just create an instance of twobulls::TBStartAllJoyn directly.
-class Triggns : 
-	public twobulls::TBStartAllJoyn 
-{
-	public:
-		// Essentially a passthrough constructor in this case.
-		Triggns(const std::string& aboutXML, const std::string& pathName, const ajn::SessionPort port, 
-				const std::vector< twobulls::EventDescriptor >& events = std::vector< twobulls::EventDescriptor >(), 
-				const std::vector< twobulls::ActionDescriptor >& actions = std::vector< twobulls::ActionDescriptor >()) :
-			twobulls::TBStartAllJoyn(aboutXML, pathName, port, events, actions)
-		{};
-
-		// Our Action handler which we register for the "Press" Action we define further down. In this particular case we actually
-		//  use the "Press" Action to Trigger the "Pressed" Event. However we could just as easily do something different like;
-		//	turn on a device light, or emit a sound, or some other device specific functionality.
-		void HandleAction(const ajn::InterfaceDescription::Member* member, ajn::Message& message) {
-			printf("Triggns::HandleAction -- %s was called.\n", member->name.c_str());
-
-			// Here we are Triggering the "Pressed" Event we define further down.
-			TriggerEvent("Pressed");
-		}
-};
-
 int main(int argc, char** argv)
 {
 	// Set AllJoyn logging; can be useful if things aren't working as expected
@@ -83,24 +59,57 @@ int main(int argc, char** argv)
 			<< "</About>";
 
 	// Add a Pressed event that is generated whenever twobulls::TBStartAllJoyn::TriggerEvent("Pressed") is called
-	// The alljoyn implementation will generate a sessionless signal
+	// The alljoyn implementation will generate a sessionless signal. A physical button bounces, so Presses that follow
+	// within 50ms of an emitted one are suppressed rather than each becoming a signal on the network
 	std::vector< twobulls::EventDescriptor > events;
-	events.push_back(twobulls::EventDescriptor("Pressed", "Button Pressed"));
+	events.push_back(twobulls::EventDescriptor("Pressed", "Button Pressed", twobulls::EmissionPolicy::MinInterval(50)));
 
-	// Add a Press action that may be called from clients, the assigned handler method of the inheriting class
-	// instance will be called as a result 
-	std::vector< twobulls::ActionDescriptor > actions;
-	actions.push_back(twobulls::ActionDescriptor("Press", "Press the button", static_cast<ajn::MessageReceiver::MethodHandler>(&Triggns::HandleAction)));
+	// The Action handlers below are lambdas, so there's no need to inherit from TBStartAllJoyn to handle them. They are
+	// made before the BusObject is, so they reach it through this pointer
+	twobulls::TBStartAllJoyn* object = NULL;
 
-	// Use customized TBStartAllJoyn to take care of boilerplate and setup a BusObject on a BusAttachment
+	// Add a Press action that may be called from clients. In this particular case we use it to Trigger the "Pressed"
+	// Event, however we could just as easily do something different like; turn on a device light, or emit a sound, or
+	// some other device specific functionality.
+	std::vector< twobulls::ActionDescriptor > actions;
+	actions.push_back(twobulls::TypedActionDescriptor< void() >("Press", "Press the button", [&object]() {
+		printf("Press was called.\n");
+		object->TriggerEvent("Pressed");
+	}));
+
+	// Add a Ping action that takes some text and replies with its length. The signatures of the method are worked out
+	// from the handler type, the argument is unpacked from the message for us, and the value we return becomes the reply
+	// to the caller. The StringView borrows the text from the message rather than copying it
+	actions.push_back(twobulls::TypedActionDescriptor< uint32_t(twobulls::StringView) >("Ping", "Reply with the length of some text", [](twobulls::StringView text) {
+		printf("Ping -- %.*s\n", static_cast< int >(text.mLength), text.mData);
+		return static_cast< uint32_t >(text.mLength);
+	}, "text,length"));
+
+	// Add a PressCount property that clients can read at any time, and are told about as it changes
+	std::vector< twobulls::PropertyDescriptor > properties;
+	properties.push_back(twobulls::TypedPropertyDescriptor< uint32_t >("PressCount", "Number of times the button was pressed"));
+
+	// Use TBStartAllJoyn to take care of boilerplate and setup a BusObject on a BusAttachment
 	// running on its own Router (aka Daemon) with included functionality
-	Triggns busObject(
+	twobulls::TBStartAllJoyn busObject(
 		aboutXML.str()
 		,"/com/twobulls/triggns/higgnsbutton"
 		,1337
 		,events
 		,actions
+		,properties
 	);
+	object = &busObject;
+
+	// Keep the last 32 Presses, so that a client joining late can ask what it missed with GetEventsSince
+	busObject.SetEventHistoryOptions(twobulls::EventHistoryOptions(32));
+
+	// Let clients read how the device is doing, eg. how many Presses there have been and how long Actions take
+	busObject.SetMetricsProperty(true);
+
+	const twobulls::PropertyHandle pressCount = busObject.GetPropertyHandle("PressCount");
+	uint32_t presses = 0;
+	busObject.SetProperty(pressCount, presses);
 
 	// Kick off the BusObject, this does all the required AllJoyn initialization and boilerplate to get the
 	// About service advertising the provided description along with similarly described events and actions
@@ -109,13 +118,17 @@ int main(int argc, char** argv)
 	if(started) {
 
 #if defined(INTERACTIVE)
+		// Looking up the EventHandle once saves a name lookup every time the Event is Triggered
+		const twobulls::EventHandle pressed = busObject.GetEventHandle("Pressed");
+
 		std::cout << std::endl << "Press Enter to Trigger the 'Pressed' event. CTRL+BREAK to exit." << std::endl << std::endl;
 		while (std::cin.ignore()) {
 			
 			// Whenever the user presses Enter, we Trigger the "Pressed" Event. We could also Trigger any other kind
 			// of Event eg. "Alarm", "FinishedTask", "MotionDetected", "DoorOpened", "TemperatureReached" etc. that
 			// makes sense for the device running this code.
-			busObject.TriggerEvent("Pressed");
+			busObject.TriggerEvent(pressed);
+			busObject.SetProperty(pressCount, ++presses);
 		}
 #else
 		bool running = true;